@@ -55,14 +55,30 @@ SOURCES += \
     Box2D/Dynamics/b2World.cpp \
     Box2D/Dynamics/b2WorldCallbacks.cpp \
     Box2D/Rope/b2Rope.cpp \
+    bus.cpp \
+    cellgrid.cpp \
     confettieffect.cpp \
+    cycledetector.cpp \
     gate.cpp \
+    gatekernels.cpp \
+    generator.cpp \
+    journal.cpp \
     level.cpp \
+    levelpack.cpp \
     main.cpp \
     mainwindow.cpp \
+    netlist.cpp \
     node.cpp \
-    obstacle.cpp \
-    wire.cpp
+    obstaclelayer.cpp \
+    propagator.cpp \
+    router.cpp \
+    simulator.cpp \
+    solver.cpp \
+    spriteatlas.cpp \
+    tag.cpp \
+    tilerasterizer.cpp \
+    wire.cpp \
+    wirepool.cpp
 
 HEADERS += \
     Box2D/Box2D.h \
@@ -112,14 +128,30 @@ HEADERS += \
     Box2D/Dynamics/b2World.h \
     Box2D/Dynamics/b2WorldCallbacks.h \
     Box2D/Rope/b2Rope.h \
+    bus.h \
+    cellgrid.h \
     confettieffect.h \
     confettieffect.h \
+    cycledetector.h \
     gate.h \
+    gatekernels.h \
+    generator.h \
+    journal.h \
     level.h \
+    levelpack.h \
     mainwindow.h \
+    netlist.h \
     node.h \
-    obstacle.h \
-    wire.h
+    obstaclelayer.h \
+    propagator.h \
+    router.h \
+    simulator.h \
+    solver.h \
+    spriteatlas.h \
+    tag.h \
+    tilerasterizer.h \
+    wire.h \
+    wirepool.h
 
 FORMS += \
     mainwindow.ui
@@ -137,4 +169,5 @@ DISTFILES += \
 
 RESOURCES += \
     fonts.qrc \
-    images.qrc
+    images.qrc \
+    levels.qrc
@@ -0,0 +1,160 @@
+#include "bus.h"
+#ifdef BUS_AVX2
+#include <immintrin.h>
+#endif
+
+Bus Bus::filled(int width, bool value) {
+    Bus result;
+    width = qBound(1, width, int(MAX_WIDTH));
+    if (width <= INLINE_WIDTH)
+        return inlineBus(width, value ? laneMask(width, 0) : 0);
+    quint64* words = result.allocate(width);
+    if (value) {
+        for (int i = 0; i < WORDS; i++)
+            words[i] = laneMask(width, i);
+    }
+    return result;
+}
+
+Bus Bus::fromWords(int width, const quint64* source) {
+    Bus result;
+    width = qBound(1, width, int(MAX_WIDTH));
+    if (width <= INLINE_WIDTH)
+        return inlineBus(width, source[0] & laneMask(width, 0));
+    quint64* words = result.allocate(width);
+    for (int i = 0; i * 64 < width; i++)
+        words[i] = source[i] & laneMask(width, i);
+    return result;
+}
+
+QString Bus::toString() const {
+    if (width == 1)
+        return word ? "1" : "0";
+    QString digits;
+    for (int nibble = (width - 1) / 4; nibble >= 0; nibble--) {
+        int value = int(getWord(nibble / 16) >> (nibble % 16 * 4)) & 0xf;
+        digits.append(QChar("0123456789abcdef"[value]));
+    }
+    return QString::number(width) + "'h" + digits;
+}
+
+quint64* Bus::allocate(int width) {
+    block = new Block{{1}, {}};
+    this->width = width;
+    return block->words;
+}
+
+quint64* Bus::detach() {
+    if (block->references == 1)
+        return block->words;
+    Block* copy = new Block{{1}, {}};
+    for (int i = 0; i < WORDS; i++)
+        copy->words[i] = block->words[i];
+    release();
+    block = copy;
+    return block->words;
+}
+
+const quint64* Bus::spill(quint64 (&scratch)[WORDS]) const {
+    if (isWide())
+        return block->words;
+    scratch[0] = word;
+    for (int i = 1; i < WORDS; i++)
+        scratch[i] = 0;
+    return scratch;
+}
+
+Bus Bus::combine(const Bus& other, Operation operation) const {
+    quint64 firstScratch[WORDS];
+    quint64 secondScratch[WORDS];
+    const quint64* first = spill(firstScratch);
+    const quint64* second = other.spill(secondScratch);
+    Bus result;
+    quint64* words = result.allocate(qMax(width, other.width));
+#ifdef BUS_AVX2
+    if (hasAvx2())
+        combineAvx2(first, second, words, operation);
+    else
+#endif
+    for (int i = 0; i < WORDS; i++) {
+        switch (operation) {
+        case Operation::AND:
+            words[i] = first[i] & second[i];
+            break;
+        case Operation::OR:
+            words[i] = first[i] | second[i];
+            break;
+        case Operation::XOR:
+            words[i] = first[i] ^ second[i];
+            break;
+        case Operation::NOT:
+            words[i] = ~first[i];
+            break;
+        }
+    }
+    if (operation == Operation::NOT) {
+        for (int i = 0; i < WORDS; i++)
+            words[i] &= laneMask(result.width, i);
+    }
+    return result;
+}
+
+bool Bus::equalWords(const quint64* first, const quint64* second) {
+#ifdef BUS_AVX2
+    if (hasAvx2())
+        return equalWordsAvx2(first, second);
+#endif
+    quint64 difference = 0;
+    for (int i = 0; i < WORDS; i++)
+        difference |= first[i] ^ second[i];
+    return difference == 0;
+}
+
+#ifdef BUS_AVX2
+namespace {
+
+__attribute__((target("avx2")))
+inline __m256i load(const quint64* source) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+}
+
+__attribute__((target("avx2")))
+inline void store(quint64* target, __m256i value) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(target), value);
+}
+
+}
+
+bool Bus::hasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+void Bus::combineAvx2(const quint64* first, const quint64* second, quint64* words,
+                      Operation operation) {
+    for (int i = 0; i < WORDS; i += 4) {
+        switch (operation) {
+        case Operation::AND:
+            store(words + i, _mm256_and_si256(load(first + i), load(second + i)));
+            break;
+        case Operation::OR:
+            store(words + i, _mm256_or_si256(load(first + i), load(second + i)));
+            break;
+        case Operation::XOR:
+            store(words + i, _mm256_xor_si256(load(first + i), load(second + i)));
+            break;
+        case Operation::NOT:
+            store(words + i, _mm256_xor_si256(load(first + i), _mm256_set1_epi64x(-1)));
+            break;
+        }
+    }
+}
+
+bool Bus::equalWordsAvx2(const quint64* first, const quint64* second) {
+    __m256i difference = _mm256_setzero_si256();
+    for (int i = 0; i < WORDS; i += 4)
+        difference = _mm256_or_si256(difference,
+                                     _mm256_xor_si256(load(first + i), load(second + i)));
+    return _mm256_testz_si256(difference, difference);
+}
+#endif
@@ -0,0 +1,385 @@
+/**
+ * This class represents the value a wire carries: a bus of 1 to 512
+ * lanes, one bit each. Ordinary wires are one lane wide, and a bool
+ * converts to a one-lane bus, so single-bit circuits read as before.
+ * A bus of up to 64 lanes keeps them in one inline word, so wires, gates
+ * and undo entries stay small. Wider buses keep their words in a shared
+ * block that is copied only when a lane of a shared bus changes, and
+ * gates combine those lane by lane. On x86 builds with GCC or Clang the
+ * wide operations are also compiled for AVX2 and take that path whenever
+ * the CPU running the game supports it, so no build flag is needed.
+ * Lanes at or above the width are always kept clear, so two buses are
+ * equal exactly when their widths and words match.
+ *
+ * @authors Max Donaldson, Jason Khong,
+ * Ariadne Petroulakis, Evan Tucker, and Ian Weller
+ *
+ * @version 22 April 2025
+ */
+
+#ifndef BUS_H
+#define BUS_H
+
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <utility>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define BUS_AVX2
+#endif
+
+class Bus {
+
+public:
+    /**
+     * @brief MAX_WIDTH - The most lanes a bus can have.
+     */
+    static const int MAX_WIDTH = 512;
+
+    /**
+     * @brief WORDS - The number of 64-bit words holding the lanes of the widest bus.
+     */
+    static const int WORDS = MAX_WIDTH / 64;
+
+    /**
+     * @brief INLINE_WIDTH - The most lanes a bus keeps inline, without a shared block.
+     */
+    static const int INLINE_WIDTH = 64;
+
+    /**
+     * @brief Bus - Creates a one-lane bus carrying false.
+     */
+    Bus() : word(0), width(1) {}
+
+    /**
+     * @brief Bus - Creates a one-lane bus. Lets a bool stand in for a bus.
+     * @param value - The signal of the lane.
+     */
+    Bus(bool value) : word(value), width(1) {}
+
+    /**
+     * @brief Bus - Copy constructor. A wide bus shares the other's block.
+     * @param other - The bus to copy.
+     */
+    Bus(const Bus& other) : word(other.word), width(other.width) {
+        if (isWide())
+            block->references++;
+    }
+
+    /**
+     * @brief Bus - Move constructor. Leaves the other bus one lane wide.
+     * @param other - The bus to move from.
+     */
+    Bus(Bus&& other) noexcept : word(other.word), width(other.width) {
+        other.word = 0;
+        other.width = 1;
+    }
+
+    /**
+     * Destructor for the Bus class. Frees a block no other bus shares.
+     */
+    ~Bus() {
+        release();
+    }
+
+    /**
+     * @brief operator= - Copy and move assignment.
+     * @param other - The bus to take the lanes of.
+     * @return This bus.
+     */
+    Bus& operator=(Bus other) noexcept {
+        std::swap(word, other.word);
+        std::swap(width, other.width);
+        return *this;
+    }
+
+    /**
+     * @brief filled - Creates a bus with every lane set to the same value.
+     * @param width - The number of lanes, from 1 to MAX_WIDTH.
+     * @param value - The signal of every lane.
+     * @return The bus.
+     */
+    static Bus filled(int width, bool value);
+
+    /**
+     * @brief fromWords - Creates a bus from packed lanes. Lane i is bit i % 64 of word i / 64.
+     * @param width - The number of lanes, from 1 to MAX_WIDTH.
+     * @param source - The words holding the lanes. Only the words the width covers are read.
+     * @return The bus.
+     */
+    static Bus fromWords(int width, const quint64* source);
+
+    /**
+     * @brief getWidth - Getter for the number of lanes.
+     * @return The width.
+     */
+    int getWidth() const {
+        return width;
+    }
+
+    /**
+     * @brief getBit - Gets the signal of one lane.
+     * @param lane - The lane index. Lanes past the width read as false.
+     * @return The signal.
+     */
+    bool getBit(int lane) const {
+        return lane >= 0 && lane < width && (getWord(lane / 64) >> (lane % 64)) & 1;
+    }
+
+    /**
+     * @brief setBit - Sets the signal of one lane. A shared block is copied first.
+     * @param lane - The lane index. Lanes past the width are ignored.
+     * @param value - The signal.
+     */
+    void setBit(int lane, bool value) {
+        if (lane < 0 || lane >= width)
+            return;
+        quint64 mask = quint64(1) << (lane % 64);
+        quint64& target = isWide() ? detach()[lane / 64] : word;
+        target = value ? target | mask : target & ~mask;
+    }
+
+    /**
+     * @brief getWord - Getter for one word of the lanes.
+     * @param index - The word index, below WORDS.
+     * @return The lanes of the word.
+     */
+    quint64 getWord(int index) const {
+        if (isWide())
+            return block->words[index];
+        return index == 0 ? word : 0;
+    }
+
+    /**
+     * @brief isHigh - Checks whether any lane is set. This is how a bus is drawn.
+     * @return True if some lane carries true.
+     */
+    bool isHigh() const {
+        if (!isWide())
+            return word != 0;
+        quint64 any = 0;
+        for (int i = 0; i < WORDS; i++)
+            any |= block->words[i];
+        return any != 0;
+    }
+
+    /**
+     * @brief toString - Builds a display string: "1" or "0" for one lane, otherwise the width
+     * and the lanes in hexadecimal, highest first, e.g. "8'h3c".
+     * @return The display string.
+     */
+    QString toString() const;
+
+    /**
+     * @brief operator& - Lane-wise AND. A narrower bus reads as false in its missing lanes.
+     * @param other - The other bus.
+     * @return A bus as wide as the wider of the two.
+     */
+    Bus operator&(const Bus& other) const {
+        if (qMax(width, other.width) <= INLINE_WIDTH)
+            return inlineBus(qMax(width, other.width), word & other.word);
+        return combine(other, Operation::AND);
+    }
+
+    /**
+     * @brief operator| - Lane-wise OR. A narrower bus reads as false in its missing lanes.
+     * @param other - The other bus.
+     * @return A bus as wide as the wider of the two.
+     */
+    Bus operator|(const Bus& other) const {
+        if (qMax(width, other.width) <= INLINE_WIDTH)
+            return inlineBus(qMax(width, other.width), word | other.word);
+        return combine(other, Operation::OR);
+    }
+
+    /**
+     * @brief operator^ - Lane-wise XOR. A narrower bus reads as false in its missing lanes.
+     * @param other - The other bus.
+     * @return A bus as wide as the wider of the two.
+     */
+    Bus operator^(const Bus& other) const {
+        if (qMax(width, other.width) <= INLINE_WIDTH)
+            return inlineBus(qMax(width, other.width), word ^ other.word);
+        return combine(other, Operation::XOR);
+    }
+
+    /**
+     * @brief operator~ - Lane-wise NOT.
+     * @return A bus of the same width.
+     */
+    Bus operator~() const {
+        if (!isWide())
+            return inlineBus(width, ~word & laneMask(width, 0));
+        return combine(*this, Operation::NOT);
+    }
+
+    /**
+     * @brief operator== - Compares whole buses. Buses of different widths are never equal.
+     * @param other - The other bus.
+     * @return True if the widths and every lane match.
+     */
+    bool operator==(const Bus& other) const {
+        if (width != other.width)
+            return false;
+        if (!isWide())
+            return word == other.word;
+        return block == other.block || equalWords(block->words, other.block->words);
+    }
+
+    /**
+     * @brief operator!= - Compares whole buses.
+     * @param other - The other bus.
+     * @return True if the widths or some lane differ.
+     */
+    bool operator!=(const Bus& other) const {
+        return !(*this == other);
+    }
+
+#ifdef BUS_AVX2
+    /**
+     * @brief hasAvx2 - Checks once whether the CPU running the game supports AVX2.
+     * @return True if the AVX2 paths can run.
+     */
+    static bool hasAvx2();
+#endif
+
+private:
+    /**
+     * @brief The Block struct - The words of a bus wider than INLINE_WIDTH, shared between
+     * copies. Words and bits past the width are zero.
+     */
+    struct Block {
+        std::atomic<int> references;
+        quint64 words[WORDS];
+    };
+
+    /**
+     * @brief The Operation enum - The lane-wise operations combine applies.
+     */
+    enum class Operation {
+        AND, OR, XOR, NOT
+    };
+
+    union {
+        /**
+         * @brief word - The lanes of a bus up to INLINE_WIDTH wide. Bits past the width are
+         * zero.
+         */
+        quint64 word;
+
+        /**
+         * @brief block - The lanes of a wider bus.
+         */
+        Block* block;
+    };
+
+    /**
+     * @brief width - The number of lanes.
+     */
+    int width;
+
+    /**
+     * @brief isWide - Checks whether the lanes are kept in a block.
+     * @return True if the bus is wider than INLINE_WIDTH.
+     */
+    bool isWide() const {
+        return width > INLINE_WIDTH;
+    }
+
+    /**
+     * @brief inlineBus - Creates a bus of up to INLINE_WIDTH lanes.
+     * @param width - The number of lanes.
+     * @param word - The lanes, already masked to the width.
+     * @return The bus.
+     */
+    static Bus inlineBus(int width, quint64 word) {
+        Bus result;
+        result.word = word;
+        result.width = width;
+        return result;
+    }
+
+    /**
+     * @brief laneMask - Gets the bits of a word that hold lanes within a width.
+     * @param width - The number of lanes.
+     * @param index - The word index.
+     * @return The mask.
+     */
+    static quint64 laneMask(int width, int index) {
+        int lanes = width - index * 64;
+        if (lanes >= 64)
+            return ~quint64(0);
+        return lanes <= 0 ? 0 : (quint64(1) << lanes) - 1;
+    }
+
+    /**
+     * @brief allocate - Gives this bus a fresh block of zero words. Only for a bus that holds
+     * no block yet.
+     * @param width - The number of lanes, above INLINE_WIDTH.
+     * @return The words of the block.
+     */
+    quint64* allocate(int width);
+
+    /**
+     * @brief detach - Copies the block if another bus shares it, so its words can change.
+     * @return The words of the block.
+     */
+    quint64* detach();
+
+    /**
+     * @brief release - Drops this bus's reference to its block, if any, freeing the block
+     * once no bus shares it.
+     */
+    void release() {
+        if (isWide() && --block->references == 0)
+            delete block;
+    }
+
+    /**
+     * @brief spill - Gets all WORDS words of the lanes, wide or not.
+     * @param scratch - Holds the words of an inline bus.
+     * @return The words.
+     */
+    const quint64* spill(quint64 (&scratch)[WORDS]) const;
+
+    /**
+     * @brief combine - Applies a lane-wise operation to buses of which at least one is wide.
+     * @param other - The other bus. Ignored for NOT.
+     * @param operation - The operation.
+     * @return A bus as wide as the wider of the two.
+     */
+    Bus combine(const Bus& other, Operation operation) const;
+
+    /**
+     * @brief equalWords - Compares the WORDS words of two blocks.
+     * @param first - The words of one block.
+     * @param second - The words of the other.
+     * @return True if every word matches.
+     */
+    static bool equalWords(const quint64* first, const quint64* second);
+
+#ifdef BUS_AVX2
+    /**
+     * @brief combineAvx2 - The AVX2 path of combine, over all WORDS words.
+     * @param first - The words of one bus.
+     * @param second - The words of the other. Ignored for NOT.
+     * @param words - Receives the result.
+     * @param operation - The operation.
+     */
+    __attribute__((target("avx2")))
+    static void combineAvx2(const quint64* first, const quint64* second, quint64* words,
+                            Operation operation);
+
+    /**
+     * @brief equalWordsAvx2 - The AVX2 path of equalWords.
+     * @param first - The words of one block.
+     * @param second - The words of the other.
+     * @return True if every word matches.
+     */
+    __attribute__((target("avx2")))
+    static bool equalWordsAvx2(const quint64* first, const quint64* second);
+#endif
+};
+
+#endif // BUS_H
@@ -0,0 +1,125 @@
+#include "cellgrid.h"
+
+CellGrid::CellGrid(int width, int height)
+    : width(0), height(0), chunksX(0) {
+    resize(width, height);
+}
+
+CellGrid::~CellGrid() {
+    clear();
+}
+
+int CellGrid::getWidth() const {
+    return width;
+}
+
+int CellGrid::getHeight() const {
+    return height;
+}
+
+bool CellGrid::contains(int x, int y) const {
+    return x >= 0 && x < width && y >= 0 && y < height;
+}
+
+CellGrid::Cell CellGrid::at(int x, int y) const {
+    if (!contains(x, y))
+        return {Component::NONE, 0};
+    return stored(x + 1, y + 1);
+}
+
+void CellGrid::neighbors(int x, int y, Cell around[4]) const {
+    if (!contains(x, y)) {
+        for (int i = 0; i < 4; i++)
+            around[i] = at(x + NEIGHBOR_X[i], y + NEIGHBOR_Y[i]);
+        return;
+    }
+
+    // Away from a chunk's edge, all four neighbors share its chunk.
+    int storedX = x + 1;
+    int storedY = y + 1;
+    int cellX = storedX % CHUNK_SIZE;
+    int cellY = storedY % CHUNK_SIZE;
+    if (cellX > 0 && cellX < CHUNK_SIZE - 1 && cellY > 0 && cellY < CHUNK_SIZE - 1) {
+        const Chunk* chunk = directory[(storedY / CHUNK_SIZE) * chunksX + storedX / CHUNK_SIZE];
+        int cell = cellY * CHUNK_SIZE + cellX;
+        for (int i = 0; i < 4; i++)
+            around[i] = chunk ? chunk->cells[cell + NEIGHBOR_OFFSETS[i]] : Cell{Component::NONE, 0};
+        return;
+    }
+
+    // Otherwise the border keeps every neighbor in storage.
+    for (int i = 0; i < 4; i++)
+        around[i] = stored(storedX + NEIGHBOR_X[i], storedY + NEIGHBOR_Y[i]);
+}
+
+CellGrid::Cell CellGrid::stored(int storedX, int storedY) const {
+    const Chunk* chunk = directory[(storedY / CHUNK_SIZE) * chunksX + storedX / CHUNK_SIZE];
+    if (chunk == nullptr)
+        return {Component::NONE, 0};
+    return chunk->cells[(storedY % CHUNK_SIZE) * CHUNK_SIZE + storedX % CHUNK_SIZE];
+}
+
+void CellGrid::set(int x, int y, Cell cell) {
+    if (!contains(x, y))
+        return;
+
+    // Squares are stored one cell in, past the border.
+    x++;
+    y++;
+    int directoryIndex = (y / CHUNK_SIZE) * chunksX + x / CHUNK_SIZE;
+    Chunk* chunk = directory[directoryIndex];
+
+    // Nothing to allocate for an empty cell in an empty chunk.
+    if (chunk == nullptr) {
+        if (cell.kind == Component::NONE)
+            return;
+        chunk = new Chunk();
+        chunk->slot = allocated.size();
+        directory[directoryIndex] = chunk;
+        allocated.append(directoryIndex);
+    }
+
+    Cell& target = chunk->cells[(y % CHUNK_SIZE) * CHUNK_SIZE + x % CHUNK_SIZE];
+    if (target.kind == Component::NONE && cell.kind != Component::NONE)
+        chunk->occupied++;
+    else if (target.kind != Component::NONE && cell.kind == Component::NONE)
+        chunk->occupied--;
+    target = cell;
+
+    if (chunk->occupied == 0)
+        freeChunk(directoryIndex);
+}
+
+void CellGrid::freeChunk(int directoryIndex) {
+    Chunk* chunk = directory[directoryIndex];
+
+    // Swap the last allocated entry into this chunk's slot.
+    int movedIndex = allocated.last();
+    allocated[chunk->slot] = movedIndex;
+    directory[movedIndex]->slot = chunk->slot;
+    allocated.removeLast();
+
+    directory[directoryIndex] = nullptr;
+    delete chunk;
+}
+
+void CellGrid::clear() {
+    for (int directoryIndex : allocated) {
+        delete directory[directoryIndex];
+        directory[directoryIndex] = nullptr;
+    }
+    allocated.clear();
+}
+
+void CellGrid::resize(int width, int height) {
+    clear();
+    this->width = width;
+    this->height = height;
+    chunksX = (width + 2 + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    int chunksY = (height + 2 + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    directory.fill(nullptr, chunksX * chunksY);
+}
+
+int CellGrid::getAllocatedChunks() const {
+    return allocated.size();
+}
@@ -0,0 +1,192 @@
+/**
+ * This class stores the squares of a level board. The board is split
+ * into square chunks that are only allocated once something is placed
+ * in them, so memory follows the occupied area rather than the board area.
+ * The board is stored with a one-cell empty border around it, so the four
+ * neighbors of any board square can be read without bounds checks.
+ *
+ * @authors Max Donaldson, Jason Khong,
+ * Ariadne Petroulakis, Evan Tucker, and Ian Weller
+ *
+ * @version 22 April 2025
+ */
+
+#ifndef CELLGRID_H
+#define CELLGRID_H
+
+#include <QVector>
+
+class CellGrid {
+
+public:
+    /**
+     * @brief The Component enum - The kind of grid component stored in a single cell
+     * of the board. NONE marks an empty space.
+     */
+    enum class Component : quint8 {
+        NONE, WIRE, GATE, NODE, OBSTACLE
+    };
+
+    /**
+     * @brief The Cell struct - A single square of the board. Holds the kind of component in
+     * the square and the index of that component in the owner's dense storage list.
+     */
+    struct Cell {
+        Component kind;
+        quint32 index;
+    };
+
+    /**
+     * @brief CHUNK_SIZE - The width and height of a chunk, in cells.
+     */
+    static const int CHUNK_SIZE = 32;
+
+    /**
+     * @brief NEIGHBOR_X - The x offset of each neighbor, in north, east, south, west order.
+     */
+    static constexpr int NEIGHBOR_X[4] = {0, 1, 0, -1};
+
+    /**
+     * @brief NEIGHBOR_Y - The y offset of each neighbor, in north, east, south, west order.
+     */
+    static constexpr int NEIGHBOR_Y[4] = {-1, 0, 1, 0};
+
+    /**
+     * @brief NEIGHBOR_OFFSETS - The offset of each neighbor within a chunk's cells, in north,
+     * east, south, west order.
+     */
+    static constexpr int NEIGHBOR_OFFSETS[4] = {-CHUNK_SIZE, 1, CHUNK_SIZE, -1};
+
+    /**
+     * @brief CellGrid - Creates an empty board. No chunks are allocated.
+     * @param width - The width of the board, in cells.
+     * @param height - The height of the board, in cells.
+     */
+    CellGrid(int width, int height);
+
+    /**
+     * Destructor for the CellGrid class.
+     */
+    ~CellGrid();
+
+    CellGrid(const CellGrid&) = delete;
+    CellGrid& operator=(const CellGrid&) = delete;
+
+    /**
+     * @brief getWidth - Getter for the board width.
+     * @return The width of the board, in cells.
+     */
+    int getWidth() const;
+
+    /**
+     * @brief getHeight - Getter for the board height.
+     * @return The height of the board, in cells.
+     */
+    int getHeight() const;
+
+    /**
+     * @brief contains - Checks whether a position lies on the board.
+     * @param x - X position on the grid.
+     * @param y - Y position on the grid.
+     * @return True if the position is on the board.
+     */
+    bool contains(int x, int y) const;
+
+    /**
+     * @brief at - Gets the cell at the x and y position.
+     * @param x - X position on the grid.
+     * @param y - Y position on the grid.
+     * @return The cell in question. Out of bounds positions and squares in unallocated
+     * chunks read as an empty cell.
+     */
+    Cell at(int x, int y) const;
+
+    /**
+     * @brief neighbors - Gets the four cells around the x and y position.
+     * @param x - X position on the grid.
+     * @param y - Y position on the grid.
+     * @param around - Filled with the north, east, south and west cells, read as by at().
+     */
+    void neighbors(int x, int y, Cell around[4]) const;
+
+    /**
+     * @brief set - Overwrites the cell at the x and y position. Allocates the chunk holding
+     * the position if needed, and frees it once its last component is removed.
+     * Out of bounds positions are ignored.
+     * @param x - X position on the grid.
+     * @param y - Y position on the grid.
+     * @param cell - The new cell contents.
+     */
+    void set(int x, int y, Cell cell);
+
+    /**
+     * @brief clear - Empties the board. Runs in the number of allocated chunks.
+     */
+    void clear();
+
+    /**
+     * @brief resize - Empties the board and changes its size.
+     * @param width - The new width of the board, in cells.
+     * @param height - The new height of the board, in cells.
+     */
+    void resize(int width, int height);
+
+    /**
+     * @brief getAllocatedChunks - Getter for the number of chunks currently in memory.
+     * @return The allocated chunk count.
+     */
+    int getAllocatedChunks() const;
+
+private:
+    /**
+     * @brief The Chunk struct - A CHUNK_SIZE x CHUNK_SIZE block of cells in row-major order,
+     * plus the number of non-empty cells it holds.
+     */
+    struct Chunk {
+        Cell cells[CHUNK_SIZE * CHUNK_SIZE];
+        int occupied;
+        int slot;
+    };
+
+    /**
+     * @brief width - The width of the board, in cells.
+     */
+    int width;
+
+    /**
+     * @brief height - The height of the board, in cells.
+     */
+    int height;
+
+    /**
+     * @brief chunksX - The number of chunk columns covering the board and its border.
+     */
+    int chunksX;
+
+    /**
+     * @brief directory - One entry per chunk position, nullptr while unallocated.
+     */
+    QVector<Chunk*> directory;
+
+    /**
+     * @brief allocated - The directory indices of the allocated chunks. Lets clear() skip
+     * the empty parts of the board.
+     */
+    QVector<int> allocated;
+
+    /**
+     * @brief stored - Gets a cell by its position in storage, i.e. with the border included.
+     * @param storedX - X position on the grid plus one.
+     * @param storedY - Y position on the grid plus one.
+     * @return The cell in question. The position must be on the board or its border.
+     */
+    Cell stored(int storedX, int storedY) const;
+
+    /**
+     * @brief freeChunk - Releases an allocated chunk.
+     * @param directoryIndex - The directory index of the chunk.
+     */
+    void freeChunk(int directoryIndex);
+};
+
+#endif // CELLGRID_H
@@ -0,0 +1,304 @@
+#include "cycledetector.h"
+#include <algorithm>
+
+CycleDetector::CycleDetector()
+    : nextComponent(0), nextOrder(0), visitedCount(0) {
+}
+
+void CycleDetector::addEdge(Gate* from, Gate* to) {
+    visitedCount = 0;
+    successors[from].append(to);
+    predecessors[to].append(from);
+    int fromComponent = componentOf(from);
+    int toComponent = componentOf(to);
+    if (fromComponent == toComponent) {
+        if (from == to)
+            changedGates.append(from);
+        return;
+    }
+
+    // An edge running forwards in the order can't close a loop, and keeps the order as it is.
+    qint64 lower = orders.value(toComponent);
+    qint64 upper = orders.value(fromComponent);
+    if (upper < lower)
+        return;
+
+    // Otherwise any path back from the target to the source only passes through the places
+    // between them, and so do the components that have to move.
+    QSet<Gate*> forward = reach(to, successors, lower, upper);
+    QSet<Gate*> backward = reach(from, predecessors, lower, upper);
+    QSet<int> seen;
+    QVector<int> leading;
+    QVector<int> trailing;
+    QVector<qint64> places;
+    QVector<Gate*> region;
+    for (const QSet<Gate*>* side : {&backward, &forward}) {
+        for (Gate* gate : *side) {
+            int component = components.value(gate);
+            if (seen.contains(component))
+                continue;
+            seen.insert(component);
+            places.append(orders.value(component));
+            if (!backward.contains(gate))
+                trailing.append(component);
+            else if (!forward.contains(gate))
+                leading.append(component);
+            else
+                region += members.value(component);
+        }
+    }
+
+    // The components leading to the source take the earliest of their places and the ones the
+    // target leads to the latest. The loop the edge closes, if any, merges some components, so
+    // it takes fewer places than they had, from in between.
+    auto byOrder = [this](int first, int second) {
+        return orders.value(first) < orders.value(second);
+    };
+    std::sort(leading.begin(), leading.end(), byOrder);
+    std::sort(trailing.begin(), trailing.end(), byOrder);
+    std::sort(places.begin(), places.end());
+    QVector<int> merged;
+    if (!region.isEmpty())
+        merged = recompute(region);
+    for (qint64 place : places)
+        usedOrders.remove(place);
+    for (int i = 0; i < leading.size(); i++)
+        setOrder(leading[i], places[i]);
+    for (int i = 0; i < merged.size(); i++)
+        setOrder(merged[i], places[leading.size() + i]);
+    int first = places.size() - trailing.size();
+    for (int i = 0; i < trailing.size(); i++)
+        setOrder(trailing[i], places[first + i]);
+}
+
+void CycleDetector::removeEdge(Gate* from, Gate* to) {
+    visitedCount = 0;
+    if (!successors.value(from).contains(to))
+        return;
+    successors[from].removeOne(to);
+    predecessors[to].removeOne(from);
+
+    // Only the component holding both ends can split.
+    int component = componentOf(from);
+    if (from == to)
+        changedGates.append(from);
+    if (from == to || component != componentOf(to))
+        return;
+    QVector<Gate*> region = members.value(component);
+    qint64 order = orders.value(component);
+    placeSplit(region, order, recompute(region));
+}
+
+void CycleDetector::clear() {
+    successors.clear();
+    predecessors.clear();
+    components.clear();
+    members.clear();
+    orders.clear();
+    usedOrders.clear();
+    nextComponent = 0;
+    nextOrder = 0;
+    visitedCount = 0;
+    changedGates.clear();
+}
+
+int CycleDetector::getComponent(Gate* gate) {
+    return componentOf(gate);
+}
+
+bool CycleDetector::isOnLoop(Gate* gate) {
+    if (!components.contains(gate))
+        return false;
+    return members.value(components.value(gate)).size() > 1
+           || successors.value(gate).contains(gate);
+}
+
+int CycleDetector::getLoopCount() {
+    int loops = 0;
+    for (auto it = members.cbegin(); it != members.cend(); ++it) {
+        if (it.value().size() > 1 || successors.value(it.value().first()).contains(it.value().first()))
+            loops++;
+    }
+    return loops;
+}
+
+int CycleDetector::getVisitedCount() {
+    return visitedCount;
+}
+
+void CycleDetector::takeChangedGates(QSet<Gate*>& gates) {
+    for (Gate* gate : changedGates)
+        gates.insert(gate);
+    changedGates.clear();
+}
+
+int CycleDetector::componentOf(Gate* gate) {
+    auto found = components.constFind(gate);
+    if (found != components.cend())
+        return found.value();
+    int component = nextComponent++;
+    components.insert(gate, component);
+    members.insert(component, {gate});
+    setOrder(component, nextOrder);
+    return component;
+}
+
+QSet<Gate*> CycleDetector::reach(Gate* start, const QHash<Gate*, QVector<Gate*>>& edges,
+                                 qint64 lower, qint64 upper) {
+    QSet<Gate*> reached = {start};
+    QVector<Gate*> stack = {start};
+    while (!stack.isEmpty()) {
+        Gate* gate = stack.takeLast();
+        visitedCount++;
+        auto found = edges.constFind(gate);
+        if (found == edges.cend())
+            continue;
+        for (Gate* next : found.value()) {
+            if (reached.contains(next))
+                continue;
+            qint64 order = orders.value(components.value(next));
+            if (order < lower || order > upper)
+                continue;
+            reached.insert(next);
+            stack.append(next);
+        }
+    }
+    return reached;
+}
+
+QVector<int> CycleDetector::recompute(const QVector<Gate*>& region) {
+    changedGates += region;
+    QSet<Gate*> inRegion(region.cbegin(), region.cend());
+    for (Gate* gate : region) {
+        int component = components.value(gate);
+        members.remove(component);
+        if (orders.contains(component))
+            usedOrders.remove(orders.take(component));
+    }
+
+    // Tarjan's algorithm with an explicit stack of frames, so long chains can't overflow.
+    struct Frame {
+        Gate* gate;
+        const QVector<Gate*>* next;
+        int index;
+    };
+    static const QVector<Gate*> noSuccessors;
+    auto enter = [this](Gate* gate) -> Frame {
+        auto found = successors.constFind(gate);
+        return {gate, found == successors.cend() ? &noSuccessors : &found.value(), 0};
+    };
+    QHash<Gate*, int> indices;
+    QHash<Gate*, int> lows;
+    QVector<Gate*> open;
+    QSet<Gate*> onOpen;
+    QVector<Frame> frames;
+    QVector<int> created;
+    int counter = 0;
+    for (Gate* root : region) {
+        if (indices.contains(root))
+            continue;
+        frames.append(enter(root));
+        indices.insert(root, counter);
+        lows.insert(root, counter++);
+        open.append(root);
+        onOpen.insert(root);
+        while (!frames.isEmpty()) {
+            Frame& frame = frames.last();
+            if (frame.index < frame.next->size()) {
+                Gate* child = frame.next->at(frame.index++);
+                if (!inRegion.contains(child))
+                    continue;
+                if (!indices.contains(child)) {
+                    indices.insert(child, counter);
+                    lows.insert(child, counter++);
+                    open.append(child);
+                    onOpen.insert(child);
+                    frames.append(enter(child));
+                }
+                else if (onOpen.contains(child))
+                    lows[frame.gate] = qMin(lows.value(frame.gate), indices.value(child));
+                continue;
+            }
+
+            // Every edge is done, so the gate either roots a component or hands its low up.
+            Gate* gate = frame.gate;
+            visitedCount++;
+            frames.removeLast();
+            if (!frames.isEmpty())
+                lows[frames.last().gate] = qMin(lows.value(frames.last().gate), lows.value(gate));
+            if (lows.value(gate) != indices.value(gate))
+                continue;
+            int component = nextComponent++;
+            created.append(component);
+            QVector<Gate*>& gates = members[component];
+            Gate* member;
+            do {
+                member = open.takeLast();
+                onOpen.remove(member);
+                components.insert(member, component);
+                gates.append(member);
+            } while (member != gate);
+        }
+    }
+
+    // Tarjan's algorithm finishes a component after every one it feeds.
+    std::reverse(created.begin(), created.end());
+    return created;
+}
+
+void CycleDetector::placeSplit(const QVector<Gate*>& region, qint64 order,
+                               const QVector<int>& created) {
+    // The new components fit between the latest component feeding the old one and the earliest
+    // one it fed.
+    QSet<Gate*> inRegion(region.cbegin(), region.cend());
+    qint64 lower = order - (created.size() + 1) * ORDER_GAP;
+    qint64 upper = order + (created.size() + 1) * ORDER_GAP;
+    for (Gate* gate : region) {
+        for (Gate* input : predecessors.value(gate)) {
+            if (!inRegion.contains(input))
+                lower = qMax(lower, orders.value(components.value(input)));
+        }
+        for (Gate* output : successors.value(gate)) {
+            if (!inRegion.contains(output))
+                upper = qMin(upper, orders.value(components.value(output)));
+        }
+    }
+    qint64 step = (upper - lower) / (created.size() + 1);
+    bool fits = step > 0;
+    for (int i = 0; fits && i < created.size(); i++)
+        fits = !usedOrders.contains(lower + (i + 1) * step);
+    if (!fits) {
+        // Out of room: spread every place out around them.
+        renumber(order, created);
+        return;
+    }
+    for (int i = 0; i < created.size(); i++)
+        setOrder(created[i], lower + (i + 1) * step);
+}
+
+void CycleDetector::setOrder(int component, qint64 order) {
+    orders.insert(component, order);
+    usedOrders.insert(order);
+    nextOrder = qMax(nextOrder, order + ORDER_GAP);
+}
+
+void CycleDetector::renumber(qint64 order, const QVector<int>& created) {
+    QVector<int> sorted;
+    for (auto it = orders.cbegin(); it != orders.cend(); ++it)
+        sorted.append(it.key());
+    std::sort(sorted.begin(), sorted.end(), [this](int first, int second) {
+        return orders.value(first) < orders.value(second);
+    });
+    int index = std::lower_bound(sorted.cbegin(), sorted.cend(), order,
+                                 [this](int component, qint64 order) {
+        return orders.value(component) < order;
+    }) - sorted.cbegin();
+    QVector<int> placed = sorted.mid(0, index);
+    placed += created;
+    placed += sorted.mid(index);
+    orders.clear();
+    usedOrders.clear();
+    nextOrder = 0;
+    for (int component : placed)
+        setOrder(component, nextOrder);
+}
@@ -0,0 +1,201 @@
+/**
+ * This class keeps track of the feedback loops in a level's circuit. Gates
+ * are the vertices of a graph and every net from a gate output into a gate
+ * input is an edge. The strongly connected components of the graph are
+ * kept up to date one edge at a time, along with a topological order of
+ * the components. An edge running forwards in that order can't close a
+ * loop and costs nothing. Otherwise only the components placed between its
+ * two ends are searched: Tarjan's algorithm runs over them if the edge
+ * closes a loop, and they are reordered if it doesn't. Removing an edge
+ * only reruns Tarjan's algorithm over the component it was in. Any
+ * component of more than one gate, or a gate feeding itself, is a loop.
+ *
+ * @authors Max Donaldson, Jason Khong,
+ * Ariadne Petroulakis, Evan Tucker, and Ian Weller
+ *
+ * @version 22 April 2025
+ */
+
+#ifndef CYCLEDETECTOR_H
+#define CYCLEDETECTOR_H
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include "gate.h"
+
+class CycleDetector {
+
+public:
+    /**
+     * @brief CycleDetector - Creates a detector with no gates.
+     */
+    CycleDetector();
+
+    /**
+     * @brief addEdge - Notes that a gate's output feeds an input of another gate. The same pair
+     * may be added more than once, e.g. when a junction feeds both halves of a gate.
+     * @param from - The output half of the feeding gate.
+     * @param to - The output half of the fed gate.
+     */
+    void addEdge(Gate* from, Gate* to);
+
+    /**
+     * @brief removeEdge - Takes away one edge added by addEdge.
+     * @param from - The output half of the feeding gate.
+     * @param to - The output half of the fed gate.
+     */
+    void removeEdge(Gate* from, Gate* to);
+
+    /**
+     * @brief clear - Forgets every gate and edge, e.g. when the gates are deleted.
+     */
+    void clear();
+
+    /**
+     * @brief getComponent - Gets the strongly connected component of a gate.
+     * @param gate - The output half of the gate.
+     * @return An id shared by exactly the gates of the same component.
+     */
+    int getComponent(Gate* gate);
+
+    /**
+     * @brief isOnLoop - Checks whether a gate's output can find its way back to its inputs.
+     * @param gate - The output half of the gate.
+     * @return True if the gate's component has several gates or it feeds itself.
+     */
+    bool isOnLoop(Gate* gate);
+
+    /**
+     * @brief getLoopCount - Getter for the number of separate loops.
+     * @return The number of components that are loops.
+     */
+    int getLoopCount();
+
+    /**
+     * @brief getVisitedCount - Getter for the amount of work done by the last addEdge or
+     * removeEdge call.
+     * @return The number of gates searched or rerun through Tarjan's algorithm.
+     */
+    int getVisitedCount();
+
+    /**
+     * @brief takeChangedGates - Hands over the gates whose loop may have changed since the last
+     * call: every gate of a component that was merged or split, and every gate that gained or
+     * lost an edge to itself.
+     * @param gates - The output halves are added to this set.
+     */
+    void takeChangedGates(QSet<Gate*>& gates);
+
+private:
+    /**
+     * @brief ORDER_GAP - The distance between the places of new components.
+     */
+    static const qint64 ORDER_GAP = 1 << 16;
+
+    /**
+     * @brief successors - The gates each gate feeds, once per edge.
+     */
+    QHash<Gate*, QVector<Gate*>> successors;
+
+    /**
+     * @brief predecessors - The gates feeding each gate, once per edge.
+     */
+    QHash<Gate*, QVector<Gate*>> predecessors;
+
+    /**
+     * @brief components - The component id of each gate.
+     */
+    QHash<Gate*, int> components;
+
+    /**
+     * @brief members - The gates of each component.
+     */
+    QHash<int, QVector<Gate*>> members;
+
+    /**
+     * @brief orders - The place of each component in a topological order: a component feeding
+     * another one comes first. Places are distinct but don't have to be consecutive.
+     */
+    QHash<int, qint64> orders;
+
+    /**
+     * @brief usedOrders - The places taken in orders.
+     */
+    QSet<qint64> usedOrders;
+
+    /**
+     * @brief nextComponent - The next unused component id.
+     */
+    int nextComponent;
+
+    /**
+     * @brief nextOrder - The place given to the next new gate, after every place in use.
+     */
+    qint64 nextOrder;
+
+    /**
+     * @brief visitedCount - Work counter for the last update.
+     */
+    int visitedCount;
+
+    /**
+     * @brief changedGates - The gates whose loop may have changed since the last
+     * takeChangedGates call.
+     */
+    QVector<Gate*> changedGates;
+
+    /**
+     * @brief componentOf - Gets the component of a gate, giving a new gate one of its own.
+     * @param gate - The output half of the gate.
+     * @return The component id.
+     */
+    int componentOf(Gate* gate);
+
+    /**
+     * @brief reach - Finds every gate reachable from a gate along edges, through components
+     * placed within a range.
+     * @param start - The gate to start from.
+     * @param edges - successors to search forwards or predecessors to search backwards.
+     * @param lower - The earliest place searched.
+     * @param upper - The latest place searched.
+     * @return The gates reached, including start.
+     */
+    QSet<Gate*> reach(Gate* start, const QHash<Gate*, QVector<Gate*>>& edges, qint64 lower,
+                      qint64 upper);
+
+    /**
+     * @brief recompute - Reruns Tarjan's algorithm over some gates and the edges between them,
+     * replacing their components. The gates must be a union of whole components. The new
+     * components are not placed.
+     * @param region - The gates to rerun.
+     * @return The new components, each after every one feeding it.
+     */
+    QVector<int> recompute(const QVector<Gate*>& region);
+
+    /**
+     * @brief placeSplit - Places the components a component split into where it was, between
+     * every component feeding them and every one they feed.
+     * @param region - The gates of the old component.
+     * @param order - The place of the old component.
+     * @param created - The new components, as recompute returned them.
+     */
+    void placeSplit(const QVector<Gate*>& region, qint64 order, const QVector<int>& created);
+
+    /**
+     * @brief setOrder - Places a component.
+     * @param component - The component.
+     * @param order - Its place, which no other component may have.
+     */
+    void setOrder(int component, qint64 order);
+
+    /**
+     * @brief renumber - Spreads the places of all components ORDER_GAP apart, keeping their
+     * order, to make room between them.
+     * @param order - Where the new components of a split go.
+     * @param created - The new components, not placed yet, in topological order.
+     */
+    void renumber(qint64 order, const QVector<int>& created);
+};
+
+#endif // CYCLEDETECTOR_H
@@ -1,8 +1,11 @@
 #include "gate.h"
+#include "gatekernels.h"
+#include "journal.h"
 
-Gate::Gate(int x, int y, Operator type, Ports ports, Direction direction, QObject *parent)
-    : QObject{parent}, gateOperator(type), alignment(ports), direction(direction) {
-    outputSignal = false;
+Gate::Gate(int x, int y, Operator type, Ports ports, Direction direction, WirePool* wirePool,
+           Journal* journal, QObject *parent)
+    : QObject{parent}, gateOperator(type), journal(journal), delay(1), alignment(ports),
+    direction(direction) {
     otherHalf = nullptr;
     this->x = x;
     this->y = y;
@@ -10,7 +13,7 @@ Gate::Gate(int x, int y, Operator type, Ports ports, Direction direction, QObjec
     inputNode = nullptr;
 
     // Add a switch statement to accurately add Node pointers depending on orientation/type.
-    inputNode = new Node(this, x, y, Node::Type::END, true, "");
+    inputNode = new Node(wirePool, this, x, y, Node::Type::END, true, Tag());
     switch (direction) {
     case Gate::Direction::NORTH :
         inputNode->setDirection(Node::Direction::S);
@@ -26,7 +29,7 @@ Gate::Gate(int x, int y, Operator type, Ports ports, Direction direction, QObjec
         break;
     }
     if (ports == Ports::INOUT) {
-        outputNode = new Node(this, x, y, Node::Type::ROOT, false, "");
+        outputNode = new Node(wirePool, this, x, y, Node::Type::ROOT, false, Tag());
         switch (direction) {
         case Gate::Direction::NORTH :
             outputNode->setDirection(Node::Direction::N);
@@ -53,53 +56,48 @@ Gate::Operator Gate::getOperator() {
     return gateOperator;
 }
 
-void Gate::convertSignal(bool firstSignal, bool secondSignal, QString firstID, QString secondID) {
-    bool newOutput;
-    QString newID = firstID;
-    newID.append(secondID);
-    std::sort(newID.begin(), newID.end());
-
-    //calls the specific helper method based on the Type
-    switch(gateOperator) {
-    case Operator::AND:
-        newOutput = firstSignal && secondSignal;
-        break;
-    case Operator::OR:
-        newOutput = firstSignal || secondSignal;
-        break;
-    default:
-        return;
-    }
+int Gate::getDelay() {
+    return delay;
+}
 
-    //sets outputSignal to the resulting boolean.
-    if(outputNode) {
-        outputNode->setSignal(newOutput);
-        outputNode->setTag(newID);
-    }
-    else if (otherHalf->outputNode) {
-        otherHalf->outputNode->setSignal(newOutput);
-        otherHalf->outputNode->setTag(newID);
-    }
+void Gate::setDelay(int ticks) {
+    delay = qBound(1, ticks, int(MAX_DELAY));
+    if (otherHalf)
+        otherHalf->delay = delay;
 }
 
-void Gate::convertSignal(bool input, QString id) {
-    if(gateOperator != Operator::NOT)
+void Gate::convertSignal(const Bus& firstSignal, const Bus& secondSignal, Tag firstID, Tag secondID) {
+    Gate* outputHalf = outputNode ? this : otherHalf;
+    if (outputHalf == nullptr || outputHalf->outputNode == nullptr)
         return;
-    bool newOutput = !input;
+    Bus nextState = outputHalf->state;
+    Bus nextControl = outputHalf->lastControl;
+    Bus newOutput = GateKernels::isTimed(gateOperator)
+        ? nextState
+        : GateKernels::step(gateOperator, firstSignal, secondSignal, nextState, nextControl);
+    outputHalf->setState(nextState, nextControl);
 
-    //sets outputSignal to the resulting boolean.
-    if(outputNode){
-        outputNode->setSignal(newOutput);
-        outputNode->setTag(id);
-    }
+    //sets the output node to the resulting signal.
+    outputHalf->outputNode->setSignal(newOutput);
+    outputHalf->outputNode->setTag(GateKernels::isStateful(gateOperator) ? secondID
+                                                                         : firstID.united(secondID));
 }
 
-bool Gate::getSignal() {
-    return outputSignal;
+Bus Gate::getState() {
+    return state;
 }
 
-void Gate::setSignal(bool signal) {
-    outputSignal = signal;
+Bus Gate::getLastControl() {
+    return lastControl;
+}
+
+void Gate::setState(const Bus& newState, const Bus& newLastControl) {
+    if (state == newState && lastControl == newLastControl)
+        return;
+    if (journal)
+        journal->recordGateState(this);
+    state = newState;
+    lastControl = newLastControl;
 }
 
 Gate* Gate::getOtherHalf() {
@@ -108,7 +106,7 @@ Gate* Gate::getOtherHalf() {
 
 void Gate::setOtherHalf(Gate* otherGate) {
     // Conditions wherein this method should do nothing.
-    if(this->gateOperator == Operator::NOT || this->gateOperator != otherGate->gateOperator)
+    if(GateKernels::getInputCount(gateOperator) == 1 || this->gateOperator != otherGate->gateOperator)
         return;
 
     // Connects this half of a two-square gate to the other half.
@@ -134,18 +132,27 @@ bool Gate::isFullyConnected() {
 
 }
 
+bool Gate::canDrive() {
+    if (!GateKernels::isStateful(gateOperator))
+        return isFullyConnected();
+
+    // The clock or enable is the input of the half without the output.
+    Gate* controlHalf = otherHalf && outputNode ? otherHalf : this;
+    return controlHalf->inputNode->getConnected();
+}
+
 Node::Direction Gate::getInputDirection() {
     return inputNode->getDirection();
 }
 
-QString Gate::getTag() {
+Tag Gate::getTag() {
     if (outputNode == nullptr && otherHalf->getOutputNode()) {
         return otherHalf->getOutputNode()->getTag();
     }
     else if (outputNode) {
         return outputNode->getTag();
     }
-    return "";
+    return Tag();
 }
 
 Node* Gate::getOutputNode() {
@@ -180,17 +187,24 @@ void Gate::connectWire(Wire* connectWire, Wire::Direction connectionDirection) {
     }
     if(!connectWire->getHeadConnection())
         return;
-    bool firstSignal = inputNode->getSignal();
-    QString firstTag = inputNode->getTag();
-
-    // If there is another half (ergo it's a double gate) run this
-    if(otherHalf) {
-        bool secondSignal = otherHalf->inputNode->getSignal();
-        QString secondTag = otherHalf->inputNode->getTag();
-        convertSignal(firstSignal, secondSignal, firstTag, secondTag);
+    evaluate();
+}
+
+void Gate::evaluate() {
+    Gate* outputHalf = outputNode ? this : otherHalf;
+    Node* output = outputHalf->outputNode;
+    if (!canDrive()) {
+        output->setSignal(false);
+        output->setTag(Tag());
+        outputHalf->setState(Bus(), Bus());
         return;
     }
 
-    // If there is no other half (ergo it's a single gate) run only this
-    convertSignal(firstSignal, firstTag);
+    // The output half's input comes first, whichever half is evaluated. A single gate reads its
+    // one input as both operands.
+    Node* firstInput = outputHalf->inputNode;
+    Node* secondInput = outputHalf->otherHalf ? outputHalf->otherHalf->inputNode : firstInput;
+    Bus firstSignal = firstInput->getConnected() ? firstInput->getSignal() : Bus();
+    convertSignal(firstSignal, secondInput->getSignal(), firstInput->getTag(),
+                  secondInput->getTag());
 }
@@ -1,6 +1,9 @@
 /**
- * This class represents a logic gate. Each gate is either
- * an AND, OR, or NOT gate.
+ * This class represents a logic gate. NOT gates and clocks take one
+ * square and every other operator two, one per input. What each operator
+ * computes is defined in GateKernels. Flip-flops, latches and clocks keep
+ * a state on their output half, and every gate has a propagation delay
+ * that the Simulator schedules its output changes by.
  *
  * @authors Max Donaldson, Jason Khong,
  * Ariadne Petroulakis, Evan Tucker, and Ian Weller
@@ -14,6 +17,8 @@
 #include <QObject>
 #include "node.h"
 
+class Journal;
+
 class Gate : public QObject {
 
     Q_OBJECT
@@ -21,10 +26,13 @@ class Gate : public QObject {
 public:
     /**
     * @brief The Operator enum - Holds the operation type performed
-    * by this gate. Represents the different types of logic gates.
+    * by this gate. Represents the different types of logic gates. The values are stored in level
+    * packs, so new operators go at the end. MUX reads a select input as well, so it can't be
+    * placed as a two-square gate and is only evaluated in batches. DFF and LATCH take D on the
+    * output half and the clock or enable on the other; CLOCK's one input enables it.
     */
     enum class Operator {
-        AND, OR, NOT
+        AND, OR, NOT, XOR, NAND, NOR, XNOR, MUX, DFF, LATCH, CLOCK
     };
 
     /**
@@ -44,20 +52,27 @@ public:
         NORTH, EAST, SOUTH, WEST
     };
 
+    /**
+     * @brief MAX_DELAY - The longest propagation delay a gate can have, in simulator ticks.
+     */
+    static const int MAX_DELAY = 255;
+
     /**
      * @brief Gate - Complex constructor that initializes most of the values for the Gate object.
      * @param x - Stores the X-coordinate for the position of this Gate on the game board.
      * @param y - Stores the Y-coordinate for the position of this Gate on the game board.
-     * @param type - Stores the type this is. Dependent on the Gate::Operator enum. Either
-     * AND, OR, or NOT. AND and OR gates will create a second gate for a second input.
+     * @param type - Stores the type this is. Dependent on the Gate::Operator enum. Every
+     * operator with two inputs will create a second gate for a second input.
      * @param alignment - Directs whether or not this gate stores an output Node. Dependent on the
      * Gate::Ports enum, either being IN or INOUT. INOUT stores the output Node.
      * @param direction - Orients where the input/output of the Gate will be. Dependent on the
      * Gate::Direction, being NORTH, SOUTH, EAST, or WEST.
+     * @param wirePool - The pool the backing wires of the input and output Nodes are taken from.
+     * @param journal - The journal told about state changes, or nullptr.
      * @param parent - Used by the default QObject constructor to set the parent object.
      */
     explicit Gate(int x, int y, Operator type, Ports alignment, Direction direction,
-                  QObject *parent = nullptr);
+                  WirePool* wirePool, Journal* journal, QObject *parent = nullptr);
 
     /**
      * Destructor for the Gate class.
@@ -65,44 +80,58 @@ public:
     ~Gate();
 
     /**
-     * @brief getOperator - Returns either Operator::AND if this gate
-     * represents an AND gate, Operator::OR if this gate represents
-     * an OR gate, or Operator::NOT if this gate represents a NOT gate.
+     * @brief getOperator - Returns the operator this gate performs, e.g. Operator::AND if
+     * this gate represents an AND gate.
      * @return The operator type this Gate is.
      */
     Operator getOperator();
 
     /**
-     * @brief getSignal - returns the output signal.
-     * @return The current signal the inputs merge into. Dependent on the Gate Operator.
+     * @brief getState - Getter for the stored value of a flip-flop, latch or clock.
+     * @return The state. Only the output half keeps one.
+     */
+    Bus getState();
+
+    /**
+     * @brief getLastControl - Getter for the clock or enable input at the last evaluation.
+     * @return The last control input. Only the output half keeps one.
+     */
+    Bus getLastControl();
+
+    /**
+     * @brief setState - Sets the state and last control input, logging the old ones to the
+     * journal first so undo brings them back.
+     * @param newState - The new state.
+     * @param newLastControl - The new last control input.
+     */
+    void setState(const Bus& newState, const Bus& newLastControl);
+
+    /**
+     * @brief getDelay - Getter for the propagation delay.
+     * @return The ticks between an input change and the output change, at least one.
      */
-    bool getSignal();
+    int getDelay();
 
     /**
-     * @brief setSignal - Sets output signal to desired output.
-     * @param signal - A bool manually set by the user.
+     * @brief setDelay - Sets the propagation delay of both halves. A clock toggles once per
+     * delay, so its period is twice the delay.
+     * @param ticks - The delay, clamped to between 1 and MAX_DELAY.
      */
-    void setSignal(bool signal);
+    void setDelay(int ticks);
 
     /**
      * @brief convertSignal - Sets the output signal after checking the
-     * two input pulses and performing a boolean operation on them based
-     * on the Type of the gate.
+     * input pulses and stepping the gate's kernel from GateKernels on them.
+     * Bus inputs are combined lane by lane. Single-square gates are given
+     * their one input twice. Clocks only tick in the Simulator, so on the
+     * board they keep outputting their state. Sequential gates carry the
+     * tag of their clock or enable only.
      * @param firstSignal - The signal of the wire in the gate's first slot
      * @param secondSignal - The signal of the wire in the gate's second input slot.
      * @param firstID - The ID linked with the first signal.
      * @param secondID - The ID linked with the second signal.
      */
-    void convertSignal(bool firstSignal, bool secondSignal, QString firstID, QString secondID);
-
-    /**
-     * @brief convertSignal - Sets the output signal to an opertion
-     * based on a compatible gate Type when given only one input. Keeps
-     * track of the ID of the input passed into it.
-     * @param input - The boolean signal sent in by the input wire.
-     * @param id - The ID associated with the input signal.
-     */
-    void convertSignal(bool input, QString id);
+    void convertSignal(const Bus& firstSignal, const Bus& secondSignal, Tag firstID, Tag secondID);
 
     /**
      * @brief getOtherHalf - Getter method to the other Gate object tethered to this. Will return
@@ -144,6 +173,14 @@ public:
      */
     bool isFullyConnected();
 
+    /**
+     * @brief canDrive - Checks if a wire can be drawn from this gate's output. Combinational
+     * gates must be fully connected. Flip-flops, latches and clocks output their state, so they
+     * only need their clock or enable, which lets their D input be fed back from their output.
+     * @return True if the output can be wired.
+     */
+    bool canDrive();
+
     /**
      * @brief getInputDirection - Getter for the direction necessary to approach the input Node.
      * @return A Node::Direction denoting which direction the input must be approached by.
@@ -166,7 +203,7 @@ public:
      * @brief getTag - Getter for the tag in the output.
      * @return The tag current stored in the Gate.
      */
-    QString getTag();
+    Tag getTag();
 
     /**
      * @brief connectWire - Connects the gieven wire to the Gate. Either an input or an output
@@ -176,6 +213,12 @@ public:
      */
     void connectWire(Wire* connectWire, Wire::Direction connectionDirection);
 
+    /**
+     * @brief evaluate - Recomputes the output node from the current input nodes. A gate that
+     * can't drive is dead and outputs false with an empty tag. An open D input reads false.
+     */
+    void evaluate();
+
 private:
     /**
      * @brief x - The X-coordinate for the position the gate is at on the game baord.
@@ -188,7 +231,7 @@ private:
     int y;
 
     /**
-     * @brief gateOperator - Whether this object represents an AND, OR, or NOT gate.
+     * @brief gateOperator - Which operator this gate performs, e.g. AND, OR, or NOT.
      */
     Operator gateOperator;
 
@@ -205,10 +248,25 @@ private:
     Node* outputNode;
 
     /**
-     * @brief outputSignal - The signal currently output
-     * by this logic gate. False when the gate is dead.
+     * @brief state - The stored value of a flip-flop, latch or clock. Kept on the output half.
+     */
+    Bus state;
+
+    /**
+     * @brief lastControl - The clock or enable input at the last evaluation, for finding
+     * rising edges. Kept on the output half.
+     */
+    Bus lastControl;
+
+    /**
+     * @brief journal - The journal told about state changes, or nullptr.
+     */
+    Journal* journal;
+
+    /**
+     * @brief delay - The propagation delay in simulator ticks.
      */
-    bool outputSignal;
+    int delay;
 
     /**
      * @brief otherHalf - The other half of the current gate.
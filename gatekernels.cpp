@@ -0,0 +1,176 @@
+#include "gatekernels.h"
+#include <array>
+#include <utility>
+#ifdef BUS_AVX2
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using BusKernel = Bus (*)(const Bus&, const Bus&, const Bus&);
+using BatchKernel = void (*)(const quint64*, const quint64*, const quint64*, quint64*, int);
+
+struct Entry {
+    int inputs;
+    bool stateful;
+    bool edge;
+    bool timed;
+    const char* name;
+    BusKernel bus;
+    BatchKernel batch;
+    BatchKernel batchAvx2;
+};
+
+template<Gate::Operator op>
+Bus applyBus(const Bus& first, const Bus& second, const Bus& select) {
+    return GateKernel<op>::apply(first, second, select);
+}
+
+// Inputs an operator doesn't read are never dereferenced, so callers may pass null for them.
+template<Gate::Operator op>
+void applyBatch(const quint64* first, const quint64* second, const quint64* select,
+                quint64* result, int words) {
+    constexpr int inputs = GateKernel<op>::INPUTS;
+    constexpr bool readsSelect = inputs >= 3 || GateKernel<op>::STATEFUL;
+    for (int i = 0; i < words; i++) {
+        quint64 a = first[i];
+        quint64 b = inputs >= 2 ? second[i] : 0;
+        quint64 s = readsSelect ? select[i] : 0;
+        result[i] = GateKernel<op>::apply(a, b, s);
+    }
+}
+
+#ifdef BUS_AVX2
+// Four words of lanes, with the operators the kernels are written in done by AVX2. The words
+// are kept in memory rather than in a register type, so the kernels' apply templates pass them
+// the same way whatever instruction set they were compiled for, and inlining folds the loads
+// and stores away.
+struct Avx2Words {
+    alignas(32) quint64 words[4];
+};
+
+__attribute__((target("avx2")))
+inline __m256i loadWords(const quint64* source) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+}
+
+__attribute__((target("avx2")))
+inline Avx2Words storeWords(__m256i value) {
+    Avx2Words result;
+    _mm256_store_si256(reinterpret_cast<__m256i*>(result.words), value);
+    return result;
+}
+
+__attribute__((target("avx2")))
+inline Avx2Words operator&(const Avx2Words& first, const Avx2Words& second) {
+    return storeWords(_mm256_and_si256(loadWords(first.words), loadWords(second.words)));
+}
+
+__attribute__((target("avx2")))
+inline Avx2Words operator|(const Avx2Words& first, const Avx2Words& second) {
+    return storeWords(_mm256_or_si256(loadWords(first.words), loadWords(second.words)));
+}
+
+__attribute__((target("avx2")))
+inline Avx2Words operator^(const Avx2Words& first, const Avx2Words& second) {
+    return storeWords(_mm256_xor_si256(loadWords(first.words), loadWords(second.words)));
+}
+
+__attribute__((target("avx2")))
+inline Avx2Words operator~(const Avx2Words& words) {
+    return storeWords(_mm256_xor_si256(loadWords(words.words), _mm256_set1_epi64x(-1)));
+}
+
+// The same kernel four words at a time, then word by word for the rest.
+template<Gate::Operator op>
+__attribute__((target("avx2"), flatten))
+void applyBatchAvx2(const quint64* first, const quint64* second, const quint64* select,
+                    quint64* result, int words) {
+    constexpr int inputs = GateKernel<op>::INPUTS;
+    constexpr bool readsSelect = inputs >= 3 || GateKernel<op>::STATEFUL;
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 4 <= words; i += 4) {
+        Avx2Words a = storeWords(loadWords(first + i));
+        Avx2Words b = storeWords(inputs >= 2 ? loadWords(second + i) : zero);
+        Avx2Words s = storeWords(readsSelect ? loadWords(select + i) : zero);
+        Avx2Words output = GateKernel<op>::apply(a, b, s);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(result + i), loadWords(output.words));
+    }
+    applyBatch<op>(first + i, inputs >= 2 ? second + i : nullptr,
+                   readsSelect ? select + i : nullptr, result + i, words - i);
+}
+#endif
+
+template<std::size_t... index>
+constexpr std::array<Entry, sizeof...(index)> makeTable(std::index_sequence<index...>) {
+    return {{{GateKernel<Gate::Operator(index)>::INPUTS, GateKernel<Gate::Operator(index)>::STATEFUL,
+              GateKernel<Gate::Operator(index)>::EDGE, GateKernel<Gate::Operator(index)>::TIMED,
+              GateKernel<Gate::Operator(index)>::NAME, &applyBus<Gate::Operator(index)>,
+              &applyBatch<Gate::Operator(index)>,
+#ifdef BUS_AVX2
+              &applyBatchAvx2<Gate::Operator(index)>
+#else
+              &applyBatch<Gate::Operator(index)>
+#endif
+             }...}};
+}
+
+constexpr std::array<Entry, GateKernels::OPERATOR_COUNT> TABLE =
+    makeTable(std::make_index_sequence<GateKernels::OPERATOR_COUNT>());
+
+static_assert(TABLE[int(Gate::Operator::NOT)].inputs == 1, "NOT reads one input");
+static_assert(TABLE[int(Gate::Operator::DFF)].edge && !TABLE[int(Gate::Operator::LATCH)].edge,
+              "only flip-flops are edge-triggered");
+static_assert(GateKernel<Gate::Operator::NAND>::apply<quint64>(0b1100, 0b1010, 0) == ~quint64(0b1000),
+              "kernels are usable at compile time");
+
+}
+
+int GateKernels::getInputCount(Gate::Operator op) {
+    return TABLE[int(op)].inputs;
+}
+
+bool GateKernels::isStateful(Gate::Operator op) {
+    return TABLE[int(op)].stateful;
+}
+
+bool GateKernels::isTimed(Gate::Operator op) {
+    return TABLE[int(op)].timed;
+}
+
+const char* GateKernels::getName(Gate::Operator op) {
+    return TABLE[int(op)].name;
+}
+
+Bus GateKernels::apply(Gate::Operator op, const Bus& first, const Bus& second, const Bus& select) {
+    return TABLE[int(op)].bus(first, second, select);
+}
+
+Bus GateKernels::step(Gate::Operator op, const Bus& first, const Bus& second, Bus& state,
+                      Bus& lastControl) {
+    const Entry& entry = TABLE[int(op)];
+    if (!entry.stateful)
+        return entry.bus(first, second, state);
+    Bus control = entry.edge ? second & ~lastControl : second;
+    lastControl = second;
+    state = entry.bus(first, control, state);
+    return state;
+}
+
+bool GateKernels::evaluateBatch(Gate::Operator op, const quint64* first, const quint64* second,
+                                const quint64* select, quint64* result, int words) {
+    const Entry& entry = TABLE[int(op)];
+    bool readsSelect = entry.inputs >= 3 || entry.stateful;
+    if (first == nullptr || (entry.inputs >= 2 && second == nullptr)
+        || (readsSelect && select == nullptr))
+        return false;
+#ifdef BUS_AVX2
+    if (Bus::hasAvx2()) {
+        entry.batchAvx2(first, second, select, result, words);
+        return true;
+    }
+#endif
+    entry.batch(first, second, select, result, words);
+    return true;
+}
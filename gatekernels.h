@@ -0,0 +1,251 @@
+/**
+ * This class holds the logic of every gate operator in one table. Each
+ * operator is a GateKernel specialization with a constexpr apply template
+ * over its first, second and select inputs. The table is built from
+ * those kernels at compile time and gives each operator two entry points:
+ * a bus kernel for the interactive board, and a batched kernel that runs
+ * a whole array of same-operator gates in one tight loop over 64-bit
+ * words. Where Bus has an AVX2 path, the batched kernel also comes in an
+ * AVX2 build that applies the same kernel to four words per instruction,
+ * and is taken when the CPU supports it. Adding an operator only takes a
+ * new Gate::Operator value and its kernel.
+ *
+ * Sequential operators keep a state between evaluations. Their kernels
+ * compute the next state, reading the current one as the select input,
+ * and step applies them: flip-flops only see their control input on a
+ * rising edge, and clocks only change when a Simulator timer fires.
+ *
+ * @authors Max Donaldson, Jason Khong,
+ * Ariadne Petroulakis, Evan Tucker, and Ian Weller
+ *
+ * @version 22 April 2025
+ */
+
+#ifndef GATEKERNELS_H
+#define GATEKERNELS_H
+
+#include "bus.h"
+#include "gate.h"
+
+/**
+ * @brief GateKernel - The logic of one operator. INPUTS is how many of first, second and select
+ * it reads, and NAME is how it is labeled.
+ */
+template<Gate::Operator op>
+struct GateKernel;
+
+/**
+ * @brief CombinationalKernel - The traits of an operator whose output only depends on its
+ * inputs.
+ */
+struct CombinationalKernel {
+    static constexpr bool STATEFUL = false;
+    static constexpr bool EDGE = false;
+    static constexpr bool TIMED = false;
+};
+
+/**
+ * @brief SequentialKernel - The traits of an operator with a state. EDGE kernels see their
+ * second input as a rising-edge pulse, TIMED kernels only step when their timer fires.
+ */
+struct SequentialKernel {
+    static constexpr bool STATEFUL = true;
+    static constexpr bool EDGE = false;
+    static constexpr bool TIMED = false;
+};
+
+template<>
+struct GateKernel<Gate::Operator::AND> : CombinationalKernel {
+    static constexpr int INPUTS = 2;
+    static constexpr const char* NAME = "AND";
+    template<typename T>
+    static constexpr T apply(const T& first, const T& second, const T&) {
+        return first & second;
+    }
+};
+
+template<>
+struct GateKernel<Gate::Operator::OR> : CombinationalKernel {
+    static constexpr int INPUTS = 2;
+    static constexpr const char* NAME = "OR";
+    template<typename T>
+    static constexpr T apply(const T& first, const T& second, const T&) {
+        return first | second;
+    }
+};
+
+template<>
+struct GateKernel<Gate::Operator::NOT> : CombinationalKernel {
+    static constexpr int INPUTS = 1;
+    static constexpr const char* NAME = "NOT";
+    template<typename T>
+    static constexpr T apply(const T& first, const T&, const T&) {
+        return ~first;
+    }
+};
+
+template<>
+struct GateKernel<Gate::Operator::XOR> : CombinationalKernel {
+    static constexpr int INPUTS = 2;
+    static constexpr const char* NAME = "XOR";
+    template<typename T>
+    static constexpr T apply(const T& first, const T& second, const T&) {
+        return first ^ second;
+    }
+};
+
+template<>
+struct GateKernel<Gate::Operator::NAND> : CombinationalKernel {
+    static constexpr int INPUTS = 2;
+    static constexpr const char* NAME = "NAND";
+    template<typename T>
+    static constexpr T apply(const T& first, const T& second, const T&) {
+        return ~(first & second);
+    }
+};
+
+template<>
+struct GateKernel<Gate::Operator::NOR> : CombinationalKernel {
+    static constexpr int INPUTS = 2;
+    static constexpr const char* NAME = "NOR";
+    template<typename T>
+    static constexpr T apply(const T& first, const T& second, const T&) {
+        return ~(first | second);
+    }
+};
+
+template<>
+struct GateKernel<Gate::Operator::XNOR> : CombinationalKernel {
+    static constexpr int INPUTS = 2;
+    static constexpr const char* NAME = "XNOR";
+    template<typename T>
+    static constexpr T apply(const T& first, const T& second, const T&) {
+        return ~(first ^ second);
+    }
+};
+
+template<>
+struct GateKernel<Gate::Operator::MUX> : CombinationalKernel {
+    static constexpr int INPUTS = 3;
+    static constexpr const char* NAME = "MUX";
+    template<typename T>
+    static constexpr T apply(const T& first, const T& second, const T& select) {
+        return (select & second) | (~select & first);
+    }
+};
+
+// The D flip-flop takes D where the clock rose and keeps its state elsewhere.
+template<>
+struct GateKernel<Gate::Operator::DFF> : SequentialKernel {
+    static constexpr int INPUTS = 2;
+    static constexpr const char* NAME = "DFF";
+    static constexpr bool EDGE = true;
+    template<typename T>
+    static constexpr T apply(const T& data, const T& rose, const T& state) {
+        return (rose & data) | (~rose & state);
+    }
+};
+
+// The latch follows D while enabled and keeps its state otherwise.
+template<>
+struct GateKernel<Gate::Operator::LATCH> : SequentialKernel {
+    static constexpr int INPUTS = 2;
+    static constexpr const char* NAME = "LATCH";
+    template<typename T>
+    static constexpr T apply(const T& data, const T& enable, const T& state) {
+        return (enable & data) | (~enable & state);
+    }
+};
+
+// The clock toggles each time its timer fires, while enabled.
+template<>
+struct GateKernel<Gate::Operator::CLOCK> : SequentialKernel {
+    static constexpr int INPUTS = 1;
+    static constexpr const char* NAME = "CLK";
+    static constexpr bool TIMED = true;
+    template<typename T>
+    static constexpr T apply(const T& enable, const T&, const T& state) {
+        return state ^ enable;
+    }
+};
+
+class GateKernels {
+
+public:
+    /**
+     * @brief OPERATOR_COUNT - The number of Gate::Operator values. CLOCK must stay the last one.
+     */
+    static const int OPERATOR_COUNT = int(Gate::Operator::CLOCK) + 1;
+
+    /**
+     * @brief getInputCount - Gets how many inputs an operator reads.
+     * @param op - The operator.
+     * @return 1 for NOT and CLOCK, 3 for MUX, otherwise 2.
+     */
+    static int getInputCount(Gate::Operator op);
+
+    /**
+     * @brief isStateful - Checks whether an operator keeps a state, i.e. DFF, LATCH or CLOCK.
+     * @param op - The operator.
+     * @return True for sequential operators.
+     */
+    static bool isStateful(Gate::Operator op);
+
+    /**
+     * @brief isTimed - Checks whether an operator only steps when its timer fires, i.e. CLOCK.
+     * @param op - The operator.
+     * @return True for clocks.
+     */
+    static bool isTimed(Gate::Operator op);
+
+    /**
+     * @brief getName - Gets the label of an operator.
+     * @param op - The operator.
+     * @return The name, e.g. "NAND".
+     */
+    static const char* getName(Gate::Operator op);
+
+    /**
+     * @brief apply - Runs an operator on board signals, lane by lane.
+     * @param op - The operator.
+     * @param first - The first input.
+     * @param second - The second input. Ignored by single-input operators.
+     * @param select - The select input. MUX takes second where it is set, and sequential
+     * operators read it as their current state.
+     * @return The output, as wide as the widest input read.
+     */
+    static Bus apply(Gate::Operator op, const Bus& first, const Bus& second,
+                     const Bus& select = Bus());
+
+    /**
+     * @brief step - Evaluates a gate of any operator. Combinational operators just apply their
+     * kernel. Sequential ones move their state to the kernel's next state and output it; an EDGE
+     * operator's second input is first reduced to the lanes that rose since the last step.
+     * @param op - The operator.
+     * @param first - The first input.
+     * @param second - The second input. Single-input gates pass their first input again.
+     * @param state - The state of the gate. Updated for sequential operators.
+     * @param lastControl - The second input at the last step. Updated for sequential operators.
+     * @return The output.
+     */
+    static Bus step(Gate::Operator op, const Bus& first, const Bus& second, Bus& state,
+                    Bus& lastControl);
+
+    /**
+     * @brief evaluateBatch - Runs an operator over arrays of words, e.g. every lane block of a
+     * run of same-operator gates. Each input is one contiguous array, so the words are loaded
+     * four at a time on the AVX2 path. Inputs the operator doesn't read may be null.
+     * @param op - The operator.
+     * @param first - The first inputs.
+     * @param second - The second inputs.
+     * @param select - The select inputs, or the states of sequential operators.
+     * @param result - Receives the outputs. May alias an input array.
+     * @param words - The length of each array.
+     * @return False, with nothing written, if an input the operator reads is null, e.g. the
+     * select of a MUX or the state of a sequential operator.
+     */
+    static bool evaluateBatch(Gate::Operator op, const quint64* first, const quint64* second,
+                              const quint64* select, quint64* result, int words);
+};
+
+#endif // GATEKERNELS_H
@@ -0,0 +1,567 @@
+#include "generator.h"
+#include "gatekernels.h"
+#include "level.h"
+#include "router.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+namespace {
+
+// Bit i of an input's column is set when bit k of i is set.
+const quint64 COLUMNS[Generator::MAX_TARGET_INPUTS] = {
+    0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+    0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull
+};
+
+}
+
+Generator::Generator(int width, int height)
+    : width(width), height(height), inputCount(3), hasTarget(false), targetTable(0),
+    obstacleDensity(25), threadCount(qMax(1u, std::thread::hardware_concurrency())), seed(0),
+    elapsedMs(0), wanted(0), candidatesLeft(0), done(false) {
+}
+
+Generator::~Generator() {
+}
+
+void Generator::setInputCount(int count) {
+    inputCount = qBound(1, count, int(MAX_INPUTS));
+    if (inputCount > MAX_TARGET_INPUTS)
+        hasTarget = false;
+}
+
+void Generator::setTargetFunction(quint64 truthTable) {
+    if (inputCount > MAX_TARGET_INPUTS)
+        return;
+    hasTarget = true;
+    targetTable = truthTable;
+}
+
+void Generator::clearTargetFunction() {
+    hasTarget = false;
+}
+
+void Generator::setObstacleDensity(int percent) {
+    obstacleDensity = qBound(0, percent, 100);
+}
+
+void Generator::setThreadCount(int count) {
+    threadCount = qMax(1, count);
+}
+
+void Generator::setSeed(quint64 seed) {
+    this->seed = seed;
+}
+
+int Generator::generate(int count) {
+    QElapsedTimer timer;
+    timer.start();
+
+    // Every thread draws from its own stream, derived from the seed and its index.
+    workers.clear();
+    for (int i = 0; i < threadCount; i++) {
+        std::unique_ptr<Worker> worker(new Worker);
+        std::seed_seq streamSeed{quint32(seed), quint32(seed >> 32), quint32(i)};
+        worker->random.seed(streamSeed);
+        workers.push_back(std::move(worker));
+    }
+    levels.clear();
+    wanted = qMax(0, count);
+    candidatesLeft = qint64(wanted) * CANDIDATES_PER_LEVEL;
+    done = wanted == 0;
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < threadCount; i++)
+        threads.emplace_back(&Generator::run, this, i);
+    run(0);
+    for (std::thread& thread : threads)
+        thread.join();
+
+    elapsedMs = timer.elapsed();
+    return levels.size();
+}
+
+QVector<LevelPack::Layout> Generator::getLevels() const {
+    return levels;
+}
+
+bool Generator::writePack(const QString& path) const {
+    return LevelPack::write(path, levels);
+}
+
+Generator::StageStats Generator::getStageStats(Stage stage) const {
+    StageStats total;
+    for (const std::unique_ptr<Worker>& worker : workers) {
+        const StageStats& stats = worker->stats[int(stage)];
+        total.attempts += stats.attempts;
+        total.passed += stats.passed;
+        total.nanoseconds += stats.nanoseconds;
+    }
+    return total;
+}
+
+double Generator::getStageThroughput(Stage stage) const {
+    StageStats stats = getStageStats(stage);
+    if (stats.nanoseconds == 0)
+        return 0;
+    return stats.passed * 1e9 / stats.nanoseconds;
+}
+
+double Generator::getLevelsPerMinute() const {
+    return levels.size() * 60000.0 / qMax<qint64>(1, elapsedMs);
+}
+
+int Generator::getThreadCount() const {
+    return threadCount;
+}
+
+qint64 Generator::getElapsedMs() const {
+    return elapsedMs;
+}
+
+void Generator::run(int index) {
+    Worker& worker = *workers[index];
+    QElapsedTimer timer;
+    while (!done && candidatesLeft-- > 0) {
+        Candidate candidate;
+
+        // Each stage only runs on candidates that passed the one before it.
+        bool passed = true;
+        for (int stage = 0; passed && stage < 3; stage++) {
+            timer.start();
+            if (stage == int(Stage::SYNTHESIS))
+                passed = synthesize(worker.random, candidate);
+            else if (stage == int(Stage::PLACEMENT))
+                passed = place(worker.random, candidate);
+            else
+                passed = validate(candidate);
+            StageStats& stats = worker.stats[stage];
+            stats.nanoseconds += timer.nsecsElapsed();
+            stats.attempts++;
+            if (passed)
+                stats.passed++;
+        }
+        if (!passed)
+            continue;
+
+        std::lock_guard<std::mutex> guard(levelsLock);
+        if (levels.size() < wanted)
+            levels.append(candidate.layout);
+        if (levels.size() >= wanted)
+            done = true;
+    }
+}
+
+bool Generator::synthesize(std::mt19937_64& random, Candidate& candidate) const {
+    QVector<int> inputs;
+    for (int i = 0; i < inputCount; i++)
+        inputs.append(i);
+    candidate.rootSignals = quint32(random()) & ((quint64(1) << inputCount) - 1);
+
+    // Random formulas read each ROOT node exactly once. A target is first matched by drawing
+    // such formulas, which give the plainest circuits.
+    if (!hasTarget) {
+        buildFormula(random, inputs, candidate.terms);
+        candidate.expected = evaluate(candidate.terms, candidate.rootSignals);
+        return true;
+    }
+    quint64 mask = inputCount == MAX_TARGET_INPUTS ? ~quint64(0)
+                                                   : (quint64(1) << (1 << inputCount)) - 1;
+    for (int i = 0; i < SYNTHESIS_TRIES; i++) {
+        candidate.terms.clear();
+        buildFormula(random, inputs, candidate.terms);
+        if ((truthTable(candidate.terms) & mask) == (targetTable & mask)) {
+            candidate.expected = (targetTable >> candidate.rootSignals) & 1;
+            return true;
+        }
+    }
+
+    // Functions like XOR, parity or majority have no such formula, so they are expanded from
+    // the truth table instead.
+    candidate.terms.clear();
+    buildFromTable(random, targetTable & mask, inputCount, candidate.terms);
+    candidate.expected = (targetTable >> candidate.rootSignals) & 1;
+    return true;
+}
+
+void Generator::buildFormula(std::mt19937_64& random, QVector<int> inputs, QVector<Term>& terms) {
+    if (inputs.size() == 1) {
+        terms.append({true, inputs[0], Gate::Operator::AND, -1, -1});
+    }
+    else {
+        // Split the inputs into two non-empty groups joined by an AND or OR gate.
+        std::shuffle(inputs.begin(), inputs.end(), random);
+        int split = 1 + int(random() % quint64(inputs.size() - 1));
+        buildFormula(random, inputs.mid(0, split), terms);
+        int left = int(terms.size()) - 1;
+        buildFormula(random, inputs.mid(split), terms);
+        int right = int(terms.size()) - 1;
+        Gate::Operator op = random() % 2 ? Gate::Operator::AND : Gate::Operator::OR;
+        terms.append({false, -1, op, left, right});
+    }
+
+    // A quarter of the terms are negated. Two NOT gates in a row would cancel out.
+    if (random() % 4 == 0)
+        terms.append({false, -1, Gate::Operator::NOT, int(terms.size()) - 1, -1});
+}
+
+void Generator::buildFromTable(std::mt19937_64& random, quint64 table, int inputCount,
+                               QVector<Term>& terms) {
+    quint64 mask = inputCount == MAX_TARGET_INPUTS ? ~quint64(0)
+                                                   : (quint64(1) << (1 << inputCount)) - 1;
+    QVector<int> order;
+    for (int i = 0; i < inputCount; i++)
+        order.append(i);
+    std::shuffle(order.begin(), order.end(), random);
+
+    // Every subfunction is built once, and each further use fans its output out. Only the
+    // inputs the function reads get a term, so an ignored ROOT node isn't left unwired.
+    QHash<quint64, int> built;
+    auto add = [&](Term term) {
+        terms.append(term);
+        return int(terms.size()) - 1;
+    };
+    auto gate = [&](Gate::Operator op, int left, int right) {
+        return add({false, -1, op, left, right});
+    };
+    auto input = [&](int k) {
+        auto found = built.constFind(COLUMNS[k] & mask);
+        if (found != built.cend())
+            return found.value();
+        int index = add({true, k, Gate::Operator::AND, -1, -1});
+        built.insert(COLUMNS[k] & mask, index);
+        return index;
+    };
+    std::function<int(quint64)> build = [&](quint64 function) {
+        function &= mask;
+        auto found = built.constFind(function);
+        if (found != built.cend())
+            return found.value();
+        for (int k : order) {
+            if (function == (COLUMNS[k] & mask))
+                return input(k);
+            if (function == (~COLUMNS[k] & mask)) {
+                int index = gate(Gate::Operator::NOT, input(k), -1);
+                built.insert(function, index);
+                return index;
+            }
+        }
+
+        // Split on the first input in order the function depends on: low is the function with
+        // the input off, high with it on, both spread over the whole table.
+        int split = -1;
+        quint64 low = 0;
+        quint64 high = 0;
+        for (int k : order) {
+            int shift = 1 << k;
+            low = function & ~COLUMNS[k];
+            low |= low << shift;
+            high = function & COLUMNS[k];
+            high |= high >> shift;
+            if (low != high) {
+                split = k;
+                break;
+            }
+        }
+        int index;
+        if (split < 0) {
+            // A constant still reads a ROOT node, so the END node has a chain to plug into.
+            int x = input(order[0]);
+            index = gate(function ? Gate::Operator::XNOR : Gate::Operator::XOR, x, x);
+        }
+        else {
+            int x = input(split);
+            if (high == (~low & mask))
+                index = gate(Gate::Operator::XOR, x, build(low));
+            else if (low == 0)
+                index = gate(Gate::Operator::AND, x, build(high));
+            else if (high == 0)
+                index = gate(Gate::Operator::NOR, x, build(~low));
+            else if (high == mask)
+                index = gate(Gate::Operator::OR, x, build(low));
+            else if (low == mask)
+                index = gate(Gate::Operator::NAND, x, build(~high));
+            else {
+                int on = gate(Gate::Operator::AND, x, build(high));
+                int off = gate(Gate::Operator::NOR, x, build(~low));
+                index = gate(Gate::Operator::OR, on, off);
+            }
+        }
+        built.insert(function, index);
+        return index;
+    };
+    build(table);
+}
+
+quint64 Generator::truthTable(const QVector<Term>& terms) {
+    return evaluateWords(terms, COLUMNS);
+}
+
+bool Generator::evaluate(const QVector<Term>& terms, quint32 rootSignals) {
+    quint64 inputs[MAX_INPUTS];
+    for (int k = 0; k < MAX_INPUTS; k++)
+        inputs[k] = (rootSignals >> k) & 1 ? ~quint64(0) : 0;
+    return evaluateWords(terms, inputs) & 1;
+}
+
+quint64 Generator::evaluateWords(const QVector<Term>& terms, const quint64* inputs) {
+    QVector<quint64> values(terms.size());
+    for (int i = 0; i < terms.size(); i++) {
+        const Term& term = terms[i];
+        if (term.isInput)
+            values[i] = inputs[term.input];
+        else
+            GateKernels::evaluateBatch(term.op, &values[term.left],
+                                       &values[term.right < 0 ? term.left : term.right],
+                                       nullptr, &values[i], 1);
+    }
+    return values.last();
+}
+
+bool Generator::place(std::mt19937_64& random, Candidate& candidate) const {
+    Level level(nullptr, nullptr, nullptr, width, height);
+    LevelPack::Layout& layout = candidate.layout;
+    layout.width = width;
+    layout.height = height;
+    layout.records.clear();
+
+    // Squares around every node and gate are kept clear so each port has room for a wire.
+    QVector<bool> reserved(width * height, false);
+    auto isFree = [&](int x, int y) {
+        return x >= 0 && x < width && y >= 0 && y < height && !reserved[y * width + x];
+    };
+    auto reserve = [&](int x, int y) {
+        static const int offsetX[5] = {0, 0, 1, 0, -1};
+        static const int offsetY[5] = {0, -1, 0, 1, 0};
+        for (int i = 0; i < 5; i++) {
+            int nextX = x + offsetX[i];
+            int nextY = y + offsetY[i];
+            if (nextX >= 0 && nextX < width && nextY >= 0 && nextY < height)
+                reserved[nextY * width + nextX] = true;
+        }
+    };
+    // Wires can't cross, so the formula is laid out like a tree: ROOT nodes in one column in the
+    // order the formula reads them, each gate one column past its deepest input and level with
+    // its inputs, and the END node last. Terms read more than once fan out through junctions
+    // and are routed around the rest. The layout is drawn facing a random way.
+    const QVector<Term>& terms = candidate.terms;
+    QVector<int> depths(terms.size(), 0);
+    for (int i = 0; i < terms.size(); i++) {
+        if (!terms[i].isInput) {
+            depths[i] = depths[terms[i].left] + 1;
+            if (terms[i].right >= 0)
+                depths[i] = qMax(depths[i], depths[terms[i].right] + 1);
+        }
+    }
+    int endDepth = depths.last() + 1;
+    Gate::Direction facing = Gate::Direction(random() % 4);
+    bool alongX = facing == Gate::Direction::EAST || facing == Gate::Direction::WEST;
+    int columns = alongX ? width : height;
+    int rows = alongX ? height : width;
+    auto toBoard = [&](int column, int row) {
+        switch (facing) {
+        case Gate::Direction::EAST :
+            return QPoint(column, row);
+        case Gate::Direction::WEST :
+            return QPoint(width - 1 - column, row);
+        case Gate::Direction::SOUTH :
+            return QPoint(row, column);
+        default :
+            return QPoint(row, height - 1 - column);
+        }
+    };
+
+    // Columns are at least two apart so every port faces an empty square, and ROOT rows are
+    // at least two apart so every ROOT node has a free side.
+    int spacing = (columns - 1) / endDepth;
+    int rowSlack = rows - (2 * inputCount - 1);
+    if (spacing < 2 || rowSlack < 0)
+        return false;
+    std::uniform_int_distribution<int> columnJitter(0, spacing - 2);
+    int firstColumn = int(random() % quint64(columns - endDepth * spacing));
+    QVector<int> rowGaps;
+    for (int i = 0; i < inputCount; i++)
+        rowGaps.append(int(random() % quint64(rowSlack + 1)));
+    std::sort(rowGaps.begin(), rowGaps.end());
+
+    QVector<QPoint> positions(terms.size());
+    QVector<int> termRows(terms.size());
+    QString allTags;
+    int inputsPlaced = 0;
+    auto placeAt = [&](int column, int row, bool twoHalves, QPoint& placed) {
+        // Matches the second half offset of Level::calculateGateOffset.
+        static const int halfX[4] = {-1, 0, 1, 0};
+        static const int halfY[4] = {0, -1, 0, 1};
+        QPoint half = twoHalves ? QPoint(halfX[int(facing)], halfY[int(facing)]) : QPoint(0, 0);
+        for (int tries = 0; tries < PLACEMENT_TRIES; tries++) {
+            // Nudge the square when the exact spot is taken.
+            int nudgedColumn = column;
+            int nudgedRow = row;
+            if (tries > 0) {
+                nudgedColumn += int(random() % 3) - 1;
+                nudgedRow += int(random() % 3) - 1;
+            }
+            QPoint square = toBoard(nudgedColumn, nudgedRow);
+            if (nudgedColumn < 0 || nudgedColumn >= columns || nudgedRow < 0 || nudgedRow >= rows
+                || !isFree(square.x(), square.y())
+                || !isFree(square.x() + half.x(), square.y() + half.y()))
+                continue;
+            reserve(square.x(), square.y());
+            reserve(square.x() + half.x(), square.y() + half.y());
+            placed = square;
+            return true;
+        }
+        return false;
+    };
+    for (int i = 0; i < terms.size(); i++) {
+        const Term& term = terms[i];
+        int column = firstColumn + depths[i] * spacing;
+        if (term.isInput) {
+            termRows[i] = 2 * inputsPlaced + rowGaps[inputsPlaced];
+            inputsPlaced++;
+        }
+        else {
+            column += columnJitter(random);
+            termRows[i] = term.right < 0 ? termRows[term.left]
+                                         : (termRows[term.left] + termRows[term.right]) / 2;
+        }
+        bool twoHalves = !term.isInput && term.op != Gate::Operator::NOT;
+        if (!placeAt(column, termRows[i], twoHalves, positions[i]))
+            return false;
+        int x = positions[i].x();
+        int y = positions[i].y();
+
+        if (term.isInput) {
+            LevelPack::Record root{LevelPack::Kind::ROOT, x, y};
+            root.signal = (candidate.rootSignals >> term.input) & 1;
+            root.tag = Tag::fromString(rootTag(term.input));
+            level.setNode(x, y, root.signal, rootTag(term.input), Node::Type::ROOT);
+            layout.records.append(root);
+            allTags.append(rootTag(term.input));
+        }
+        else {
+            LevelPack::Record gate{LevelPack::Kind::GATE, x, y};
+            gate.op = term.op;
+            gate.direction = facing;
+            level.drawGate(x, y, term.op, facing);
+            layout.records.append(gate);
+        }
+    }
+    QPoint endSquare;
+    if (!placeAt(firstColumn + endDepth * spacing, termRows.last(), false, endSquare))
+        return false;
+    int endX = endSquare.x();
+    int endY = endSquare.y();
+    LevelPack::Record end{LevelPack::Kind::END, endX, endY};
+    end.signal = candidate.expected;
+    end.tag = Tag::fromString(allTags);
+    level.setNode(endX, endY, end.signal, end.tag.toString(), Node::Type::END);
+    layout.records.append(end);
+
+    // Wire every step from its inputs, so each gate output is live before it is routed on.
+    Router router(&level);
+    router.setKeepPortsClear(true);
+    QVector<QVector<QPoint>> drawn(terms.size());
+    auto route = [&](int source, int targetX, int targetY) {
+        QPoint from = positions[source];
+        Tag tag = terms[source].isInput ? Tag::fromString(rootTag(terms[source].input))
+                      : level.getGate(from.x(), from.y())->getTag();
+
+        // A source that is already wired branches off one of its wires, nearest first.
+        QVector<QPoint> starts = {from};
+        if (!drawn[source].isEmpty()) {
+            starts = drawn[source];
+            auto distance = [&](QPoint square) {
+                return qAbs(square.x() - targetX) + qAbs(square.y() - targetY);
+            };
+            std::sort(starts.begin(), starts.end(), [&](QPoint first, QPoint second) {
+                return distance(first) < distance(second);
+            });
+        }
+        QVector<QPoint> squares;
+        bool found = false;
+        for (int i = 0; !found && i < starts.size(); i++)
+            found = router.findRoute(starts[i].x(), starts[i].y(), targetX, targetY, tag, squares);
+        if (!found)
+            return false;
+        for (const QPoint& square : squares) {
+            level.drawWire(square.x(), square.y(), tag);
+            candidate.solution.append({square.x(), square.y(), tag});
+        }
+        drawn[source] += squares;
+        return true;
+    };
+    candidate.solution.clear();
+    for (int i = 0; i < terms.size(); i++) {
+        const Term& term = terms[i];
+        if (term.isInput)
+            continue;
+        if (term.op == Gate::Operator::NOT) {
+            if (!route(term.left, positions[i].x(), positions[i].y()))
+                return false;
+            continue;
+        }
+
+        // Each input goes to the nearer half, so the two wires don't cross.
+        Node* otherInput = level.getGate(positions[i].x(), positions[i].y())->getOtherHalf()
+                               ->getInputNode();
+        QPoint first = positions[i];
+        QPoint second(otherInput->getX(), otherInput->getY());
+        auto distance = [](QPoint a, QPoint b) {
+            return qAbs(a.x() - b.x()) + qAbs(a.y() - b.y());
+        };
+        int left = term.left;
+        int right = term.right;
+        if (distance(positions[left], second) + distance(positions[right], first)
+            < distance(positions[left], first) + distance(positions[right], second))
+            std::swap(left, right);
+        if (!route(left, first.x(), first.y()) || !route(right, second.x(), second.y()))
+            return false;
+    }
+    if (!route(int(terms.size()) - 1, endX, endY) || !isSolved(&level))
+        return false;
+
+    // Block part of the squares the solution doesn't use, one record per run of a row.
+    std::uniform_int_distribution<int> percent(0, 99);
+    for (int y = 0; y < height; y++) {
+        int runStart = -1;
+        for (int x = 0; x <= width; x++) {
+            bool block = x < width && level.getComponent(x, y) == Level::Component::NONE
+                         && percent(random) < obstacleDensity;
+            if (block && runStart < 0)
+                runStart = x;
+            else if (!block && runStart >= 0) {
+                LevelPack::Record obstacles{LevelPack::Kind::OBSTACLES, runStart, y};
+                obstacles.width = x - runStart;
+                layout.records.append(obstacles);
+                runStart = -1;
+            }
+        }
+    }
+    return true;
+}
+
+bool Generator::validate(const Candidate& candidate) const {
+    Level level(nullptr, nullptr, nullptr, width, height);
+    level.loadLayout(candidate.layout);
+    if (isSolved(&level))
+        return false;
+    for (const Move& move : candidate.solution)
+        level.drawWire(move.x, move.y, move.tag);
+    return isSolved(&level);
+}
+
+bool Generator::isSolved(Level* level) {
+    for (Node* node : level->getNodes()) {
+        if (!node->getConnected())
+            return false;
+    }
+    return true;
+}
+
+QString Generator::rootTag(int input) {
+    return QString(Tag::charOf(Tag::idOf('A') + input));
+}
@@ -0,0 +1,397 @@
+/**
+ * This class generates levels. Each candidate goes through three stages.
+ * Synthesis builds a formula over the ROOT nodes that computes a target
+ * Boolean function, or a random one, and picks the ROOT signals and the
+ * END node signal. Random formulas are trees of AND, OR and NOT gates
+ * reading each ROOT node once. A target no such formula computes is
+ * expanded from its truth table with AND, OR, XOR, NAND, NOR and NOT
+ * gates, and every subformula it reuses fans out through a junction.
+ * Placement lays the formula out like a tree on an empty headless level,
+ * routes every wire, and fills part of the unused squares with
+ * obstacles. Validation rebuilds
+ * the level from its encoded layout and replays the routed wires square
+ * by square with drawWire, so only levels proven winnable are kept.
+ * Threads generate candidates independently, each with its own random
+ * stream, and the time and pass rate of every stage are recorded.
+ *
+ * @authors Max Donaldson, Jason Khong,
+ * Ariadne Petroulakis, Evan Tucker, and Ian Weller
+ *
+ * @version 22 April 2025
+ */
+
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <QPoint>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+#include "gate.h"
+#include "levelpack.h"
+#include "tag.h"
+
+class Level;
+
+class Generator {
+
+public:
+    /**
+     * @brief The Stage enum - The steps a candidate level goes through.
+     */
+    enum class Stage {
+        SYNTHESIS, PLACEMENT, VALIDATION
+    };
+
+    /**
+     * @brief The StageStats struct - How often a stage ran, passed, and how long it took,
+     * summed over all threads.
+     */
+    struct StageStats {
+        qint64 attempts = 0;
+        qint64 passed = 0;
+        qint64 nanoseconds = 0;
+    };
+
+    /**
+     * @brief MAX_INPUTS - The most ROOT nodes a level can have.
+     */
+    static const int MAX_INPUTS = 26;
+
+    /**
+     * @brief MAX_TARGET_INPUTS - The most ROOT nodes a target function can be given over,
+     * so its truth table fits one 64-bit word.
+     */
+    static const int MAX_TARGET_INPUTS = 6;
+
+    /**
+     * @brief Generator - Creates a generator of random three-input levels.
+     * @param width - The board width of the levels.
+     * @param height - The board height of the levels.
+     */
+    Generator(int width, int height);
+
+    ~Generator();
+
+    /**
+     * @brief setInputCount - Sets how many ROOT nodes each level has.
+     * @param count - The input count, from 1 to MAX_INPUTS.
+     */
+    void setInputCount(int count);
+
+    /**
+     * @brief setTargetFunction - Makes every level compute the given function of its ROOT
+     * nodes. Bit i of the truth table is the output when ROOT k carries bit k of i, with ROOT 0
+     * being "A".
+     * @param truthTable - The truth table over the current input count, which must be at most
+     * MAX_TARGET_INPUTS. Any function can be built, constants included. ROOT nodes the function
+     * ignores are left off the levels.
+     */
+    void setTargetFunction(quint64 truthTable);
+
+    /**
+     * @brief clearTargetFunction - Goes back to a random function for every level.
+     */
+    void clearTargetFunction();
+
+    /**
+     * @brief setObstacleDensity - Sets the share of unused squares that get obstacles.
+     * @param percent - From 0 to 100.
+     */
+    void setObstacleDensity(int percent);
+
+    /**
+     * @brief setThreadCount - Sets how many threads generate. Defaults to one per core.
+     * @param count - The thread count, at least one.
+     */
+    void setThreadCount(int count);
+
+    /**
+     * @brief setSeed - Sets the seed the random stream of every thread is derived from.
+     * @param seed - The seed.
+     */
+    void setSeed(quint64 seed);
+
+    /**
+     * @brief generate - Generates levels until count pass validation or too many candidates
+     * have failed. Earlier levels are discarded.
+     * @param count - The number of levels wanted.
+     * @return The number of levels generated.
+     */
+    int generate(int count);
+
+    /**
+     * @brief getLevels - Getter for the levels of the last generate call.
+     * @return The layouts, ready for a level pack.
+     */
+    QVector<LevelPack::Layout> getLevels() const;
+
+    /**
+     * @brief writePack - Writes the levels of the last generate call to a level pack.
+     * @param path - The path of the pack.
+     * @return False if the file can't be written.
+     */
+    bool writePack(const QString& path) const;
+
+    /**
+     * @brief getStageStats - Getter for the counters of one stage in the last generate call.
+     * @param stage - The stage.
+     * @return The counters.
+     */
+    StageStats getStageStats(Stage stage) const;
+
+    /**
+     * @brief getStageThroughput - Gets how many candidates a stage passes per second of
+     * thread time.
+     * @param stage - The stage.
+     * @return The candidates passed per second, or 0 if the stage never ran.
+     */
+    double getStageThroughput(Stage stage) const;
+
+    /**
+     * @brief getLevelsPerMinute - Gets the wall-clock rate of the last generate call.
+     * @return The levels generated per minute.
+     */
+    double getLevelsPerMinute() const;
+
+    /**
+     * @brief getThreadCount - Getter for the number of threads used.
+     * @return The thread count.
+     */
+    int getThreadCount() const;
+
+    /**
+     * @brief getElapsedMs - Getter for the wall time of the last generate call.
+     * @return The time in milliseconds.
+     */
+    qint64 getElapsedMs() const;
+
+private:
+    /**
+     * @brief The Term struct - One step of a formula. Inputs have no operator, every other
+     * term is a gate over earlier terms.
+     */
+    struct Term {
+        bool isInput;
+        int input;
+        Gate::Operator op;
+        int left;
+        int right;
+    };
+
+    /**
+     * @brief The Move struct - One drawWire call of the routed solution.
+     */
+    struct Move {
+        int x;
+        int y;
+        Tag tag;
+    };
+
+    /**
+     * @brief The Candidate struct - A level being generated.
+     */
+    struct Candidate {
+        QVector<Term> terms;
+        quint32 rootSignals;
+        bool expected;
+        LevelPack::Layout layout;
+        QVector<Move> solution;
+    };
+
+    /**
+     * @brief The Worker struct - The random stream and stage counters of one thread.
+     */
+    struct Worker {
+        std::mt19937_64 random;
+        StageStats stats[3];
+    };
+
+    /**
+     * @brief SYNTHESIS_TRIES - The random formulas tried per candidate to match a target before
+     * it is built from its truth table.
+     */
+    static const int SYNTHESIS_TRIES = 256;
+
+    /**
+     * @brief PLACEMENT_TRIES - The squares around its spot in the tree tried per node or gate
+     * before placement gives up.
+     */
+    static const int PLACEMENT_TRIES = 32;
+
+    /**
+     * @brief CANDIDATES_PER_LEVEL - The failed candidates allowed per level wanted before
+     * generate gives up.
+     */
+    static const int CANDIDATES_PER_LEVEL = 1000;
+
+    /**
+     * @brief width - The board width.
+     */
+    int width;
+
+    /**
+     * @brief height - The board height.
+     */
+    int height;
+
+    /**
+     * @brief inputCount - The number of ROOT nodes per level.
+     */
+    int inputCount;
+
+    /**
+     * @brief hasTarget - Whether levels compute targetTable rather than a random function.
+     */
+    bool hasTarget;
+
+    /**
+     * @brief targetTable - The truth table of the target function.
+     */
+    quint64 targetTable;
+
+    /**
+     * @brief obstacleDensity - The percent of unused squares that get obstacles.
+     */
+    int obstacleDensity;
+
+    /**
+     * @brief threadCount - The number of generating threads.
+     */
+    int threadCount;
+
+    /**
+     * @brief seed - The seed of the random streams.
+     */
+    quint64 seed;
+
+    /**
+     * @brief elapsedMs - The wall time of the last generate call.
+     */
+    qint64 elapsedMs;
+
+    /**
+     * @brief workers - One per generating thread.
+     */
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    /**
+     * @brief levels - The generated levels. Guarded by levelsLock while generating.
+     */
+    QVector<LevelPack::Layout> levels;
+
+    /**
+     * @brief levelsLock - Guards levels.
+     */
+    std::mutex levelsLock;
+
+    /**
+     * @brief wanted - The number of levels the current generate call wants.
+     */
+    int wanted;
+
+    /**
+     * @brief candidatesLeft - Candidates that may still be tried before giving up.
+     */
+    std::atomic<qint64> candidatesLeft;
+
+    /**
+     * @brief done - Set once enough levels are generated.
+     */
+    std::atomic<bool> done;
+
+    /**
+     * @brief run - The loop of one generating thread.
+     * @param index - The worker index.
+     */
+    void run(int index);
+
+    /**
+     * @brief synthesize - Builds the formula of a candidate and picks its signals.
+     * @param random - The random stream of the thread.
+     * @param candidate - Receives the formula, ROOT signals and expected END signal.
+     * @return True. Every target can be built, so synthesis doesn't fail.
+     */
+    bool synthesize(std::mt19937_64& random, Candidate& candidate) const;
+
+    /**
+     * @brief buildFormula - Appends a random formula that reads each of the given inputs once.
+     * @param random - The random stream of the thread.
+     * @param inputs - The inputs still to be read.
+     * @param terms - Receives the terms. The last one appended is the formula's output.
+     */
+    static void buildFormula(std::mt19937_64& random, QVector<int> inputs, QVector<Term>& terms);
+
+    /**
+     * @brief buildFromTable - Appends a formula computing a truth table, built by splitting on
+     * one input at a time in a random order. Each half that is a constant, an input, or the
+     * other half negated becomes a single gate, and every subfunction is built only once.
+     * @param random - The random stream of the thread.
+     * @param table - The truth table, with the bits past 2^inputCount clear.
+     * @param inputCount - The number of inputs, at most MAX_TARGET_INPUTS.
+     * @param terms - Receives the terms. The last one appended is the formula's output.
+     */
+    static void buildFromTable(std::mt19937_64& random, quint64 table, int inputCount,
+                               QVector<Term>& terms);
+
+    /**
+     * @brief truthTable - Evaluates a formula on every assignment of at most
+     * MAX_TARGET_INPUTS inputs at once.
+     * @param terms - The formula.
+     * @return The truth table.
+     */
+    static quint64 truthTable(const QVector<Term>& terms);
+
+    /**
+     * @brief evaluate - Evaluates a formula on one assignment.
+     * @param terms - The formula.
+     * @param rootSignals - Bit k holds the signal of ROOT k.
+     * @return The output.
+     */
+    static bool evaluate(const QVector<Term>& terms, quint32 rootSignals);
+
+    /**
+     * @brief evaluateWords - Evaluates a formula on 64 assignments at once, through the batched
+     * gate kernels.
+     * @param terms - The formula.
+     * @param inputs - The 64 lanes of each input.
+     * @return The lanes of the output.
+     */
+    static quint64 evaluateWords(const QVector<Term>& terms, const quint64* inputs);
+
+    /**
+     * @brief place - Places and wires a candidate on an empty level, then records its layout
+     * and the routed solution.
+     * @param random - The random stream of the thread.
+     * @param candidate - The synthesized candidate. Receives the layout and solution.
+     * @return False if the tree doesn't fit the board or a wire couldn't be routed.
+     */
+    bool place(std::mt19937_64& random, Candidate& candidate) const;
+
+    /**
+     * @brief validate - Rebuilds a candidate from its layout and replays its solution.
+     * @param candidate - The placed candidate.
+     * @return True if the replay wins the level.
+     */
+    bool validate(const Candidate& candidate) const;
+
+    /**
+     * @brief isSolved - Checks whether every node of a level is connected.
+     * @param level - The level.
+     * @return True if the level is won.
+     */
+    static bool isSolved(Level* level);
+
+    /**
+     * @brief rootTag - Gets the tag of a ROOT node.
+     * @param input - The input index of the ROOT node.
+     * @return The tag, "A" for input 0.
+     */
+    static QString rootTag(int input);
+};
+
+#endif // GENERATOR_H
@@ -0,0 +1,165 @@
+#include "journal.h"
+#include "level.h"
+
+Journal::Journal(Level* level)
+    : level(level), applied(0), depth(0), current{0, 0, 0, false}, currentRecorded(false) {
+}
+
+void Journal::begin() {
+    if (depth++ > 0)
+        return;
+    current = {static_cast<int>(entries.size()), 0, level->unconnectedNodes, level->isVictory};
+    currentRecorded = false;
+    level->wirePool.setJournal(this);
+}
+
+void Journal::end() {
+    if (depth == 0 || --depth > 0)
+        return;
+    level->wirePool.setJournal(nullptr);
+    if (!currentRecorded)
+        return;
+    current.entryCount = entries.size() - current.firstEntry;
+    transactions.append(current);
+    applied++;
+}
+
+bool Journal::isRecording() {
+    return depth > 0;
+}
+
+bool Journal::undo() {
+    if (!canUndo())
+        return false;
+    Transaction& transaction = transactions[--applied];
+    for (int i = transaction.firstEntry + transaction.entryCount - 1;
+         i >= transaction.firstEntry; i--)
+        apply(entries[i], true);
+    swapVictory(transaction);
+    return true;
+}
+
+bool Journal::redo() {
+    if (!canRedo())
+        return false;
+    Transaction& transaction = transactions[applied++];
+    for (int i = transaction.firstEntry; i < transaction.firstEntry + transaction.entryCount; i++)
+        apply(entries[i], false);
+    swapVictory(transaction);
+    return true;
+}
+
+bool Journal::canUndo() {
+    return depth == 0 && applied > 0;
+}
+
+bool Journal::canRedo() {
+    return depth == 0 && applied < transactions.size();
+}
+
+void Journal::clear() {
+    discardFrom(0);
+    transactions.clear();
+    applied = 0;
+    currentRecorded = false;
+}
+
+void Journal::recordWire(Wire* wire) {
+    if (!prepareEntry())
+        return;
+    entries.append({Kind::WIRE, 0, 0, wire->getId(), nullptr, Bus(), Bus(), *wire});
+    level->markCellDirty(wire->getX(), wire->getY());
+}
+
+void Journal::recordPlace(int x, int y, Wire::Id id) {
+    if (!prepareEntry())
+        return;
+    entries.append({Kind::PLACE, x, y, id, nullptr, Bus(), Bus(), Wire()});
+}
+
+void Journal::recordRemove(int x, int y, Wire::Id id) {
+    if (!prepareEntry())
+        return;
+    entries.append({Kind::REMOVE, x, y, id, nullptr, Bus(), Bus(), Wire()});
+}
+
+void Journal::recordGateState(Gate* gate) {
+    if (!prepareEntry())
+        return;
+    entries.append({Kind::GATE_STATE, 0, 0, Wire::NULL_ID, gate, gate->getState(),
+                    gate->getLastControl(), Wire()});
+}
+
+void Journal::apply(Entry& entry, bool undoing) {
+    switch (entry.kind) {
+    case Kind::WIRE : {
+        Wire* wire = level->wirePool.get(entry.id);
+        std::swap(*wire, entry.record);
+        level->markCellDirty(wire->getX(), wire->getY());
+        level->propagator.markEdited(wire);
+        break;
+    }
+    case Kind::PLACE :
+        if (undoing)
+            level->detachWire(entry.x, entry.y);
+        else
+            level->attachWire(entry.x, entry.y, entry.id);
+        break;
+    case Kind::REMOVE :
+        if (undoing)
+            level->attachWire(entry.x, entry.y, entry.id);
+        else
+            level->detachWire(entry.x, entry.y);
+        break;
+    case Kind::GATE_STATE : {
+        // Nothing is recording while undoing or redoing, so setState doesn't log this.
+        Bus state = entry.gate->getState();
+        Bus lastControl = entry.gate->getLastControl();
+        entry.gate->setState(entry.state, entry.lastControl);
+        entry.state = state;
+        entry.lastControl = lastControl;
+        break;
+    }
+    }
+}
+
+void Journal::swapVictory(Transaction& transaction) {
+    std::swap(level->unconnectedNodes, transaction.unconnectedNodes);
+    std::swap(level->isVictory, transaction.isVictory);
+
+    // Keep the confetti in step with the victory being undone or redone.
+    if (transaction.isVictory && !level->isVictory)
+        level->removeConfetti();
+    else if (!transaction.isVictory && level->isVictory)
+        level->spawnConfetti();
+}
+
+bool Journal::prepareEntry() {
+    if (depth == 0)
+        return false;
+    if (currentRecorded)
+        return true;
+
+    // The edit replaces whatever could still be redone, now that it changes something.
+    if (applied < transactions.size()) {
+        discardFrom(transactions[applied].firstEntry);
+        transactions.resize(applied);
+    }
+    current.firstEntry = entries.size();
+    currentRecorded = true;
+    return true;
+}
+
+void Journal::discardFrom(int firstEntry) {
+    for (int i = firstEntry; i < entries.size(); i++) {
+        const Entry& entry = entries[i];
+        if (entry.kind != Kind::PLACE && entry.kind != Kind::REMOVE)
+            continue;
+
+        // Wires off the board are only still allocated so this history could bring them back.
+        Wire* wire = level->wirePool.get(entry.id);
+        if (wire->getPool() != nullptr && !level->isWireOnBoard(entry.id))
+            level->wirePool.release(entry.id);
+    }
+    entries.resize(firstEntry);
+}
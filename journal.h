@@ -0,0 +1,213 @@
+/**
+ * This class records the edits made to a level so they can be undone
+ * and redone. Every change to a wire record, every wire placed on or
+ * taken off the board and every change to the state of a flip-flop, latch
+ * or clock is logged with enough state to swap it back, so undoing or
+ * redoing costs the size of the edit rather than a rebuild of the level.
+ * Edits are grouped into transactions.
+ *
+ * @authors Max Donaldson, Jason Khong,
+ * Ariadne Petroulakis, Evan Tucker, and Ian Weller
+ *
+ * @version 22 April 2025
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <QVector>
+#include "wire.h"
+
+class Level;
+class Gate;
+
+class Journal {
+
+public:
+    /**
+     * @brief Journal - Creates an empty journal.
+     * @param level - The level whose edits are recorded.
+     */
+    explicit Journal(Level* level);
+
+    /**
+     * @brief begin - Opens a transaction. Transactions nest; only the outermost one becomes an
+     * undo step. Anything that could still be redone is dropped once the transaction records
+     * its first entry, so an edit that changes nothing keeps the redo history.
+     */
+    void begin();
+
+    /**
+     * @brief end - Closes a transaction. An outermost transaction that recorded nothing is
+     * dropped. Calls without a matching begin are ignored.
+     */
+    void end();
+
+    /**
+     * @brief isRecording - Checks if a transaction is open.
+     * @return True while edits are being recorded.
+     */
+    bool isRecording();
+
+    /**
+     * @brief undo - Reverts the most recent transaction.
+     * @return True if a transaction was undone. Nothing is undone while recording.
+     */
+    bool undo();
+
+    /**
+     * @brief redo - Reapplies the most recently undone transaction.
+     * @return True if a transaction was redone. Nothing is redone while recording.
+     */
+    bool redo();
+
+    /**
+     * @brief canUndo - Checks if there is a transaction to undo.
+     * @return True if undo() would do something.
+     */
+    bool canUndo();
+
+    /**
+     * @brief canRedo - Checks if there is a transaction to redo.
+     * @return True if redo() would do something.
+     */
+    bool canRedo();
+
+    /**
+     * @brief clear - Forgets the whole history, keeping the level as it is. Wires only kept
+     * alive for the history are released.
+     */
+    void clear();
+
+    /**
+     * @brief recordWire - Logs the state of a wire before it changes.
+     * @param wire - The wire about to change.
+     */
+    void recordWire(Wire* wire);
+
+    /**
+     * @brief recordPlace - Logs a wire being placed on the board.
+     * @param x - The x position on the grid.
+     * @param y - The y position on the grid.
+     * @param id - The id of the wire placed.
+     */
+    void recordPlace(int x, int y, Wire::Id id);
+
+    /**
+     * @brief recordRemove - Logs a wire being taken off the board.
+     * @param x - The x position on the grid.
+     * @param y - The y position on the grid.
+     * @param id - The id of the wire removed.
+     */
+    void recordRemove(int x, int y, Wire::Id id);
+
+    /**
+     * @brief recordGateState - Logs the state and last control input of a gate before they
+     * change.
+     * @param gate - The gate about to change.
+     */
+    void recordGateState(Gate* gate);
+
+private:
+    /**
+     * @brief The Kind enum - What a journal entry records.
+     */
+    enum class Kind : quint8 {
+        WIRE, PLACE, REMOVE, GATE_STATE
+    };
+
+    /**
+     * @brief The Entry struct - One recorded change. WIRE entries hold the wire record from the
+     * other side of the change, PLACE and REMOVE entries the square and wire id, and
+     * GATE_STATE entries the gate and its state and last control input from the other side.
+     */
+    struct Entry {
+        Kind kind;
+        int x;
+        int y;
+        Wire::Id id;
+        Gate* gate;
+        Bus state;
+        Bus lastControl;
+        Wire record;
+    };
+
+    /**
+     * @brief The Transaction struct - A run of entries undone and redone together, plus the
+     * level's victory bookkeeping from the other side of the transaction.
+     */
+    struct Transaction {
+        int firstEntry;
+        int entryCount;
+        int unconnectedNodes;
+        bool isVictory;
+    };
+
+    /**
+     * @brief level - The level being recorded.
+     */
+    Level* level;
+
+    /**
+     * @brief entries - Every recorded change, oldest first.
+     */
+    QVector<Entry> entries;
+
+    /**
+     * @brief transactions - Every closed transaction, oldest first.
+     */
+    QVector<Transaction> transactions;
+
+    /**
+     * @brief applied - The number of transactions currently applied. Those after it can be
+     * redone.
+     */
+    int applied;
+
+    /**
+     * @brief depth - The nesting depth of open transactions.
+     */
+    int depth;
+
+    /**
+     * @brief current - The outermost open transaction. It joins transactions when it closes,
+     * if it recorded anything.
+     */
+    Transaction current;
+
+    /**
+     * @brief currentRecorded - Whether the open transaction has recorded an entry yet.
+     */
+    bool currentRecorded;
+
+    /**
+     * @brief apply - Swaps the level and an entry across the recorded change.
+     * @param entry - The entry to apply.
+     * @param undoing - True when undoing, false when redoing.
+     */
+    void apply(Entry& entry, bool undoing);
+
+    /**
+     * @brief swapVictory - Swaps the level's victory bookkeeping with a transaction's, adding or
+     * removing the confetti if the victory itself changed.
+     * @param transaction - The transaction being undone or redone.
+     */
+    void swapVictory(Transaction& transaction);
+
+    /**
+     * @brief prepareEntry - Readies the journal for an entry of the open transaction. The first
+     * entry drops anything that could still be redone, so the transaction starts where the
+     * applied ones end.
+     * @return False if no transaction is open and nothing should be recorded.
+     */
+    bool prepareEntry();
+
+    /**
+     * @brief discardFrom - Drops every entry from an index on, releasing the wires that were
+     * only kept alive for those entries.
+     * @param firstEntry - The index of the first entry to drop.
+     */
+    void discardFrom(int firstEntry);
+};
+
+#endif // JOURNAL_H
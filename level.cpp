@@ -1,351 +1,502 @@
 #include "level.h"
+#include "gatekernels.h"
 #include "wire.h"
+#include <QtAlgorithms>
 
-enum class Component;
 class Wire;
 
-Level::Level(QGraphicsScene* graphicsScene, b2World* box2DWorld, QObject *parent)
-    : QObject{parent},box2DWorld(box2DWorld), graphicsScene(graphicsScene), isVictory(false) {
-    confetti = new Confetti(graphicsScene, box2DWorld);
+Level::Level(QGraphicsScene* graphicsScene, b2World* box2DWorld, QObject *parent,
+             int width, int height)
+    : QObject{parent},box2DWorld(box2DWorld), graphicsScene(graphicsScene), isVictory(false),
+    unconnectedNodes(0), grid(width, height), obstacles(width, height), occupied(width, height),
+    propagator(this), journal(this), router(this), allDirty(true) {
+    confetti = graphicsScene ? new Confetti(graphicsScene, box2DWorld) : nullptr;
+}
 
-    // Initializes the grids to nullptrs.
-    for (int i = 0; i < WIDTH * HEIGHT; i++) {
-        wireGrid[i] = nullptr;
-        gateGrid[i] = nullptr;
-        nodeGrid[i] = nullptr;
-        obstacleGrid[i] = nullptr;
-    }
+int Level::getWidth() {
+    return grid.getWidth();
+}
+
+int Level::getHeight() {
+    return grid.getHeight();
+}
+
+void Level::resize(int width, int height) {
+    clearLevel();
+    grid.resize(width, height);
+    obstacles = ObstacleLayer(width, height);
+    occupied = ObstacleLayer(width, height);
 }
 
 Level::~Level() {
-    for (int i = 0; i < WIDTH * HEIGHT; i++) {
-        delete wireGrid[i];
-        delete gateGrid[i];
-        delete nodeGrid[i];
-        delete obstacleGrid[i];
-    }
+    journal.clear();
+    for (Wire::Id wire : wires)
+        wirePool.release(wire);
+    for (Gate* gate : gates)
+        delete gate;
+    for (Node* node : nodes)
+        delete node;
     if (confetti) {
         delete confetti;
     }
 }
 
-void Level::drawWire(int x, int y, QString tag) {
-    if ((x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT)
-        || tag == "") {
+void Level::drawWire(int x, int y, Tag tag) {
+    if (!grid.contains(x, y) || tag.isEmpty()) {
         return;
     }
+    journal.begin();
     Wire* currentWire = getWire(x, y);
     if (isEmptySpace(x, y)) {
-        // Search for surrounding grid elements and initialize directions:
-        Wire::Direction wireConnectionDirection = Wire::Direction::NONE;
-        Wire::Direction nodeConnectionDirection = Wire::Direction::NONE;
-        Wire::Direction gateConnectionDirection = Wire::Direction::NONE;
-        Wire* currentWire = nullptr;
-        Wire* headWire = findWire(x, y, tag, wireConnectionDirection);
-        Node* headNode = findOutputNode(x, y, tag, nodeConnectionDirection);
-        Gate* headGate = findOutputGate(x, y, tag, gateConnectionDirection);
-
-        // Create a new wire at the (x, y) coords if a connection was found:
-        if (headWire || headNode || headGate) {
-            currentWire = new Wire();
-            setWire(x, y, currentWire);
-
-            // Head connection:
-            if (headWire)
-                headWire->connectTail(currentWire, wireConnectionDirection);
-            else if (headNode && headNode->getNodeType() == Node::Type::ROOT)
-                headNode->connectWire(currentWire, nodeConnectionDirection);
-            else if (headGate && headGate->getAlignment() == Gate::Ports::INOUT)
-                headGate->connectWire(currentWire, gateConnectionDirection);
-
-            // Tail connection (Note: tails should only be made if the currentWire has a head):
-            Node* tailNode = findInputNode(x, y, tag, currentWire->getSignal(),
-                                           nodeConnectionDirection);
-            Gate* tailGate = findInputGate(x, y, gateConnectionDirection);
-            if (tailNode)
-               tailNode->connectWire(currentWire, nodeConnectionDirection);
-            else if (tailGate)
-                tailGate->connectWire(currentWire, gateConnectionDirection);
-        }
+        placeWire(x, y, tag);
     }
-    else if (currentWire && currentWire->getTailConnection() != nullptr
-             && currentWire->getTailConnection()->getTailConnection() == nullptr) {
+    else if (currentWire && findOpenTail(currentWire)) {
         // Is this wire directly connected to an incomplete end?
         // If so, "go back" one wire.
         wireRemove(currentWire);
     }
+    propagateSignals();
     victory();
+    journal.end();
 }
 
-Wire* Level::findWire(int x, int y, QString tag, Wire::Direction& wireConnectionDirection) {
-    Wire* upWire = getWire(x, y - 1);
-    Wire* rightWire = getWire(x + 1, y);
-    Wire* downWire = getWire(x, y + 1);
-    Wire* leftWire = getWire(x - 1, y);
+bool Level::routeWire(int sourceX, int sourceY, int targetX, int targetY, Tag tag) {
+    QVector<QPoint> route;
+    if (!router.findRoute(sourceX, sourceY, targetX, targetY, tag, route))
+        return false;
 
-    // Check the above component:
-    if (upWire != nullptr && upWire->getTag() == tag
-        && !upWire->isFullyConnected()) {
-        wireConnectionDirection = Wire::Direction::N;
-        return upWire;
+    // Connect the whole route before moving any signals.
+    journal.begin();
+    for (const QPoint& square : route)
+        placeWire(square.x(), square.y(), tag);
+    propagateSignals();
+    victory();
+    journal.end();
+    return true;
+}
+
+void Level::placeWire(int x, int y, Tag tag) {
+    // Search for surrounding grid elements and initialize directions:
+    Wire::Direction wireConnectionDirection = Wire::Direction::NONE;
+    Wire::Direction nodeConnectionDirection = Wire::Direction::NONE;
+    Wire::Direction gateConnectionDirection = Wire::Direction::NONE;
+    Wire* currentWire = nullptr;
+    Cell around[4];
+    grid.neighbors(x, y, around);
+    Wire* headWire = findWire(around, tag, wireConnectionDirection);
+    Node* headNode = findOutputNode(around, tag, nodeConnectionDirection);
+    Gate* headGate = findOutputGate(around, tag, gateConnectionDirection);
+
+    // With no open end around, the wire may branch off the middle of a finished one:
+    Wire* junctionWire = nullptr;
+    if (!headWire && !headNode && !headGate)
+        junctionWire = findJunction(around, tag, wireConnectionDirection);
+
+    // Create a new wire at the (x, y) coords if a connection was found:
+    if (headWire || headNode || headGate || junctionWire) {
+        currentWire = wirePool.get(wirePool.allocate());
+        setWire(x, y, currentWire);
+
+        // Head connection:
+        if (headWire)
+            headWire->connectTail(currentWire, wireConnectionDirection);
+        else if (junctionWire)
+            junctionWire->connectBranch(currentWire, wireConnectionDirection);
+        else if (headNode && headNode->getNodeType() == Node::Type::ROOT) {
+            bool wasConnected = headNode->getConnected();
+            headNode->connectWire(currentWire, nodeConnectionDirection);
+            trackConnection(headNode->getWire(), wasConnected);
+        }
+        else if (headGate && headGate->getAlignment() == Gate::Ports::INOUT)
+            headGate->connectWire(currentWire, gateConnectionDirection);
+
+        // Tail connection (Note: tails should only be made if the currentWire has a head). Only
+        // this square changed, so its neighbors are still as read above:
+        Node* tailNode = findInputNode(around, tag, currentWire->getSignal(),
+                                       nodeConnectionDirection);
+        Gate* tailGate = findInputGate(around, gateConnectionDirection);
+        if (tailNode) {
+            bool wasConnected = tailNode->getConnected();
+            tailNode->connectWire(currentWire, nodeConnectionDirection);
+            trackConnection(tailNode->getWire(), wasConnected);
+        }
+        else if (tailGate) {
+            tailGate->connectWire(currentWire, gateConnectionDirection);
+            propagator.markDirty(tailGate);
+        }
     }
+}
 
-    // Check the right component:
-    else if (rightWire != nullptr && rightWire->getTag() == tag
-             && !rightWire->isFullyConnected()) {
-        wireConnectionDirection = Wire::Direction::E;
-        return rightWire;
+Wire* Level::findWire(const Cell around[4], Tag tag, Wire::Direction& wireConnectionDirection) {
+    // Check the components above, right, below and left, in that order:
+    for (int i = 0; i < 4; i++) {
+        if (around[i].kind != Component::WIRE)
+            continue;
+        Wire* checkWire = wirePool.get(wires[around[i].index]);
+        if (checkWire->getTag() == tag && !checkWire->isFullyConnected()) {
+            wireConnectionDirection = NEIGHBOR_SIDES[i];
+            return checkWire;
+        }
     }
+    return nullptr;
+}
 
-    // Check the below component:
-    else if (downWire != nullptr && downWire->getTag() == tag
-             && !downWire->isFullyConnected()) {
-        wireConnectionDirection = Wire::Direction::S;
-        return downWire;
+Wire* Level::findJunction(const Cell around[4], Tag tag, Wire::Direction& wireConnectionDirection) {
+    // Only board wires in the middle of a chain with a free side can fan out:
+    for (int i = 0; i < 4; i++) {
+        if (around[i].kind != Component::WIRE)
+            continue;
+        Wire* checkWire = wirePool.get(wires[around[i].index]);
+        if (checkWire->getTag() == tag && checkWire->isFullyConnected()
+            && checkWire->getOwner() == Wire::Owner::BOARD
+            && checkWire->getBranchCount() < Wire::MAX_BRANCHES) {
+            wireConnectionDirection = NEIGHBOR_SIDES[i];
+            return checkWire;
+        }
     }
+    return nullptr;
+}
 
-    // Check the left component:
-    else if (leftWire != nullptr && leftWire->getTag() == tag
-             && !leftWire->isFullyConnected()) {
-        wireConnectionDirection = Wire::Direction::W;
-        return leftWire;
+Wire* Level::findOpenTail(Wire* currentWire) {
+    Wire* tailWire = currentWire->getTailConnection();
+    if (tailWire && tailWire->getTailConnection() == nullptr && tailWire->getBranchCount() == 0)
+        return tailWire;
+    for (int i = 0; i < currentWire->getBranchCount(); i++) {
+        Wire* branchWire = currentWire->getBranchConnection(i);
+        if (branchWire->getTailConnection() == nullptr && branchWire->getBranchCount() == 0)
+            return branchWire;
     }
     return nullptr;
 }
 
 void Level::wireRemove(Wire* currentWire) {
-    int currentX = currentWire->getX();
-    int currentY = currentWire->getY();
-    int tailX = currentWire->getTailConnection()->getX();
-    int tailY = currentWire->getTailConnection()->getY();
-    int headX = currentWire->getHeadConnection()->getX();
-    int headY = currentWire->getHeadConnection()->getY();
-    setWire(tailX, tailY, nullptr);
-    if (currentY - headY == 1) {
-        currentWire->setDirection(Wire::Direction::N);
-    }
-    else if (headX - currentX == 1) {
-        currentWire->setDirection(Wire::Direction::E);
-    }
-    else if (headY - currentY == 1) {
-        currentWire->setDirection(Wire::Direction::S);
-    }
-    else if (currentX - headX == 1) {
-        currentWire->setDirection(Wire::Direction::W);
+    Wire* openTail = findOpenTail(currentWire);
+    setWire(openTail->getX(), openTail->getY(), nullptr);
+}
+
+Node* Level::findOutputNode(const Cell around[4], Tag tag, Wire::Direction& wireConnectionDirection) {
+    // Check the nodes above, right, below and left, in that order:
+    for (int i = 0; i < 4; i++) {
+        if (around[i].kind != Component::NODE)
+            continue;
+        Node* checkNode = nodes[around[i].index];
+        if (checkNode->getTag() == tag && !checkNode->getConnected()
+            && checkNode->getNodeType() == Node::Type::ROOT
+            && (checkNode->getDirection() == Node::Direction::NONE
+                || checkNode->getDirection() == NEIGHBOR_FACING[i])) {
+            wireConnectionDirection = NEIGHBOR_SIDES[i];
+            return checkNode;
+        }
     }
+    return nullptr;
 }
 
-Node* Level::findOutputNode(int x, int y, QString tag, Wire::Direction& wireConnectionDirection) {
-    Node* upNode = getNode(x, y - 1);
-    Node* rightNode = getNode(x + 1, y);
-    Node* downNode = getNode(x, y + 1);
-    Node* leftNode = getNode(x - 1, y);
-
-    // Check node above:
-    if (upNode && upNode->getTag() == tag && !upNode->getConnected()
-        && upNode->getNodeType() == Node::Type::ROOT &&
-        (upNode->getDirection() == Node::Direction::NONE
-            || upNode->getDirection() == Node::Direction::S)) {
-        wireConnectionDirection = Wire::Direction::N;
-        return upNode;
-    }
-
-    // Check node right:
-    else if (rightNode && rightNode->getTag() == tag && !rightNode->getConnected()
-            && rightNode->getNodeType() == Node::Type::ROOT &&
-            (rightNode->getDirection() == Node::Direction::NONE
-                || rightNode->getDirection() == Node::Direction::W)) {
-        wireConnectionDirection = Wire::Direction::E;
-        return rightNode;
+Node* Level::findInputNode(const Cell around[4], Tag tag, const Bus& signal, Wire::Direction& wireConnectionDirection) {
+    // Check the nodes above, right, below and left, in that order:
+    for (int i = 0; i < 4; i++) {
+        if (around[i].kind != Component::NODE)
+            continue;
+        Node* checkNode = nodes[around[i].index];
+        if (checkNode->getNodeType() == Node::Type::END && checkNode->getTag() == tag
+            && checkNode->getSignal() == signal) {
+            wireConnectionDirection = NEIGHBOR_SIDES[i];
+            return checkNode;
+        }
     }
+    return nullptr;
+}
 
-    // Check node down:
-    else if (downNode && downNode->getTag() == tag && !downNode->getConnected()
-            && downNode->getNodeType() == Node::Type::ROOT &&
-            (downNode->getDirection() == Node::Direction::NONE
-                || downNode->getDirection() == Node::Direction::N)) {
-        wireConnectionDirection = Wire::Direction::S;
-        return downNode;
+Gate* Level::findOutputGate(const Cell around[4], Tag tag, Wire::Direction& wireConnectionDirection) {
+    // Check the gates above, right, below and left, in that order:
+    for (int i = 0; i < 4; i++) {
+        if (around[i].kind != Component::GATE)
+            continue;
+        Gate* checkGate = gates[around[i].index];
+        if (checkGate->getOutputDirection() == NEIGHBOR_FACING[i] && checkGate->canDrive()
+            && tag == checkGate->getTag()) {
+            wireConnectionDirection = NEIGHBOR_SIDES[i];
+            return checkGate;
+        }
     }
+    return nullptr;
+}
 
-    // Check node left:
-    else if (leftNode && leftNode->getTag() == tag && !leftNode->getConnected()
-            && leftNode->getNodeType() == Node::Type::ROOT &&
-            (leftNode->getDirection() == Node::Direction::NONE
-                || leftNode->getDirection() == Node::Direction::E)) {
-        wireConnectionDirection = Wire::Direction::W;
-        return leftNode;
+Gate* Level::findInputGate(const Cell around[4], Wire::Direction& wireConnectionDirection) {
+    // Check the gates above, right, below and left, in that order:
+    for (int i = 0; i < 4; i++) {
+        if (around[i].kind != Component::GATE)
+            continue;
+        Gate* checkGate = gates[around[i].index];
+        if (!checkGate->isFullyConnected()
+            && checkGate->getInputDirection() == NEIGHBOR_FACING[i]) {
+            wireConnectionDirection = NEIGHBOR_SIDES[i];
+            return checkGate;
+        }
     }
     return nullptr;
 }
 
-Node* Level::findInputNode(int x, int y, QString tag, bool signal, Wire::Direction& wireConnectionDirection) {
-    Node* upNode = getNode(x, y - 1);
-    Node* rightNode = getNode(x + 1, y);
-    Node* downNode = getNode(x, y + 1);
-    Node* leftNode = getNode(x - 1, y);
+Level::Cell Level::cellAt(int x, int y) {
+    return grid.at(x, y);
+}
 
-    // Check nodes above:
-    if (upNode && upNode->getNodeType() == Node::Type::END && upNode->getTag() == tag
-        && upNode->getSignal() == signal) {
-        wireConnectionDirection = Wire::Direction::N;
-        return upNode;
-    }
+void Level::placeComponent(int x, int y, Component kind, qsizetype index) {
+    grid.set(x, y, {kind, static_cast<quint32>(index)});
+    if (kind == Component::NONE)
+        occupied.reset(x, y);
+    else
+        occupied.set(x, y);
+    markCellDirty(x, y);
+}
 
-    // Check nodes right:
-    else if (rightNode && rightNode->getNodeType() == Node::Type::END && rightNode->getTag() == tag
-             && rightNode->getSignal() == signal) {
-        wireConnectionDirection = Wire::Direction::E;
-        return rightNode;
-    }
+void Level::markCellDirty(int x, int y) {
+    if (allDirty || !grid.contains(x, y))
+        return;
+    quint32 index = quint32(y) * quint32(grid.getWidth()) + quint32(x);
+    if (dirtyMarks.contains(index))
+        return;
+    dirtyMarks.insert(index);
+    dirtyCells.append(QPoint(x, y));
+}
 
-    // Check nodes down:
-    else if (downNode && downNode->getNodeType() == Node::Type::END && downNode->getTag() == tag
-             && downNode->getSignal() == signal) {
-        wireConnectionDirection = Wire::Direction::S;
-        return downNode;
-    }
+void Level::markAllDirty() {
+    dirtyMarks.clear();
+    dirtyCells.clear();
+    allDirty = true;
+}
 
-    // Check nodes left:
-    else if (leftNode && leftNode->getNodeType() == Node::Type::END && leftNode->getTag() == tag
-             && leftNode->getSignal() == signal) {
-        wireConnectionDirection = Wire::Direction::W;
-        return leftNode;
-    }
-    return nullptr;
+bool Level::takeDirtyCells(QVector<QPoint>& cells) {
+    // Loop flags are only worked out when someone is drawing them.
+    propagator.reportFlags();
+    cells.clear();
+    bool partial = !allDirty;
+    allDirty = false;
+    dirtyMarks.clear();
+    cells.swap(dirtyCells);
+    return partial;
 }
 
-Gate* Level::findOutputGate(int x, int y, QString tag, Wire::Direction& wireConnectionDirection) {
-    Gate* upGate = getGate(x, y - 1);
-    Gate* rightGate = getGate(x + 1, y);
-    Gate* downGate = getGate(x, y + 1);
-    Gate* leftGate = getGate(x - 1, y);
+Level::Component Level::getComponent(int x, int y) {
+    if (obstacles.test(x, y))
+        return Component::OBSTACLE;
+    return cellAt(x, y).kind;
+}
 
-    // Check gates above:
-    if (upGate && (upGate->getOutputDirection() == Node::Direction::S
-        && upGate->isFullyConnected() && tag == upGate->getTag())) {
-        wireConnectionDirection = Wire::Direction::N;
-        return upGate;
-    }
+Wire* Level::getWire(int x, int y) {
+    Cell cell = cellAt(x, y);
+    return cell.kind == Component::WIRE ? wirePool.get(wires[cell.index]) : nullptr;
+}
 
-    // Check gates right:
-    else if (rightGate && (rightGate->getOutputDirection() == Node::Direction::W
-            && rightGate->isFullyConnected() && tag == rightGate->getTag())) {
-        wireConnectionDirection = Wire::Direction::E;
-        return rightGate;
-    }
+void Level::setWire(int x, int y, Wire* newWire) {
+    Cell cell = cellAt(x, y);
+    if (!grid.contains(x, y) || (cell.kind != Component::NONE && cell.kind != Component::WIRE)
+        || obstacles.test(x, y))
+        return;
+    if (cell.kind == Component::WIRE) {
+        Wire* oldWire = wirePool.get(wires[cell.index]);
+        if (Wire* headWire = oldWire->getHeadConnection()) {
+            bool wasConnected = headWire->isFullyConnected();
+            headWire->replaceTail(oldWire, newWire);
+            trackConnection(headWire, wasConnected);
+        }
 
-    // Check gates below:
-    else if (downGate && (downGate->getOutputDirection() == Node::Direction::N
-            && downGate->isFullyConnected() && tag == downGate->getTag())) {
-        wireConnectionDirection = Wire::Direction::S;
-        return downGate;
-    }
+        // A junction hands every branch over along with its tail.
+        QVector<Wire*> tailWires;
+        if (oldWire->getTailConnection())
+            tailWires.append(oldWire->getTailConnection());
+        for (int i = 0; i < oldWire->getBranchCount(); i++)
+            tailWires.append(oldWire->getBranchConnection(i));
+        for (Wire* tailWire : tailWires) {
+            bool wasConnected = tailWire->isFullyConnected();
+            tailWire->setHeadConnection(newWire);
+            trackConnection(tailWire, wasConnected);
 
-    // Check gates left:
-    else if (leftGate && (leftGate->getOutputDirection() == Node::Direction::E
-            && leftGate->isFullyConnected() && tag == leftGate->getTag())) {
-        wireConnectionDirection = Wire::Direction::W;
-        return leftGate;
+            // An unplugged gate input changes the gate's output.
+            if (newWire == nullptr)
+                propagator.markDirty(propagator.gateForInput(tailWire));
+        }
+        detachWire(x, y);
+        releaseWire(oldWire->getId());
+    }
+    if (newWire) {
+        attachWire(x, y, newWire->getId());
+        newWire->setPosition(x, y);
     }
-    return nullptr;
 }
 
-Gate* Level::findInputGate(int x, int y, Wire::Direction& wireConnectionDirection) {
-    Gate* upGate = getGate(x, y - 1);
-    Gate* rightGate = getGate(x + 1, y);
-    Gate* downGate = getGate(x, y + 1);
-    Gate* leftGate = getGate(x - 1, y);
+void Level::attachWire(int x, int y, Wire::Id id) {
+    journal.recordPlace(x, y, id);
+    placeComponent(x, y, Component::WIRE, wires.size());
+    wires.append(id);
+    propagator.markEdited(wirePool.get(id));
+}
 
-    // Check gates above:
-    if (upGate && !upGate->isFullyConnected() &&
-        upGate->getInputDirection() == Node::Direction::S) {
-        wireConnectionDirection = Wire::Direction::N;
-        return upGate;
-    }
+void Level::detachWire(int x, int y) {
+    Cell cell = cellAt(x, y);
+    journal.recordRemove(x, y, wires[cell.index]);
+    propagator.markEdited(wirePool.get(wires[cell.index]));
+    removeWireAt(cell.index);
+    placeComponent(x, y, Component::NONE, 0);
+}
 
-    // Check gates right:
-    else if (rightGate && !rightGate->isFullyConnected() &&
-               rightGate->getInputDirection() == Node::Direction::W) {
-        wireConnectionDirection = Wire::Direction::E;
-        return rightGate;
-    }
+void Level::releaseWire(Wire::Id id) {
+    if (!journal.isRecording())
+        wirePool.release(id);
+}
 
-    // Check gates below:
-    else if (downGate && !downGate->isFullyConnected() &&
-               downGate->getInputDirection() == Node::Direction::N) {
-        wireConnectionDirection = Wire::Direction::S;
-        return downGate;
-    }
+bool Level::isWireOnBoard(Wire::Id id) {
+    Wire* wire = wirePool.get(id);
+    Cell cell = cellAt(wire->getX(), wire->getY());
+    return cell.kind == Component::WIRE && wires[cell.index] == id;
+}
 
-    // Check gates left:
-    else if (leftGate && !leftGate->isFullyConnected() &&
-               leftGate->getInputDirection() == Node::Direction::E) {
-        wireConnectionDirection = Wire::Direction::W;
-        return leftGate;
-    }
-    return nullptr;
+void Level::trackConnection(Wire* wire, bool wasConnected) {
+    Node* node = getNode(wire->getX(), wire->getY());
+    if (node == nullptr || node->getWire() != wire)
+        return;
+    bool connected = wire->isFullyConnected();
+    if (connected && !wasConnected)
+        unconnectedNodes--;
+    else if (!connected && wasConnected)
+        unconnectedNodes++;
 }
 
-Wire* Level::getWire(int x, int y) {
-    if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) {
-        return nullptr;
+void Level::recountNodes() {
+    unconnectedNodes = 0;
+    for (Node* node : nodes) {
+        if (!node->getConnected())
+            unconnectedNodes++;
     }
-    return wireGrid[y * WIDTH + x];
 }
 
-void Level::setWire(int x, int y, Wire* newWire) {
-    if ((x < 0 || x > WIDTH || y < 0 || y > HEIGHT)
-        || getNode(x, y) || getObstacle(x, y) || getGate(x, y)) {
-        return;
-    }
-    if (wireGrid[y * WIDTH + x]) {
-        if (Wire* headWire = wireGrid[y * WIDTH + x]->getHeadConnection())
-            headWire->setTailConnection(newWire);
-        if (Wire* tailWire = wireGrid[y * WIDTH + x]->getTailConnection())
-            tailWire->setHeadConnection(newWire);
-        delete wireGrid[y * WIDTH + x];
-    }
-    if (newWire)
-        newWire->setPosition(x, y);
-    wireGrid[y * WIDTH + x] = newWire;
+void Level::propagateSignals() {
+    propagator.propagate();
+    unconnectedNodes += propagator.getUnpluggedEnds();
+}
+
+void Level::removeWireAt(quint32 index) {
+    Wire* movedWire = wirePool.get(wires.last());
+    wires[index] = movedWire->getId();
+    wires.removeLast();
+
+    // Repoint the cell of the wire that filled the gap.
+    if (index < static_cast<quint32>(wires.size()))
+        placeComponent(movedWire->getX(), movedWire->getY(), Component::WIRE, index);
 }
 
 Gate* Level::getGate(int x, int y) {
-    if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) {
-        return nullptr;
-    }
-    return gateGrid[y * WIDTH + x];
+    Cell cell = cellAt(x, y);
+    return cell.kind == Component::GATE ? gates[cell.index] : nullptr;
+}
+
+bool Level::isGateOnLoop(int x, int y) {
+    Gate* gate = getGate(x, y);
+    return gate && propagator.isOnLoop(gate);
+}
+
+bool Level::isGateOscillating(int x, int y) {
+    Gate* gate = getGate(x, y);
+    return gate && propagator.isOscillating(gate);
 }
 
 Node* Level::getNode(int x, int y) {
-    if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) {
-        return nullptr;
+    Cell cell = cellAt(x, y);
+    return cell.kind == Component::NODE ? nodes[cell.index] : nullptr;
+}
+
+void Level::copyLayout(Level* other) {
+    if (getWidth() != other->getWidth() || getHeight() != other->getHeight())
+        resize(other->getWidth(), other->getHeight());
+    else
+        clearLevel();
+
+    // The boards are the same size now, so the obstacle words are shared as they are.
+    obstacles = other->obstacles;
+    for (Node* node : other->nodes) {
+        setNode(node->getX(), node->getY(), node->getSignal(), node->getTag().toString(),
+                node->getNodeType());
+        if (Node* copy = getNode(node->getX(), node->getY()))
+            copy->setDirection(node->getDirection());
     }
-    return nodeGrid[y * WIDTH + x];
+
+    // Double gates are rebuilt from the half holding the output, like drawGate places them.
+    for (Gate* gate : other->gates) {
+        if (gate->getAlignment() != Gate::Ports::INOUT)
+            continue;
+        int x = gate->getInputNode()->getX();
+        int y = gate->getInputNode()->getY();
+        drawGate(x, y, gate->getOperator(), gate->getDirection());
+        if (Gate* copy = getGate(x, y))
+            copy->setDelay(gate->getDelay());
+    }
+}
+
+QVector<Node*> Level::getNodes() {
+    return nodes;
+}
+
+QVector<Gate*> Level::getGates() {
+    return gates;
 }
 
-Obstacle* Level::getObstacle(int x, int y) {
-    if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) {
-        return nullptr;
+bool Level::getObstacle(int x, int y) {
+    return obstacles.test(x, y);
+}
+
+ObstacleLayer Level::getObstacleLayer() {
+    return obstacles;
+}
+
+QVector<QPoint> Level::getOccupiedSquares() {
+    QVector<QPoint> squares;
+    int wordsPerRow = (getWidth() + 63) / 64;
+    for (int y = 0; y < getHeight(); y++) {
+        for (int word = 0; word < wordsPerRow; word++) {
+            quint64 bits = occupied.getRowWord(y, word);
+            while (bits) {
+                squares.append(QPoint(word * 64 + qCountTrailingZeroBits(bits), y));
+                bits &= bits - 1;
+            }
+        }
     }
-    return obstacleGrid[y * WIDTH + x];
+    return squares;
 }
 
-void Level::setNode(int x, int y, bool signal, QString tag, Node::Type type) {
-    if (getGate(x, y) || getWire(x, y) || getNode(x, y) || getObstacle(x, y))
+bool Level::hasObstacleIn(int x, int y, int width, int height) {
+    return obstacles.anyInRect(x, y, width, height);
+}
+
+int Level::getObstacleCount() {
+    return obstacles.count();
+}
+
+void Level::setNode(int x, int y, Bus signal, QString tag, Node::Type type) {
+    if (!grid.contains(x, y) || !isEmptySpace(x, y))
+        return;
+    journal.clear();
+    Node* newNode = new Node(&wirePool, this, x, y, type, signal, Tag::fromString(tag));
+    placeComponent(x, y, Component::NODE, nodes.size());
+    nodes.append(newNode);
+    propagator.invalidate();
+    if (!newNode->getConnected())
+        unconnectedNodes++;
+}
+
+void Level::setNodeSignal(int x, int y, const Bus& signal) {
+    Node* node = getNode(x, y);
+    if (node == nullptr || node->getNodeType() != Node::Type::ROOT || node->getSignal() == signal)
         return;
-    Node* newNode = new Node(this, x, y, type, signal, tag);
-    nodeGrid[y * WIDTH + x] = newNode;
+    journal.begin();
+    node->setSignal(signal);
+    markCellDirty(x, y);
+    propagator.markChanged(node->getWire());
+    propagateSignals();
+    victory();
+    journal.end();
 }
 
 void Level::victory() {
-    bool victory = true;
-    for (int i = 0; i < WIDTH * HEIGHT; i++) {
-        if (nodeGrid[i] != nullptr && nodeGrid[i]->getConnected() == false) {
-            victory = false;
-        }
-    }
+    bool victory = unconnectedNodes == 0;
     if(victory && !isVictory) {
         spawnConfetti();
         isVictory = true;
@@ -354,199 +505,97 @@ void Level::victory() {
 }
 
 void Level::spawnConfetti() {
-    confetti->spawnConfetti();
+    if (confetti)
+        confetti->spawnConfetti();
 }
 
 void Level::updateLevel() {
-    if (isVictory) {
+    if (isVictory && confetti) {
         confetti->updateConfetti();
     }
 }
 
 void Level::levelSetup(int levelNum) {
-    switch (levelNum) {
-    case 1:
-        setNode(2, 2, true, "A", Node::Type::ROOT);
-        setNode(2, 5, true, "B", Node::Type::ROOT);
-        placeBorder();
-
-        //Bottom and Top lines:
-        for (int x = 3; x <= 8; x++) {
-            addObstacle(x, 2);
-            addObstacle(x, 5);
-        }
-        addObstacle(9, 5);
-        addObstacle(7, 3);
-        addObstacle(8, 3);
-        drawGate(6, 4, Gate::Operator::AND, Gate::Direction::EAST);
-        setNode(9, 2, true, "AB", Node::Type::END);
-        break;
-    case 2:
-        setNode(2, 2, false, "A", Node::Type::ROOT);
-        drawGate(4, 3, Gate::Operator::NOT, Gate::Direction::SOUTH);
-        setNode(2, 5, true, "B", Node::Type::ROOT);
-        placeBorder();
-
-        //Top and bottom rows:
-        for (int x = 7; x <= 9; x++) {
-            addObstacle(x,2);
-            addObstacle(x,5);
-        }
-        addObstacle(8,3);
-        drawGate(7, 4, Gate::Operator::AND, Gate::Direction::EAST);
-        setNode(9, 3, true, "AB", Node::Type::END);
-        break;
-    case 3:
-        // Top Row
-        for(int x = 0; x <= 11; x++) {
-            for(int y = 0; y < 2; y++) {
-                addObstacle(x, y);
-            }
-        }
+    // Levels missing from the pack fall back to the default layout at index 0.
+    const LevelPack& pack = LevelPack::builtIn();
+    LevelPack::Layout layout;
+    if (!pack.readLevel(levelNum, layout))
+        pack.readLevel(0, layout);
 
-        // Left Side
-        for(int x = 0; x <= 1; x++) {
-            for(int y = 0; y < 8; y++) {
-                addObstacle(x, y);
-            }
-        }
+    loadLayout(layout);
 
-        // Right side
-        for(int x = 10; x <= 11; x++) {
-            for(int y = 0; y < 8; y++) {
-                addObstacle(x, y);
-            }
-        }
+    // Reset victory state after setting up new level
+    isVictory = false;
+}
 
-        // Bottom side
-        for(int x = 0; x <= 11; x++) {
-            addObstacle(x, 7);
-        }
-        addObstacle(8, 5);
-        addObstacle(8, 6);
-        addObstacle(8, 4);
-        addObstacle(8, 7);
-        addObstacle(2, 2);
-        addObstacle(3, 2);
-        setNode(6, 6, false, "B", Node::Type::ROOT);
-        setNode(9, 2, false, "A", Node::Type::ROOT);
-        setNode(9, 6, true, "AB", Node::Type::END);
-        drawGate(3, 5, Gate::Operator::OR, Gate::Direction::EAST);
-        drawGate(7, 5, Gate::Operator::NOT, Gate::Direction::NORTH);
-        break;
-    case 4:
-        placeBorder();
-        for (int y = 2; y <= 5; y++) {
-            addObstacle(9, y);
+void Level::loadLayout(const LevelPack::Layout& layout) {
+    if (layout.width != getWidth() || layout.height != getHeight())
+        resize(layout.width, layout.height);
+    for (const LevelPack::Record& record : layout.records) {
+        switch (record.kind) {
+        case LevelPack::Kind::ROOT :
+            setNode(record.x, record.y, record.signal, record.tag.toString(), Node::Type::ROOT);
+            break;
+        case LevelPack::Kind::END :
+            setNode(record.x, record.y, record.signal, record.tag.toString(), Node::Type::END);
+            break;
+        case LevelPack::Kind::GATE :
+            drawGate(record.x, record.y, record.op, record.direction);
+            if (record.delay > 0 && getGate(record.x, record.y))
+                getGate(record.x, record.y)->setDelay(record.delay);
+            break;
+        case LevelPack::Kind::OBSTACLES :
+            addObstacleRect(record.x, record.y, record.width, record.height);
+            break;
+        case LevelPack::Kind::BORDER :
+            placeBorder();
+            break;
         }
-        setNode(5, 2, false, "A", Node::Type::ROOT);
-        setNode(6, 2, false, "B", Node::Type::ROOT);
-        setNode(4, 4, false, "C", Node::Type::ROOT);
-        setNode(7, 3, true, "ABC", Node::Type::END);
-        drawGate(2, 4, Gate::Operator::OR, Gate::Direction::SOUTH);
-        drawGate(7, 5, Gate::Operator::OR, Gate::Direction::EAST);
-        drawGate(8, 3, Gate::Operator::NOT, Gate::Direction::NORTH);
-        break;
-    case 5:
-        setNode(0, 0, false, "A", Node::Type::ROOT);
-        setNode(0, 3, true, "B", Node::Type::ROOT);
-        setNode(3, 1, true, "C", Node::Type::ROOT);
-        setNode(4, 1, false, "D", Node::Type::ROOT);
-        setNode(1, 7, true, "E", Node::Type::ROOT);
-        drawGate(1, 2, Gate::Operator::NOT, Gate::Direction::EAST);
-        drawGate(1, 5, Gate::Operator::OR, Gate::Direction::SOUTH);
-        addObstacle(3,5);
-        addObstacle(3,6);
-        drawGate(6, 1, Gate::Operator::OR, Gate::Direction::EAST);
-        drawGate(5, 4, Gate::Operator::AND, Gate::Direction::EAST);
-        setNode(6, 3, true, "F", Node::Type::ROOT);
-        drawGate(5, 7, Gate::Operator::AND, Gate::Direction::EAST);
-        drawGate(8, 7, Gate::Operator::NOT, Gate::Direction::EAST);
-        setNode(9, 1, false, "G", Node::Type::ROOT);
-        drawGate(8, 3, Gate::Operator::AND, Gate::Direction::SOUTH);
-        drawGate(9, 4, Gate::Operator::NOT, Gate::Direction::EAST);
-        drawGate(10, 6, Gate::Operator::AND, Gate::Direction::SOUTH);
-        setNode(11, 7, true, "ABCDEFG", Node::Type::END);
-        addObstacle(6,6);
-        addObstacle(7,6);
-        addObstacle(7,5);
-        addObstacle(8,5);
-        addObstacle(7,4);
-        addObstacle(7,3);
-        addObstacle(7,2);
-        addObstacle(10,1);
-        break;
-    default:
-        setNode(0, 3, true, "A", Node::Type::ROOT);
-        setNode(0, 5, false, "B", Node::Type::ROOT);
-        setNode(8, 3, true, "AB", Node::Type::END);
-        addObstacle(0, 0);
-        drawGate(6, 4, Gate::Operator::AND, Gate::Direction::EAST);
-        drawGate(7, 1, Gate::Operator::OR, Gate::Direction::SOUTH);
-        drawGate(8, 7, Gate::Operator::NOT, Gate::Direction::EAST);
-        break;
     }
-
-    // Reset victory state after setting up new level
-    isVictory = false;
 }
 
 void Level::placeBorder(){
+    int width = getWidth();
+    int height = getHeight();
+
     //Top rows:
-    for(int x = 0; x <= 11; x++) {
-        for(int y = 0; y <= 1; y++) {
-            addObstacle(x, y);
-        }
-    }
+    addObstacleRect(0, 0, width, 2);
 
     //Right rows:
-    for(int x = 10; x <= 11; x++) {
-        for(int y = 2; y <= 5; y++) {
-            addObstacle(x, y);
-        }
-    }
+    addObstacleRect(width - 2, 2, 2, height - 4);
 
     //Bottom rows:
-    for(int x = 0; x <= 11; x++) {
-        for(int y = 6; y <= 7; y++) {
-            addObstacle(x, y);
-        }
-    }
+    addObstacleRect(0, height - 2, width, 2);
 
     //Left rows:
-    for(int x = 0; x <= 1; x++) {
-        for(int y = 2; y <= 5; y++) {
-            addObstacle(x, y);
-        }
-    }
+    addObstacleRect(0, 2, 2, height - 4);
 }
 
 void Level::removeConfetti() {
-    confetti->clearConfetti();
+    if (confetti)
+        confetti->clearConfetti();
     isVictory = false;
 }
 
 // Did not use this for Clear Button. But could use this for moving to the next level.
 void Level::clearLevel() {
+    journal.clear();
     removeConfetti();
-    for(int i = 0; i < WIDTH * HEIGHT; i++) {
-        if (wireGrid[i]) {
-            delete wireGrid[i];
-            wireGrid[i] = nullptr;
-        }
-        if(gateGrid[i]) {
-            delete gateGrid[i];
-            gateGrid[i] = nullptr;
-        }
-        if(nodeGrid[i]) {
-            delete nodeGrid[i];
-            nodeGrid[i] = nullptr;
-        }
-        if(obstacleGrid[i]) {
-            delete obstacleGrid[i];
-            obstacleGrid[i] = nullptr;
-        }
-    }
+    for (Wire::Id wire : wires)
+        wirePool.release(wire);
+    for (Gate* gate : gates)
+        delete gate;
+    for (Node* node : nodes)
+        delete node;
+    wires.clear();
+    gates.clear();
+    nodes.clear();
+    obstacles.clear();
+    occupied.clear();
+    unconnectedNodes = 0;
+    grid.clear();
+    markAllDirty();
+    propagator.reset();
     isVictory = false;
 }
 
@@ -556,37 +605,42 @@ void Level::addDoubleGate(int x, int y, Gate::Operator gateType, Gate::Direction
     calculateGateOffset(dir, xOffset, yOffset);
 
     // Check Location for the second gate
-    if (x + xOffset < 0 || x + xOffset >= WIDTH || y + yOffset < 0 || y + yOffset >= HEIGHT )
+    if (!grid.contains(x + xOffset, y + yOffset))
         return;
-    if (getGate(x + xOffset, y + yOffset) || getWire(x + xOffset, y + yOffset) ||
-        getNode(x + xOffset, y + yOffset) || getObstacle(x + xOffset, y + yOffset))
+    if (!isEmptySpace(x + xOffset, y + yOffset))
         return;
     Gate::Ports firstAlignment = Gate::Ports::INOUT;
     Gate::Ports secondAlignment = Gate::Ports::IN;
 
     // Create related gate objects.
-    Gate* firstHalf = new Gate(x, y, gateType, firstAlignment, dir, this);
-    Gate* secondHalf = new Gate(x + xOffset, y + yOffset, gateType, secondAlignment, dir, this);
+    Gate* firstHalf = new Gate(x, y, gateType, firstAlignment, dir, &wirePool, &journal, this);
+    Gate* secondHalf = new Gate(x + xOffset, y + yOffset, gateType, secondAlignment, dir,
+                                &wirePool, &journal, this);
 
     // Specify relation between
     firstHalf->setOtherHalf(secondHalf);
     secondHalf->setOtherHalf(firstHalf);
 
     // Draw a gate at the given x, y position
-    gateGrid[y * WIDTH + x] = firstHalf;
+    placeComponent(x, y, Component::GATE, gates.size());
+    gates.append(firstHalf);
 
     // Draw a gate adjacent to firstHalf in the specified direction.
-    gateGrid[(y + yOffset) * WIDTH + (x + xOffset)] = secondHalf;
+    placeComponent(x + xOffset, y + yOffset, Component::GATE, gates.size());
+    gates.append(secondHalf);
+    propagator.invalidate();
 }
 
 void Level::addSingleGate(int x, int y, Gate::Operator gateType, Gate::Direction dir) {
     Gate::Ports alignment = Gate::Ports::INOUT;
 
     // Create related gate objects.
-    Gate* newNotGate = new Gate(x, y, gateType, alignment, dir, this);
+    Gate* newNotGate = new Gate(x, y, gateType, alignment, dir, &wirePool, &journal, this);
 
     // Draw a gate at the given x, y position
-    gateGrid[y * WIDTH + x] = newNotGate;
+    placeComponent(x, y, Component::GATE, gates.size());
+    gates.append(newNotGate);
+    propagator.invalidate();
 }
 
 void Level::calculateGateOffset(Gate::Direction dir, int& xOffset, int& yOffset) {
@@ -615,92 +669,88 @@ void Level::calculateGateOffset(Gate::Direction dir, int& xOffset, int& yOffset)
 }
 
 void Level::addObstacle(int x, int y) {
-    if(x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT) {
-        if(obstacleGrid[y * WIDTH + x] == nullptr) {
-            obstacleGrid[y * WIDTH + x] = new Obstacle(this);
-        }
+    if(grid.contains(x, y) && cellAt(x, y).kind == Component::NONE) {
+        obstacles.set(x, y);
+        markCellDirty(x, y);
     }
 }
 
+void Level::addObstacleRect(int x, int y, int width, int height) {
+    // Obstacles only go on empty squares, so anything already placed is skipped.
+    obstacles.fillRect(x, y, width, height, &occupied);
+    markAllDirty();
+}
+
 void Level::removeTails(Node* startingNode) {
-    Wire* currentWire = startingNode->getWire()->getTailConnection();
-    while (currentWire) {
-        Wire* tailWire = currentWire->getTailConnection();
-        int x = currentWire->getX();
-        int y = currentWire->getY();
-        if (getNode(x, y))
-            return;
-        else if (getGate(x, y)) {
-            Gate* checkGate = getGate(x, y);
-
-            // Gets the valid output wire:
-            if (checkGate->getAlignment() == Gate::Ports::INOUT)
-                currentWire = checkGate->getOutputNode()->getWire();
-            else
-                currentWire = checkGate->getOtherHalf()->getOutputNode()->getWire();
-
-            // Checks to see if the gate wire continues. If so, continue the loop.
-            currentWire = currentWire->getTailConnection();
-            if (currentWire == nullptr)
-                return;
-            x = currentWire->getX();
-            y = currentWire->getY();
-            tailWire = currentWire->getTailConnection();
-        }
-        setWire(x, y, nullptr);
-        currentWire = tailWire;
-    }
+    journal.begin();
+    removeTree(startingNode->getWire()->getTailConnection());
+    propagateSignals();
+    journal.end();
 }
 
 void Level::removeTails(Gate* startingGate) {
     if (startingGate->getOutputNode() == nullptr)
         return;
-    Wire* currentWire = startingGate->getOutputNode()->getWire()->getTailConnection();
-    while (currentWire) {
-        Wire* tailWire = currentWire->getTailConnection();
+    journal.begin();
+    removeTree(startingGate->getOutputNode()->getWire()->getTailConnection());
+    propagateSignals();
+    journal.end();
+}
+
+void Level::removeTree(Wire* firstWire) {
+    QVector<Wire*> stack;
+    QVector<Gate*> crossedGates;
+    if (firstWire)
+        stack.append(firstWire);
+    while (!stack.isEmpty()) {
+        Wire* currentWire = stack.takeLast();
         int x = currentWire->getX();
         int y = currentWire->getY();
         if (getNode(x, y))
-            return;
-        else if (getGate(x, y)) {
-            Gate* checkGate = getGate(x, y);
-
-            // Gets the valid output wire:
-            if (checkGate->getAlignment() == Gate::Ports::INOUT)
-                currentWire = checkGate->getOutputNode()->getWire();
-            else
-                currentWire = checkGate->getOtherHalf()->getOutputNode()->getWire();
-
-            // Checks to see if the gate wire continues. If so, continue the loop.
-            currentWire = currentWire->getTailConnection();
-            if (currentWire == nullptr)
-                return;
-            x = currentWire->getX();
-            y = currentWire->getY();
-            tailWire = currentWire->getTailConnection();
+            continue;
+        else if (Gate* checkGate = getGate(x, y)) {
+            // Gets the valid output wire, once per gate even if both halves are fed:
+            if (checkGate->getAlignment() != Gate::Ports::INOUT)
+                checkGate = checkGate->getOtherHalf();
+            if (crossedGates.contains(checkGate))
+                continue;
+            crossedGates.append(checkGate);
+
+            // Checks to see if the gate wire continues. If so, carry on from there.
+            if (Wire* tailWire = checkGate->getOutputNode()->getWire()->getTailConnection())
+                stack.append(tailWire);
+            continue;
         }
+        if (Wire* tailWire = currentWire->getTailConnection())
+            stack.append(tailWire);
+        for (int i = 0; i < currentWire->getBranchCount(); i++)
+            stack.append(currentWire->getBranchConnection(i));
         setWire(x, y, nullptr);
-        currentWire = tailWire;
     }
 }
 
 bool Level::isEmptySpace(int x, int y) {
-    return (getWire(x, y) == nullptr) && (getNode(x, y) == nullptr) &&
-        (getObstacle(x, y) == nullptr) && (getGate(x, y) == nullptr);
+    return cellAt(x, y).kind == Component::NONE && !obstacles.test(x, y);
 }
 
 
     
 void Level::drawGate(int x, int y, Gate::Operator op, Gate::Direction dir) {
-    if (x < 0 || x >= WIDTH  || y < 0 || y >= HEIGHT )
+    if (!grid.contains(x, y))
         return;
 
     // Ensure there is nothing already in this grid square.
-    if (getGate(x, y) || getWire(x, y) || getNode(x, y) || getObstacle(x, y))
+    if (!isEmptySpace(x, y))
+        return;
+
+    // One square per input.
+    int inputs = GateKernels::getInputCount(op);
+    if (inputs > 2)
         return;
 
     // Add the gate to the backend.
-    if(op == Gate::Operator::NOT) {
+    journal.clear();
+    if(inputs == 1) {
         addSingleGate(x, y, op, dir);
     }
     else {
@@ -709,89 +759,115 @@ void Level::drawGate(int x, int y, Gate::Operator op, Gate::Direction dir) {
 }
 
 void Level::clearWires() {
-    for (int i = 0; i < WIDTH * HEIGHT; i++) {
-        Wire* wire = wireGrid[i];
-        bool isNodeWire = false;
-        for (int j = 0; j < WIDTH * HEIGHT; j++) {
-            if (nodeGrid[j] && nodeGrid[j]->getWire() == wire) {
-                isNodeWire = true;
-                break;
-            }
+    journal.begin();
+    for (Wire::Id id : wires) {
+        Wire* wire = wirePool.get(id);
+        journal.recordRemove(wire->getX(), wire->getY(), id);
+        placeComponent(wire->getX(), wire->getY(), Component::NONE, 0);
+        if (wire->getOwner() == Wire::Owner::BOARD) {
+            releaseWire(id);
         }
-        if (!isNodeWire && wire) {
-            delete wire;
-        }
-        wireGrid[i] = nullptr;
     }
+    wires.clear();
 
     // Reset connections on backing wires (nodes still exist)
-    for (int i = 0; i < WIDTH * HEIGHT; i++) {
-        if (nodeGrid[i]) {
-            Wire* backWire = nodeGrid[i]->getWire();
-            if (backWire) {
-                // reset only the opposite end
-                if (nodeGrid[i]->getNodeType() == Node::Type::ROOT)
-                    backWire->setTailConnection(nullptr);
-                else if (nodeGrid[i]->getNodeType() == Node::Type::END)
-                    backWire->setHeadConnection(nullptr);
-            }
+    for (Node* node : nodes) {
+        Wire* backWire = node->getWire();
+        if (backWire) {
+            // reset only the opposite end
+            if (node->getNodeType() == Node::Type::ROOT)
+                backWire->setTailConnection(nullptr);
+            else if (node->getNodeType() == Node::Type::END)
+                backWire->setHeadConnection(nullptr);
         }
     }
-    isVictory = false;
+    recountNodes();
+    propagator.clear();
+    propagator.invalidate();
+
+    // The win is gone along with the wires, so is its confetti.
+    removeConfetti();
+    journal.end();
 }
 
 void Level::clearGates() {
-    for(int i = 0; i < WIDTH * HEIGHT; i++) {
-        if (gateGrid[i]) {
-            Gate* gate = gateGrid[i];
-            gate->setSignal(false);
-            Node* inputNode = gate->getInputNode();
-            if (inputNode) {
-                Wire* inputWire = inputNode->getWire();
-                if (inputWire && inputNode->getNodeType() == Node::Type::ROOT) {
-                    inputWire->setHeadConnection(inputWire);
-                    inputWire->setTailConnection(nullptr);
-                } else if (inputWire && inputNode->getNodeType() == Node::Type::END) {
-                    inputWire->setHeadConnection(nullptr);
-                    inputWire->setTailConnection(inputWire);
-                }
+    journal.begin();
+    for (Gate* gate : gates) {
+        gate->setState(Bus(), Bus());
+        Node* inputNode = gate->getInputNode();
+        if (inputNode) {
+            Wire* inputWire = inputNode->getWire();
+            if (inputWire && inputNode->getNodeType() == Node::Type::ROOT) {
+                inputWire->setHeadConnection(inputWire);
+                inputWire->setTailConnection(nullptr);
+            } else if (inputWire && inputNode->getNodeType() == Node::Type::END) {
+                inputWire->setHeadConnection(nullptr);
+                inputWire->setTailConnection(inputWire);
             }
-            Node* outputNode = gate->getOutputNode();
-            if (outputNode) {
-                Wire* outputWire = outputNode->getWire();
-                if (outputWire && outputNode->getNodeType() == Node::Type::ROOT) {
-                    outputWire->setHeadConnection(outputWire);
-                    outputWire->setTailConnection(nullptr);
-                } else if (outputWire && outputNode->getNodeType() == Node::Type::END) {
-                    outputWire->setHeadConnection(outputWire);
-                    outputWire->setTailConnection(nullptr);
-                }
+        }
+        Node* outputNode = gate->getOutputNode();
+        if (outputNode) {
+            Wire* outputWire = outputNode->getWire();
+            if (outputWire && outputNode->getNodeType() == Node::Type::ROOT) {
+                outputWire->setHeadConnection(outputWire);
+                outputWire->setTailConnection(nullptr);
+            } else if (outputWire && outputNode->getNodeType() == Node::Type::END) {
+                outputWire->setHeadConnection(outputWire);
+                outputWire->setTailConnection(nullptr);
             }
         }
     }
+    propagator.invalidate();
+    journal.end();
 }
 
 void Level::clearNodes() {
-    for (int i = 0; i < WIDTH * HEIGHT; i++) {
-        if (nodeGrid[i]) {
-            Node* node = nodeGrid[i];
-            Wire* backWire = node->getWire();
-            if (!backWire)
-                continue;
-            int bx = backWire->getX();
-            int by = backWire->getY();
-            if (bx < 0 || bx >= WIDTH || by < 0 || by >= HEIGHT)
-                continue;
-            if (wireGrid[by * WIDTH + bx] != backWire)
-                continue;
-            if (node->getNodeType() == Node::Type::ROOT) {
-                backWire->setHeadConnection(backWire);
-                backWire->setTailConnection(nullptr);
-            } else if (node->getNodeType() == Node::Type::END) {
-                backWire->setHeadConnection(nullptr);
-                backWire->setTailConnection(backWire);
-            }
-            wireGrid[by * WIDTH + bx] = backWire;
+    journal.begin();
+    for (Node* node : nodes) {
+        Wire* backWire = node->getWire();
+        if (!backWire)
+            continue;
+        int bx = backWire->getX();
+        int by = backWire->getY();
+        if (getWire(bx, by) != backWire)
+            continue;
+        if (node->getNodeType() == Node::Type::ROOT) {
+            backWire->setHeadConnection(backWire);
+            backWire->setTailConnection(nullptr);
+        } else if (node->getNodeType() == Node::Type::END) {
+            backWire->setHeadConnection(nullptr);
+            backWire->setTailConnection(backWire);
         }
     }
+    recountNodes();
+    propagator.invalidate();
+    journal.end();
+}
+
+void Level::beginEdit() {
+    journal.begin();
+}
+
+void Level::endEdit() {
+    journal.end();
+}
+
+bool Level::undo() {
+    return journal.undo();
+}
+
+bool Level::redo() {
+    return journal.redo();
+}
+
+bool Level::canUndo() {
+    return journal.canUndo();
+}
+
+bool Level::canRedo() {
+    return journal.canRedo();
+}
+
+void Level::clearHistory() {
+    journal.clear();
 }
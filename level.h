@@ -12,27 +12,48 @@
 #define LEVEL_H
 
 #include <QObject>
+#include <QSet>
+#include <QVector>
 #include <QGraphicsScene>
 #include <Box2D/Box2D.h>
 #include "confettieffect.h"
+#include "cellgrid.h"
 
 #include "wire.h"
 #include "gate.h"
 #include "node.h"
-#include "obstacle.h"
+#include "obstaclelayer.h"
+#include "journal.h"
+#include "levelpack.h"
+#include "propagator.h"
+#include "router.h"
+#include "wirepool.h"
 
 class Level : public QObject {
 
     Q_OBJECT
 
+    friend class Journal;
+    friend class Propagator;
+    friend class Router;
+    friend class Solver;
+
 public:
+    /**
+     * @brief Component - The kind of grid component stored in a single cell of the level.
+     */
+    using Component = CellGrid::Component;
+
     /**
      * @brief Level - Default constructor.
-     * @param graphicsScene - The graphics scene.
+     * @param graphicsScene - The graphics scene, or nullptr for a headless level with no confetti.
      * @param box2DWorld - The Box2D world.
      * @param parent - the parent object.
+     * @param width - The width of the board, in cells.
+     * @param height - The height of the board, in cells.
      */
-    explicit Level(QGraphicsScene* graphicsScene, b2World* box2DWorld, QObject *parent);
+    explicit Level(QGraphicsScene* graphicsScene, b2World* box2DWorld, QObject *parent,
+                   int width = DEFAULT_WIDTH, int height = DEFAULT_HEIGHT);
 
     /**
      * Destructor for the level class.
@@ -55,20 +76,52 @@ public:
      * @param x - X position on the game grid.
      * @param y - Y position on the game grid.
      */
-    void drawWire(int x, int y, QString tag);
+    void drawWire(int x, int y, Tag tag);
+
+    /**
+     * @brief routeWire - Draws the shortest wire between an output and an input port,
+     * connecting it square by square like drawWire. The whole route is one undo step.
+     * @param sourceX - X position of a ROOT node, either half of a gate, or a finished wire to
+     * branch the route off.
+     * @param sourceY - Y position of the source.
+     * @param targetX - X position of an END node or a gate half with an open input.
+     * @param targetY - Y position of the target.
+     * @param tag - The tag of the wire.
+     * @return False if nothing was drawn because the ports can't be wired or no route exists.
+     */
+    bool routeWire(int sourceX, int sourceY, int targetX, int targetY, Tag tag);
+
+    /**
+     * @brief DEFAULT_WIDTH - The width of the hand-built levels.
+     */
+    static const int DEFAULT_WIDTH = 12;
+
+    /**
+     * @brief DEFAULT_HEIGHT - The height of the hand-built levels.
+     */
+    static const int DEFAULT_HEIGHT = 8;
+
+    /**
+     * @brief getWidth - Getter for the width of this level's board.
+     * @return The board width, in cells.
+     */
+    int getWidth();
 
     /**
-     * @brief WIDTH - The width of the level.
+     * @brief getHeight - Getter for the height of this level's board.
+     * @return The board height, in cells.
      */
-    static const int WIDTH = 12;
+    int getHeight();
 
     /**
-     * @brief HEIGHT - The height of the level.
+     * @brief resize - Clears the level and changes the size of its board.
+     * @param width - The new width of the board, in cells.
+     * @param height - The new height of the board, in cells.
      */
-    static const int HEIGHT = 8;
+    void resize(int width, int height);
 
     /**
-     * @brief getWire - Gets the wire from the wireGrid.
+     * @brief getWire - Gets the wire at a grid square.
      * @param x - X position on the grid.
      * @param y - Y position on the grid.
      * @return The wire in question.
@@ -76,7 +129,7 @@ public:
     Wire* getWire(int x, int y);
 
     /**
-     * @brief getGate - Gets the gate from the gateGrid.
+     * @brief getGate - Gets the gate at a grid square.
      * @param x - X position on the grid.
      * @param y - Y position on the grid.
      * @return The gate in question.
@@ -84,30 +137,123 @@ public:
     Gate* getGate(int x, int y);
 
     /**
-     * @brief getNode - Gets the node from the nodeGrid.
+     * @brief isGateOnLoop - Checks whether the gate at a grid square is part of a feedback loop.
+     * @param x - X position on the grid.
+     * @param y - Y position on the grid.
+     * @return True if there is a gate there and its output feeds back into its inputs.
+     */
+    bool isGateOnLoop(int x, int y);
+
+    /**
+     * @brief isGateOscillating - Checks whether the gate at a grid square is on a loop that
+     * never settled the last time signals were propagated.
+     * @param x - X position on the grid.
+     * @param y - Y position on the grid.
+     * @return True if there is a gate there and its loop is oscillating.
+     */
+    bool isGateOscillating(int x, int y);
+
+    /**
+     * @brief getNode - Gets the node at a grid square.
      * @param x - X position on the grid.
      * @param y - Y position on the grid.
      * @return The node in question.
      */
     Node* getNode(int x, int y);
 
+    /**
+     * @brief copyLayout - Replaces this level's contents with the nodes, gates and obstacles of
+     * another level, taking on its board size. Wires are not copied. Runs in the number of
+     * components, plus one copy of the obstacle words.
+     * @param other - The level to copy from.
+     */
+    void copyLayout(Level* other);
+
+    /**
+     * @brief loadLayout - Adds the nodes, gates and obstacles of a level pack layout by making
+     * its setup calls in order. A layout of another size clears the level and resizes the
+     * board to fit it first.
+     * @param layout - The decoded layout.
+     */
+    void loadLayout(const LevelPack::Layout& layout);
+
+    /**
+     * @brief getNodes - Getter for every ROOT and END node in the level.
+     * @return The nodes, in the order they were placed.
+     */
+    QVector<Node*> getNodes();
+
+    /**
+     * @brief getGates - Getter for every gate half in the level.
+     * @return The gate halves, in the order they were placed.
+     */
+    QVector<Gate*> getGates();
+
     /**
     * @brief setNode - Adds a node at the specified x and y position into the level.
     * @param x - The x position.
     * @param y - The y position.
-    * @param signal - The output value, true or false.
-    * @param tag - The ID of the node.
+    * @param signal - The output value, true or false, or a whole vector for a bus node. An END
+    * node only accepts a bus of the same width carrying the same vector.
+    * @param tag - The display string of the node's tag, e.g. "AB".
     * @param type - Specifies whether it is a ROOT or END node.
     */
-    void setNode(int x, int y, bool signal, QString tag, Node::Type type);
+    void setNode(int x, int y, Bus signal, QString tag, Node::Type type);
+
+    /**
+     * @brief setNodeSignal - Changes the signal of the ROOT node at the x and y position and
+     * propagates the change through every wire and gate downstream of it.
+     * @param x - The x position.
+     * @param y - The y position.
+     * @param signal - The new output value, true or false, or a whole vector for a bus node.
+     */
+    void setNodeSignal(int x, int y, const Bus& signal);
 
     /**
-     * @brief getObstacle - Gets the obstacle from the obstacleGrid.
+     * @brief getObstacle - Checks for an obstacle at a grid square.
      * @param x - X position on the grid.
      * @param y - Y position on the grid.
-     * @return The wire in question.
+     * @return True if the square is blocked.
+     */
+    bool getObstacle(int x, int y);
+
+    /**
+     * @brief hasObstacleIn - Checks whether any square of a rectangle is blocked.
+     * @param x - The left column.
+     * @param y - The top row.
+     * @param width - The number of columns.
+     * @param height - The number of rows.
+     * @return True if at least one square of the rectangle holds an obstacle.
+     */
+    bool hasObstacleIn(int x, int y, int width, int height);
+
+    /**
+     * @brief getObstacleCount - Getter for the number of blocked squares in the level.
+     * @return The obstacle count.
+     */
+    int getObstacleCount();
+
+    /**
+     * @brief getObstacleLayer - Getter for every obstacle of the level at once.
+     * @return A copy of the obstacle layer. It shares its bits with the level's until either is
+     * changed, so it costs nothing to take and can be read from other threads.
+     */
+    ObstacleLayer getObstacleLayer();
+
+    /**
+     * @brief getOccupiedSquares - Lists the squares holding a node, gate or wire. Empty stretches
+     * of the board are skipped 64 squares at a time.
+     * @return The squares, row by row.
+     */
+    QVector<QPoint> getOccupiedSquares();
+
+    /**
+     * @brief getComponent - Gets the kind of component occupying a grid square.
+     * @param x - X position on the grid.
+     * @param y - Y position on the grid.
+     * @return The component kind, or NONE for empty and out of bounds squares.
      */
-    Obstacle* getObstacle(int x, int y);
+    Component getComponent(int x, int y);
 
     /**
      * @brief updateLevel - Updates the level to initial start-up procedure.
@@ -142,14 +288,17 @@ public:
      * @brief drawGate - Draws the Gate at a certain X and Y Coordinate.
      * @param x - Given X Coordinate.
      * @param y - Given Y Coordinate.
-     * @param op - Given Operator to use.
+     * @param op - Given Operator to use. Operators with a select input, i.e. MUX, have no square
+     * for it and are not drawn.
      * @param dir - The direction the gate faces.
      */
     void drawGate(int x, int y, Gate::Operator op, Gate::Direction dir);
 
     /**
-     * @brief levelSetup - Sets up the level based on the passed in level number.
-     * @param level - The level number chosen to set up.
+     * @brief levelSetup - Sets up the level based on the passed in level number, decoding its
+     * layout from the built-in level pack.
+     * @param level - The level number chosen to set up. Numbers missing from the pack set up
+     * the default layout at index 0.
      */
     void levelSetup(int level);
 
@@ -177,6 +326,56 @@ public:
      */
     void clearNodes();
 
+    /**
+     * @brief beginEdit - Starts grouping edits into one undo step. Every wire edit is already its
+     * own step; use this to merge several, e.g. a whole mouse drag. Calls nest.
+     */
+    void beginEdit();
+
+    /**
+     * @brief endEdit - Finishes the undo step started by the matching beginEdit.
+     */
+    void endEdit();
+
+    /**
+     * @brief undo - Reverts the most recent undo step.
+     * @return True if anything was undone.
+     */
+    bool undo();
+
+    /**
+     * @brief redo - Reapplies the most recently undone step.
+     * @return True if anything was redone.
+     */
+    bool redo();
+
+    /**
+     * @brief canUndo - Checks if there is a step to undo.
+     * @return True if undo() would do something.
+     */
+    bool canUndo();
+
+    /**
+     * @brief canRedo - Checks if there is a step to redo.
+     * @return True if redo() would do something.
+     */
+    bool canRedo();
+
+    /**
+     * @brief clearHistory - Forgets every undo and redo step. Placing nodes or gates and
+     * clearing the level also clear the history.
+     */
+    void clearHistory();
+
+    /**
+     * @brief takeDirtyCells - Hands over the squares whose contents or looks changed since the
+     * last call, and starts collecting again.
+     * @param cells - Filled with the changed squares, each once.
+     * @return False if the whole board changed instead, e.g. the level was just set up or
+     * cleared. cells is left empty and everything should be redrawn.
+     */
+    bool takeDirtyCells(QVector<QPoint>& cells);
+
 private:
     /**
      * @brief box2DWorld - The Box2D World.
@@ -199,24 +398,194 @@ private:
     bool isVictory;
 
     /**
-     * @brief wireGrid
+     * @brief unconnectedNodes - The number of ROOT and END nodes not yet fully connected. Kept
+     * up to date by every edit so victory checks don't scan the nodes.
+     */
+    int unconnectedNodes;
+
+    /**
+     * @brief Cell - A single square of the board, pointing into the dense storage lists.
+     */
+    using Cell = CellGrid::Cell;
+
+    /**
+     * @brief NEIGHBOR_SIDES - The side of a square each of CellGrid's neighbors lies on.
+     */
+    static constexpr Wire::Direction NEIGHBOR_SIDES[4] = {
+        Wire::Direction::N, Wire::Direction::E, Wire::Direction::S, Wire::Direction::W
+    };
+
+    /**
+     * @brief NEIGHBOR_FACING - The side of each of CellGrid's neighbors that faces back toward
+     * the square.
      */
-    Wire* wireGrid[WIDTH * HEIGHT];
+    static constexpr Node::Direction NEIGHBOR_FACING[4] = {
+        Node::Direction::S, Node::Direction::W, Node::Direction::N, Node::Direction::E
+    };
 
     /**
-     * @brief gateGrid
+     * @brief grid - The board squares. One lookup answers both what is in a square and
+     * where to find it.
      */
-    Gate* gateGrid[WIDTH * HEIGHT];
+    CellGrid grid;
 
     /**
-     * @brief nodeGrid
+     * @brief wirePool - Owns the records of every wire in the level, including the backing
+     * wires of nodes and gates.
      */
-    Node* nodeGrid[WIDTH * HEIGHT];
+    WirePool wirePool;
 
     /**
-     * @brief obstacleGrid
+     * @brief wires - Dense storage for the pool ids of the wires placed on the board.
      */
-    Obstacle* obstacleGrid[WIDTH * HEIGHT];
+    QVector<Wire::Id> wires;
+
+    /**
+     * @brief gates - Dense storage for the gate halves placed on the board.
+     */
+    QVector<Gate*> gates;
+
+    /**
+     * @brief nodes - Dense storage for the ROOT and END nodes placed on the board.
+     */
+    QVector<Node*> nodes;
+
+    /**
+     * @brief obstacles - The blocked squares of the board. Obstacles are kept out of the grid
+     * since they have no state.
+     */
+    ObstacleLayer obstacles;
+
+    /**
+     * @brief occupied - The squares holding a node, gate or wire, kept in step with the grid so
+     * obstacle rectangles can skip them a word at a time.
+     */
+    ObstacleLayer occupied;
+
+    /**
+     * @brief propagator - Re-propagates signals through the circuit after each edit.
+     */
+    Propagator propagator;
+
+    /**
+     * @brief journal - The undo and redo history of wire edits.
+     */
+    Journal journal;
+
+    /**
+     * @brief router - Finds routes for routeWire.
+     */
+    Router router;
+
+    /**
+     * @brief dirtyCells - The squares changed since the last takeDirtyCells call, each once.
+     */
+    QVector<QPoint> dirtyCells;
+
+    /**
+     * @brief dirtyMarks - The squares already in dirtyCells, numbered row by row. Only changed
+     * squares take memory, so large boards cost nothing until they are edited.
+     */
+    QSet<quint32> dirtyMarks;
+
+    /**
+     * @brief allDirty - Whether the whole board changed since the last takeDirtyCells call.
+     */
+    bool allDirty;
+
+    /**
+     * @brief markCellDirty - Notes that a square needs redrawing.
+     * @param x - X position on the grid.
+     * @param y - Y position on the grid.
+     */
+    void markCellDirty(int x, int y);
+
+    /**
+     * @brief markAllDirty - Notes that the whole board needs redrawing.
+     */
+    void markAllDirty();
+
+    /**
+     * @brief placeWire - Places a wire on an empty square and connects it to whatever port
+     * or wire end is next to it. With none around, it branches off a finished wire of the same
+     * tag instead. Signals are not propagated.
+     * @param x - X position on the game grid.
+     * @param y - Y position on the game grid.
+     * @param tag - The tag of the wire.
+     */
+    void placeWire(int x, int y, Tag tag);
+
+    /**
+     * @brief cellAt - Gets the cell at the x and y position.
+     * @param x - X position on the grid.
+     * @param y - Y position on the grid.
+     * @return The cell in question. Out of bounds positions read as an empty cell.
+     */
+    Cell cellAt(int x, int y);
+
+    /**
+     * @brief placeComponent - Points a cell at a component in dense storage.
+     * @param x - X position on the grid.
+     * @param y - Y position on the grid.
+     * @param kind - The kind of component placed.
+     * @param index - The index of the component in its dense storage list.
+     */
+    void placeComponent(int x, int y, Component kind, qsizetype index);
+
+    /**
+     * @brief removeWireAt - Removes a wire from dense storage by moving the last wire into
+     * its slot. Does not release the wire.
+     * @param index - The index of the wire in the wires list.
+     */
+    void removeWireAt(quint32 index);
+
+    /**
+     * @brief attachWire - Puts a wire on an empty square and logs it in the journal.
+     * @param x - X position on the grid.
+     * @param y - Y position on the grid.
+     * @param id - The pool id of the wire.
+     */
+    void attachWire(int x, int y, Wire::Id id);
+
+    /**
+     * @brief detachWire - Takes the wire off a square and logs it in the journal. The wire
+     * itself is left alone.
+     * @param x - X position on the grid.
+     * @param y - Y position on the grid.
+     */
+    void detachWire(int x, int y);
+
+    /**
+     * @brief releaseWire - Returns a wire taken off the board to the pool, unless the journal is
+     * recording and may still need to put it back.
+     * @param id - The pool id of the wire.
+     */
+    void releaseWire(Wire::Id id);
+
+    /**
+     * @brief isWireOnBoard - Checks whether a wire is currently placed on the board.
+     * @param id - The pool id of the wire.
+     * @return True if the wire's square holds it.
+     */
+    bool isWireOnBoard(Wire::Id id);
+
+    /**
+     * @brief trackConnection - Updates the unconnected node count after a wire's connections
+     * were changed. Does nothing unless the wire is the backing wire of a node on the board.
+     * @param wire - The wire that was relinked.
+     * @param wasConnected - Whether the wire was fully connected before the change.
+     */
+    void trackConnection(Wire* wire, bool wasConnected);
+
+    /**
+     * @brief recountNodes - Recounts the unconnected nodes from scratch. Used after bulk resets.
+     */
+    void recountNodes();
+
+    /**
+     * @brief propagateSignals - Runs the propagator and counts any END nodes it unplugged.
+     */
+    void propagateSignals();
 
     /**
      * @brief wireCheck - Private helper to reduce the redundency in the wireDraw method.
@@ -229,25 +598,54 @@ private:
     void wireCheck(Wire* currentWire, Wire* checkingWire);
 
     /**
-     * @brief wireRemove - Remove the current wire.
-     * @param currentWire - The pointer to the wire you want to remove.
+     * @brief wireRemove - Removes the open end hanging off the current wire, from its tail or
+     * one of its branches.
+     * @param currentWire - The pointer to the wire to go back to.
      */
     void wireRemove(Wire* currentWire);
 
+    /**
+     * @brief findOpenTail - Finds a tail or branch of a wire that is an open end.
+     * @param currentWire - The wire to check.
+     * @return The pointer to the open end, or nullptr if every tail continues.
+     */
+    Wire* findOpenTail(Wire* currentWire);
+
+    /**
+     * @brief removeTree - Removes a wire and everything downstream of it, following every
+     * branch and carrying on through the outputs of the gates it feeds.
+     * @param firstWire - The first wire to remove, or nullptr.
+     */
+    void removeTree(Wire* firstWire);
+
     /**
      * @brief findWire - Checks all coordinates nearby and returns a pointer to a valid wire
      * nearby. Valid wires are: Same tag, not connected to a tail, not null.
      * Only head-connecting wires are valid.
      * The Wire::Direction enum reference is passed through to store the direction at which the
      * wire was found.
-     * @param x - The coordinate x position to check around.
-     * @param y - The coordinate y position to check around.
+     * @param around - The squares above, right, below and left of the one to check around, as
+     * read by CellGrid::neighbors.
      * @param tag - The tag of the wire to link up to.
      * @param wireConnectionDirection - The relative direction of where the wire was found at the
      * coordinates.
      * @return The pointer to the neighboring valid wire. Returns nullptr otherwise.
      */
-    Wire* findWire(int x, int y, QString tag, Wire::Direction& wireConnectionDirection);
+    Wire* findWire(const Cell around[4], Tag tag, Wire::Direction& wireConnectionDirection);
+
+    /**
+     * @brief findJunction - Checks all coordinates nearby for a wire to branch off. Valid wires
+     * are: Same tag, fully connected, drawn on the board, with a free branch.
+     * The Wire::Direction enum reference is passed through to store the direction at which the
+     * wire was found.
+     * @param around - The squares above, right, below and left of the one to check around, as
+     * read by CellGrid::neighbors.
+     * @param tag - The tag of the wire to branch off.
+     * @param wireConnectionDirection - The relative direction of where the wire was found at the
+     * coordinates.
+     * @return The pointer to the neighboring junction. Returns nullptr otherwise.
+     */
+    Wire* findJunction(const Cell around[4], Tag tag, Wire::Direction& wireConnectionDirection);
 
     /**
      * @brief findInputNode - Checks all coordinates nearby for a valid END node. Valid nodes are:
@@ -255,15 +653,15 @@ private:
      * already been established.
      * The Wire::Direction enum reference is passed through to store the direction at which the
      * node was found.
-     * @param x - The coordinate x position to check around.
-     * @param y - The coordinate y position to check around.
+     * @param around - The squares above, right, below and left of the one to check around, as
+     * read by CellGrid::neighbors.
      * @param tag - The current tag to match.
      * @param signal - The signal to compare to.
      * @param wireConnectionDirection - The relative direction of where the node was found at the
      * coordinates.
      * @return The pointer to the neighboring valid END node. Returns nullptr otherwise.
      */
-    Node* findInputNode(int x, int y, QString tag, bool signal, Wire::Direction& wireConnectionDirection);
+    Node* findInputNode(const Cell around[4], Tag tag, const Bus& signal, Wire::Direction& wireConnectionDirection);
 
     /**
      * @brief findOutputNode - Checks all coordinates nearby and returns a pointer to a valid ROOT node.
@@ -271,40 +669,40 @@ private:
      * equal to where the node was found or has a direction of NONE.
      * The Wire::Direction enum reference is passed through to store the direction at which the
      * node was found.
-     * @param x - The coordinate x position to check around.
-     * @param y - The coordinate y position to check around.
+     * @param around - The squares above, right, below and left of the one to check around, as
+     * read by CellGrid::neighbors.
      * @param tag - The current tag to match.
      * @param wireConnectionDirection - The relative direction of where the node was found at the
      * coordinates.
      * @return The pointer to the neighboring valid ROOT node. Returns nullptr otherwise.
      */
-    Node* findOutputNode(int x, int y, QString tag, Wire::Direction& wireConnectionDirection);
+    Node* findOutputNode(const Cell around[4], Tag tag, Wire::Direction& wireConnectionDirection);
 
     /**
      * @brief findInputGate - Checks all coordinates nearby and returns a pointer to a valid
      * gate input. Valid gates are: Not fully connected, matching input direction.
      * The Wire::Direction enum reference is passed through to store the direction at which the
      * node was found.
-     * @param x - The coordinate x position to check around.
-     * @param y - The coordinate y position to check around.
+     * @param around - The squares above, right, below and left of the one to check around, as
+     * read by CellGrid::neighbors.
      * @param wireConnectionDirection - The relative direction of where the node was found at the
      * coordinates.
      * @return The pointer to the neighboring valid input gate. Returns nullptr otherwise.
      */
-    Gate* findInputGate(int x, int y, Wire::Direction& wireConnectionDirection);
+    Gate* findInputGate(const Cell around[4], Wire::Direction& wireConnectionDirection);
 
     /**
      * @brief findOutputGate - Checks all coordinates nearby and returns a pointer to a valid
      * gate output. Valid gates are: Fully connected, matching output direction, matching tag.
      * The Wire::Direction enum reference is passed through to store the direction at which the
      * node was found.
-     * @param x - The coordinate x position to check around.
-     * @param y - The coordinate y position to check around.
+     * @param around - The squares above, right, below and left of the one to check around, as
+     * read by CellGrid::neighbors.
      * @param wireConnectionDirection - The relative direction of where the node was found at the
      * coordinates.
      * @return The pointer to the neighboring valid output gate. Returns nullptr otherwise.
      */
-    Gate* findOutputGate(int x, int y, QString tag, Wire::Direction& wireConnectionDirection);
+    Gate* findOutputGate(const Cell around[4], Tag tag, Wire::Direction& wireConnectionDirection);
 
     /**
      * @brief setWire - Updates the wire pointer on the grid and sets the head and tail connections
@@ -340,6 +738,15 @@ private:
      */
     void addObstacle(int x, int y);
 
+    /**
+     * @brief addObstacleRect - Adds obstacles to every empty square of a rectangle.
+     * @param x - The left column.
+     * @param y - The top row.
+     * @param width - The number of columns.
+     * @param height - The number of rows.
+     */
+    void addObstacleRect(int x, int y, int width, int height);
+
     /**
      * @brief calculateGateOffset - Helper method to calculate the offset of
      * the x and y positions for the otherHalf of this gate.
@@ -352,8 +759,8 @@ private:
     void calculateGateOffset(Gate::Direction dir, int& xOffset, int& yOffset);
 
     /**
-     * @brief placeBorder - Helper method that places a 2-block wide obstacle border in the
-     * current level.
+     * @brief placeBorder - Helper method that places a 2-block wide obstacle border around
+     * the edge of the current level.
      */
     void placeBorder();
 
@@ -0,0 +1,234 @@
+#include "levelpack.h"
+#include "gatekernels.h"
+#include <QtEndian>
+#include <cstring>
+
+const char* const LevelPack::BUILT_IN_PATH = ":/levels/levels.pack";
+
+namespace {
+
+const char MAGIC[4] = {'L', 'G', 'P', 'K'};
+
+template<typename T>
+void appendLittleEndian(QByteArray& bytes, T value) {
+    char buffer[sizeof(T)];
+    qToLittleEndian<T>(value, buffer);
+    bytes.append(buffer, sizeof(T));
+}
+
+template<typename T>
+T readLittleEndian(const uchar* bytes) {
+    return qFromLittleEndian<T>(bytes);
+}
+
+}
+
+LevelPack::LevelPack()
+    : data(nullptr), size(0), levelCount(0) {
+}
+
+const LevelPack& LevelPack::builtIn() {
+    static LevelPack pack;
+    static bool opened = pack.open(BUILT_IN_PATH);
+    Q_UNUSED(opened);
+    return pack;
+}
+
+bool LevelPack::open(const QString& path) {
+    close();
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    size = file.size();
+    data = file.map(0, size);
+    if (data == nullptr) {
+        buffer = file.readAll();
+        data = reinterpret_cast<const uchar*>(buffer.constData());
+        size = buffer.size();
+    }
+
+    // Only the header and the bounds of the index are checked here. Each level is checked
+    // when it is read.
+    quint16 version = size < HEADER_SIZE ? 0 : readLittleEndian<quint16>(data + 4);
+    if (size < HEADER_SIZE || memcmp(data, MAGIC, sizeof(MAGIC)) != 0 || version == 0
+        || version > VERSION) {
+        close();
+        return false;
+    }
+    quint32 count = readLittleEndian<quint32>(data + 8);
+    if (count > quint64(size - HEADER_SIZE) / INDEX_ENTRY_SIZE) {
+        close();
+        return false;
+    }
+    levelCount = int(count);
+    return true;
+}
+
+int LevelPack::getLevelCount() const {
+    return levelCount;
+}
+
+bool LevelPack::readLevel(int index, Layout& layout) const {
+    layout.records.clear();
+    if (index < 0 || index >= levelCount)
+        return false;
+    const uchar* entry = data + HEADER_SIZE + index * INDEX_ENTRY_SIZE;
+    quint64 offset = readLittleEndian<quint32>(entry);
+    quint64 levelSize = readLittleEndian<quint32>(entry + 4);
+    if (levelSize < LEVEL_HEADER_SIZE || offset + levelSize > quint64(size))
+        return false;
+
+    const uchar* level = data + offset;
+    layout.width = readLittleEndian<quint16>(level);
+    layout.height = readLittleEndian<quint16>(level + 2);
+    quint32 recordCount = readLittleEndian<quint32>(level + 4);
+    if (layout.width == 0 || layout.height == 0
+        || recordCount > (levelSize - LEVEL_HEADER_SIZE) / RECORD_SIZE)
+        return false;
+
+    // The lane words of bus signals fill the rest of the level.
+    layout.records.resize(recordCount);
+    const uchar* bytes = level + LEVEL_HEADER_SIZE;
+    const uchar* lanes = bytes + recordCount * RECORD_SIZE;
+    quint32 laneWords = (levelSize - LEVEL_HEADER_SIZE - recordCount * RECORD_SIZE)
+                        / LANE_WORD_SIZE;
+    for (quint32 i = 0; i < recordCount; i++, bytes += RECORD_SIZE) {
+        if (!decodeRecord(bytes, lanes, laneWords, layout.records[i])
+            || !fitsBoard(layout.records[i], layout.width, layout.height)) {
+            layout.records.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LevelPack::write(const QString& path, const QVector<Layout>& layouts) {
+    QByteArray bytes;
+    bytes.append(MAGIC, sizeof(MAGIC));
+    appendLittleEndian<quint16>(bytes, VERSION);
+    appendLittleEndian<quint16>(bytes, 0);
+    appendLittleEndian<quint32>(bytes, quint32(layouts.size()));
+
+    // Levels follow the index, so their offsets are known before any is encoded.
+    quint32 offset = HEADER_SIZE + layouts.size() * INDEX_ENTRY_SIZE;
+    for (const Layout& layout : layouts) {
+        int laneWords = 0;
+        for (const Record& record : layout.records)
+            laneWords += laneWordCount(record);
+        if (laneWords > MAX_LANE_WORDS)
+            return false;
+        quint32 levelSize = LEVEL_HEADER_SIZE + layout.records.size() * RECORD_SIZE
+                            + laneWords * LANE_WORD_SIZE;
+        appendLittleEndian<quint32>(bytes, offset);
+        appendLittleEndian<quint32>(bytes, levelSize);
+        offset += levelSize;
+    }
+    for (const Layout& layout : layouts) {
+        appendLittleEndian<quint16>(bytes, quint16(layout.width));
+        appendLittleEndian<quint16>(bytes, quint16(layout.height));
+        appendLittleEndian<quint32>(bytes, quint32(layout.records.size()));
+        QByteArray lanes;
+        for (const Record& record : layout.records)
+            encodeRecord(record, bytes, lanes);
+        bytes.append(lanes);
+    }
+
+    QFile output(path);
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    return output.write(bytes) == bytes.size();
+}
+
+void LevelPack::close() {
+    if (file.isOpen())
+        file.close();
+    buffer.clear();
+    data = nullptr;
+    size = 0;
+    levelCount = 0;
+}
+
+int LevelPack::laneWordCount(const Record& record) {
+    if (record.kind != Kind::ROOT && record.kind != Kind::END)
+        return 0;
+    int width = record.signal.getWidth();
+    return width == 1 ? 0 : (width + 63) / 64;
+}
+
+void LevelPack::encodeRecord(const Record& record, QByteArray& bytes, QByteArray& lanes) {
+    // A one-lane signal sits in the value byte. A bus has its width and the index of its first
+    // lane word instead, with the words themselves after the records.
+    int laneWords = laneWordCount(record);
+    int width = laneWords == 0 ? 0 : record.signal.getWidth();
+    int firstLane = lanes.size() / LANE_WORD_SIZE;
+    for (int i = 0; i < laneWords; i++)
+        appendLittleEndian<quint64>(lanes, record.signal.getWord(i));
+    quint8 value = record.kind == Kind::GATE ? quint8(record.op)
+                                             : quint8(laneWords == 0 && record.signal.isHigh());
+    appendLittleEndian<quint8>(bytes, quint8(record.kind));
+    appendLittleEndian<quint8>(bytes, value);
+    appendLittleEndian<quint8>(bytes, quint8(record.direction));
+    appendLittleEndian<quint8>(bytes, quint8(qBound(0, record.delay, int(Gate::MAX_DELAY))));
+    appendLittleEndian<quint16>(bytes, quint16(record.x));
+    appendLittleEndian<quint16>(bytes, quint16(record.y));
+    appendLittleEndian<quint16>(bytes, quint16(record.width));
+    appendLittleEndian<quint16>(bytes, quint16(record.height));
+    appendLittleEndian<quint16>(bytes, quint16(width));
+    appendLittleEndian<quint16>(bytes, quint16(laneWords == 0 ? 0 : firstLane));
+    appendLittleEndian<quint64>(bytes, record.tag.getWord(0));
+}
+
+bool LevelPack::decodeRecord(const uchar* bytes, const uchar* lanes, quint32 laneWords,
+                             Record& record) {
+    quint8 kind = bytes[0];
+    quint8 value = bytes[1];
+    quint8 direction = bytes[2];
+    if (kind > quint8(Kind::BORDER) || direction > quint8(Gate::Direction::WEST))
+        return false;
+    record.kind = Kind(kind);
+    if (record.kind == Kind::GATE && value >= GateKernels::OPERATOR_COUNT)
+        return false;
+    record.signal = value != 0;
+    record.op = record.kind == Kind::GATE ? Gate::Operator(value) : Gate::Operator::AND;
+    record.direction = Gate::Direction(direction);
+    record.delay = bytes[3];
+    record.x = readLittleEndian<quint16>(bytes + 4);
+    record.y = readLittleEndian<quint16>(bytes + 6);
+    record.width = readLittleEndian<quint16>(bytes + 8);
+    record.height = readLittleEndian<quint16>(bytes + 10);
+
+    // Version 1 packs leave the bus fields zero, which reads as a one-lane signal.
+    quint16 width = readLittleEndian<quint16>(bytes + 12);
+    quint32 firstLane = readLittleEndian<quint16>(bytes + 14);
+    if (width > 1) {
+        quint32 words = (width + 63) / 64;
+        if ((record.kind != Kind::ROOT && record.kind != Kind::END) || width > Bus::MAX_WIDTH
+            || firstLane + words > laneWords)
+            return false;
+        quint64 source[Bus::WORDS];
+        for (quint32 i = 0; i < words; i++)
+            source[i] = readLittleEndian<quint64>(lanes + (firstLane + i) * LANE_WORD_SIZE);
+        record.signal = Bus::fromWords(width, source);
+    }
+
+    // Tags are stored as their bitset. Bits without a root ID character can't come from a
+    // level designer, so they mark a corrupt record.
+    quint64 tagBits = readLittleEndian<quint64>(bytes + 16);
+    if (tagBits >> Tag::ID_COUNT)
+        return false;
+    record.tag = Tag();
+    record.tag.setWord(0, tagBits);
+    return true;
+}
+
+bool LevelPack::fitsBoard(const Record& record, int width, int height) {
+    // The border is sized from the board itself, so its position fields mean nothing.
+    if (record.kind == Kind::BORDER)
+        return true;
+    if (record.x >= width || record.y >= height)
+        return false;
+    if (record.kind != Kind::OBSTACLES)
+        return true;
+    return record.width > 0 && record.height > 0 && record.width <= width - record.x
+           && record.height <= height - record.y;
+}
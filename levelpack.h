@@ -0,0 +1,227 @@
+/**
+ * This class reads and writes level packs, the binary files the level
+ * layouts ship in. A pack starts with a versioned header and an index
+ * holding the offset and size of every level, followed by each level's
+ * size, a list of fixed-size little-endian records and the lane words of
+ * any bus signals. The records are the setup calls of the level in the
+ * order they are made, so a layout is rebuilt exactly as it was designed.
+ * A one-lane signal is kept in its record, and a wider one points at its
+ * lane words after the records. Opening a pack maps the file
+ * into memory and checks only the header and index, so it takes the
+ * same time however many levels the pack holds. A level is decoded the
+ * first time it is asked for.
+ *
+ * @authors Max Donaldson, Jason Khong,
+ * Ariadne Petroulakis, Evan Tucker, and Ian Weller
+ *
+ * @version 22 April 2025
+ */
+
+#ifndef LEVELPACK_H
+#define LEVELPACK_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include "gate.h"
+#include "node.h"
+#include "tag.h"
+
+class LevelPack {
+
+public:
+    /**
+     * @brief The Kind enum - The setup call a record stands for.
+     * ROOT and END call setNode, GATE calls drawGate, OBSTACLES calls addObstacleRect and
+     * BORDER calls placeBorder.
+     */
+    enum class Kind {
+        ROOT, END, GATE, OBSTACLES, BORDER
+    };
+
+    /**
+     * @brief The Record struct - One decoded setup call of a level. A GATE record's delay is its
+     * propagation delay in simulator ticks, with 0 meaning the default of one. A ROOT or END
+     * record's signal may be a bus of any width. Fields not given, e.g. in
+     * Record{Kind::GATE, x, y}, describe a one square, false, default delay AND gate facing NORTH.
+     */
+    struct Record {
+        Kind kind = Kind::ROOT;
+        int x = 0;
+        int y = 0;
+        int width = 1;
+        int height = 1;
+        Bus signal = false;
+        Gate::Operator op = Gate::Operator::AND;
+        Gate::Direction direction = Gate::Direction::NORTH;
+        int delay = 0;
+        Tag tag;
+    };
+
+    /**
+     * @brief The Layout struct - The board size and setup calls of one level.
+     */
+    struct Layout {
+        int width;
+        int height;
+        QVector<Record> records;
+    };
+
+    /**
+     * @brief VERSION - The format version written to the header. Version 1 packs hold no
+     * buses and read the same way.
+     */
+    static const quint16 VERSION = 2;
+
+    /**
+     * @brief BUILT_IN_PATH - The resource path of the pack the game's levels ship in.
+     */
+    static const char* const BUILT_IN_PATH;
+
+    /**
+     * @brief LevelPack - Creates a pack with no levels. Call open to read one.
+     */
+    LevelPack();
+
+    /**
+     * @brief builtIn - Getter for the pack the game's levels ship in. It is opened the first
+     * time it is asked for.
+     * @return The built-in pack.
+     */
+    static const LevelPack& builtIn();
+
+    /**
+     * @brief open - Maps a pack file into memory and checks its header and index. The file is
+     * read whole instead if it can't be mapped.
+     * @param path - The path of the pack.
+     * @return False if the file can't be read or isn't a pack of a version up to VERSION. The
+     * pack then holds no levels.
+     */
+    bool open(const QString& path);
+
+    /**
+     * @brief getLevelCount - Getter for the number of levels in the pack.
+     * @return The level count.
+     */
+    int getLevelCount() const;
+
+    /**
+     * @brief readLevel - Decodes one level of the pack.
+     * @param index - The level index, below getLevelCount.
+     * @param layout - Receives the size and setup calls of the level.
+     * @return False if the index is out of range or the level's data is damaged, including a
+     * board with no squares or records off the board.
+     */
+    bool readLevel(int index, Layout& layout) const;
+
+    /**
+     * @brief write - Writes levels to a pack file.
+     * @param path - The path of the pack.
+     * @param layouts - The levels, in index order.
+     * @return False if the file can't be written.
+     */
+    static bool write(const QString& path, const QVector<Layout>& layouts);
+
+private:
+    /**
+     * @brief HEADER_SIZE - Bytes of the pack header: magic, version, reserved and level count.
+     */
+    static const int HEADER_SIZE = 12;
+
+    /**
+     * @brief INDEX_ENTRY_SIZE - Bytes of one index entry: level offset and size.
+     */
+    static const int INDEX_ENTRY_SIZE = 8;
+
+    /**
+     * @brief LEVEL_HEADER_SIZE - Bytes of a level header: width, height and record count.
+     */
+    static const int LEVEL_HEADER_SIZE = 8;
+
+    /**
+     * @brief RECORD_SIZE - Bytes of one record.
+     */
+    static const int RECORD_SIZE = 24;
+
+    /**
+     * @brief LANE_WORD_SIZE - Bytes of one word of bus lanes.
+     */
+    static const int LANE_WORD_SIZE = 8;
+
+    /**
+     * @brief MAX_LANE_WORDS - The most lane words one level can hold, as a record addresses its
+     * first word with 16 bits.
+     */
+    static const int MAX_LANE_WORDS = 0x10000;
+
+    /**
+     * @brief file - The open pack file. Its mapping stays valid while it is open.
+     */
+    QFile file;
+
+    /**
+     * @brief buffer - The pack contents if the file couldn't be mapped.
+     */
+    QByteArray buffer;
+
+    /**
+     * @brief data - The start of the pack contents, or nullptr if none is open.
+     */
+    const uchar* data;
+
+    /**
+     * @brief size - The number of bytes at data.
+     */
+    qint64 size;
+
+    /**
+     * @brief levelCount - The number of levels in the index.
+     */
+    int levelCount;
+
+    /**
+     * @brief close - Unmaps and closes the pack, leaving no levels.
+     */
+    void close();
+
+    /**
+     * @brief laneWordCount - Gets the number of lane words a record's signal takes after the
+     * records.
+     * @param record - The record.
+     * @return The word count, 0 for a one-lane signal.
+     */
+    static int laneWordCount(const Record& record);
+
+    /**
+     * @brief encodeRecord - Appends the bytes of a record, and the lane words of a bus signal.
+     * @param record - The record.
+     * @param bytes - Receives the bytes.
+     * @param lanes - Receives the lane words of the level so far.
+     */
+    static void encodeRecord(const Record& record, QByteArray& bytes, QByteArray& lanes);
+
+    /**
+     * @brief decodeRecord - Reads a record from its bytes.
+     * @param bytes - The RECORD_SIZE bytes of the record.
+     * @param lanes - The lane words of the record's level.
+     * @param laneWords - The number of lane words at lanes.
+     * @param record - Receives the record.
+     * @return False if a field holds a value that isn't a valid enum, or a bus signal is too wide
+     * or its lanes are out of range.
+     */
+    static bool decodeRecord(const uchar* bytes, const uchar* lanes, quint32 laneWords,
+                             Record& record);
+
+    /**
+     * @brief fitsBoard - Checks that a record places nothing off the board of its level.
+     * @param record - The decoded record.
+     * @param width - The width of the level's board.
+     * @param height - The height of the level's board.
+     * @return False if the record's square, or any square of an obstacle rectangle, is off
+     * the board, or if an obstacle rectangle is empty.
+     */
+    static bool fitsBoard(const Record& record, int width, int height);
+};
+
+#endif // LEVELPACK_H
@@ -1,12 +1,14 @@
 #include "mainwindow.h"
+#include "gatekernels.h"
 #include "ui_mainwindow.h"
 #include <QGraphicsView>
 #include <QTimer>
 #include <QFontDatabase>
+#include <QtMath>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
-    , ui(new Ui::MainWindow), box2DWorld(nullptr), box2DBody(nullptr), timer(new QTimer(this)), frameCount(0), levelNum(0)
+    , ui(new Ui::MainWindow), lastFrameNs(0), box2DWorld(nullptr), box2DBody(nullptr), timer(new QTimer(this)), frameCount(0), levelNum(0)
 {
     ui->setupUi(this);
     setMouseTracking(true);
@@ -35,11 +37,7 @@ MainWindow::MainWindow(QWidget *parent)
     loadWirePixmaps();
     loadNodePixmaps();
     loadGatePixmaps();
-    int boardWidth = ui->gameBoard->width();
-    int boardHeight = ui->gameBoard->height();
-    componentLayer = QPixmap(boardWidth, boardHeight);
-    backgroundLayer = QPixmap(":/sprites/grid-12x8.png");
-    componentLayer.fill(Qt::transparent);
+    loadObjectPixmaps();
 
 
     // SETTING UP BOX2D
@@ -70,7 +68,7 @@ MainWindow::MainWindow(QWidget *parent)
     ui->lessonWidget->move(ui->gameBoard->pos().x(), -ui->lessonWidget->height());
 
     currentLevel = new Level(graphicsScene, box2DWorld, this);
-    currentTag = "";
+    currentTag = Tag();
     currentLevel->levelSetup(levelNum);
     repaint();
 
@@ -171,6 +169,7 @@ void MainWindow::updateWorld() {
         ui->lessonWidget->move(ui->gameBoard->pos().x(), -lessonWidgetHeight);
     }
     currentLevel->updateLevel();
+    showFinishedTiles();
     graphicsScene->update();
     graphicsView->update();
     graphicsView->viewport()->update();
@@ -178,6 +177,8 @@ void MainWindow::updateWorld() {
 }
 
 void MainWindow::loadWirePixmaps() {
+    QHash<QPair<Wire::Direction, QString>, QPixmap> wirePixmaps;
+
     //bue wires
     wirePixmaps.insert({Wire::Direction::EW, "blue"}, QPixmap(":/sprites/blue_wires/blue_wire_EW.png"));
     wirePixmaps.insert({Wire::Direction::NE, "blue"}, QPixmap(":/sprites/blue_wires/blue_wire_NE.png"));
@@ -201,9 +202,15 @@ void MainWindow::loadWirePixmaps() {
     wirePixmaps.insert({Wire::Direction::E, "red"}, QPixmap(":/sprites/red_wires/red_plug_left.png"));
     wirePixmaps.insert({Wire::Direction::S, "red"}, QPixmap(":/sprites/red_wires/red_plug_up.png"));
     wirePixmaps.insert({Wire::Direction::W, "red"}, QPixmap(":/sprites/red_wires/red_plug_right.png"));
+
+    // Each texture is scaled into the atlas and drawn by its id from then on.
+    for(auto it = wirePixmaps.cbegin(); it != wirePixmaps.cend(); ++it)
+        wireSprites.insert(it.key(), spriteAtlas.addSprite(it.value()));
 }
 
 void MainWindow::loadNodePixmaps() {
+    QHash<QPair<bool, Node::Type>, QPixmap> nodePixmaps;
+
     // Red buttons
     nodePixmaps.insert({false, Node::Type::ROOT}, QPixmap(":/sprites/red_wires/red_node_root.png"));
     nodePixmaps.insert({false, Node::Type::END}, QPixmap(":/sprites/red_wires/red_node_end.png"));
@@ -211,72 +218,274 @@ void MainWindow::loadNodePixmaps() {
     // Blue buttons
     nodePixmaps.insert({true, Node::Type::ROOT}, QPixmap(":/sprites/blue_wires/blue_node_root.png"));
     nodePixmaps.insert({true, Node::Type::END}, QPixmap(":/sprites/blue_wires/blue_node_end.png"));
+
+    for(auto it = nodePixmaps.cbegin(); it != nodePixmaps.cend(); ++it)
+        nodeSprites.insert(it.key(), spriteAtlas.addSprite(it.value()));
+}
+
+void MainWindow::loadObjectPixmaps() {
+    obstacleSprite = spriteAtlas.addSprite(QPixmap(":/sprites/objects/obsticle.png"));
+
+    // Loop outlines are drawn at the square size, so their pens keep the same width.
+    QColor loopColor(LOOP_COLOR);
+    for(bool oscillating : {false, true}) {
+        loopSprites[oscillating] = spriteAtlas.addSprite(
+            [loopColor, oscillating](QPainter& loopPainter, const QRect& square) {
+                // Shade oscillating loops, then outline the gate.
+                if(oscillating) {
+                    QColor shade = loopColor;
+                    shade.setAlpha(96);
+                    loopPainter.fillRect(square.x(), square.y(), square.width(), square.height(), shade);
+                }
+                loopPainter.setPen(QPen(loopColor, 2));
+                loopPainter.drawRect(square.x() + 1, square.y() + 1, square.width() - 2, square.height() - 2);
+            });
+    }
 }
 
 void MainWindow::repaint() {
-    //Must remove everything already in the layers.
-    componentLayer.fill(Qt::transparent);
+    frameTimer.start();
+
+    // Everything is redrawn, so the squares changed so far are already covered. The static
+    // layer only has to be redrawn for a new or cleared level, or a new square size or screen.
+    QVector<QPoint> dirtyCells;
+    bool levelChanged = !currentLevel->takeDirtyCells(dirtyCells);
+    prepareLayers();
+
+    // Very large boards are drawn in tiles off the GUI thread. Otherwise, any tiles still being
+    // drawn belong to an old board, and the static layer may be only partly drawn.
+    if(currentLevel->getWidth() * currentLevel->getHeight() >= TILED_BOARD_CELLS) {
+        repaintTiled();
+        return;
+    }
+    bool wasTiling = tileRasterizer.isRunning();
+    tileRasterizer.cancel();
+    pendingCells.clear();
+    if(levelChanged || wasTiling || staticLayer.isNull())
+        paintStaticLayer();
 
-    //Pointers to hold values of the different grid objects.
-    Wire* currentWire;
-    Gate* currentGate;
-    Node* currentNode;
-    Obstacle* currentObstacle;
+    //Must remove everything already in the layers.
+    componentLayer = staticLayer;
 
     //checks for components at each box on the board.
-    for(int x = 0; x < currentLevel->WIDTH; x++) {
-        for( int y = 0; y < currentLevel->HEIGHT; y++) {
-            currentWire = currentLevel->getWire(x, y);
-            currentGate = currentLevel->getGate(x, y);
-            currentNode = currentLevel->getNode(x, y);
-            currentObstacle = currentLevel->getObstacle(x, y);
-            if(currentWire)
-                paintWire(x, y, currentWire->getDirection(), currentWire->getSignal());
-            if(currentGate)
-                paintGate(x, y, currentGate->getOperator(), currentGate->getAlignment(), currentGate->getDirection());
-            if(currentNode)
-                paintNode(x, y, currentNode->getSignal(), currentNode->getNodeType());
-            if(currentObstacle)
-                paintObstacle(x, y);
+    for(int x = 0; x < currentLevel->getWidth(); x++) {
+        for( int y = 0; y < currentLevel->getHeight(); y++) {
+            paintCell(x, y);
         }
     }
+    composeFrame();
 }
 
-void MainWindow::paintWire(int x, int y, Wire::Direction direction, bool signal) {
-    QString color = FALSE_COLOR;
+void MainWindow::repaintCells() {
+    QVector<QPoint> dirtyCells;
 
-    // Holds the current wire texture to be drawn.
-    QPixmap wirePixmap;
+    // Squares can't be redrawn over tiles that aren't in yet, so they wait for the last one.
+    if(tileRasterizer.isRunning()) {
+        if(!currentLevel->takeDirtyCells(dirtyCells))
+            repaint();
+        else
+            pendingCells += dirtyCells;
+        return;
+    }
+    frameTimer.start();
+    if(!currentLevel->takeDirtyCells(dirtyCells) || prepareLayers()) {
+        repaint();
+        return;
+    }
+    if(dirtyCells.isEmpty())
+        return;
+    for(const QPoint& cell : dirtyCells) {
+        clearCell(cell.x(), cell.y());
+        paintCell(cell.x(), cell.y());
+    }
+    composeFrame();
+}
 
-    // Change the color to red if the wire tag is A or blue if the wire tag is B.
-    if(signal)
-        color = TRUE_COLOR;
+void MainWindow::repaintTiled() {
+    int boxWidth = qMax(1, ui->gameBoard->width() / currentLevel->getWidth());
+    int boxHeight = qMax(1, ui->gameBoard->height() / currentLevel->getHeight());
+
+    // Only the squares holding something are queued here, as bare sprite ids, and the obstacle
+    // layer is shared as it is. The workers find their own squares' sprites and place them.
+    TileRasterizer::Job job;
+    QVector<QPoint> occupiedSquares = currentLevel->getOccupiedSquares();
+    for(const QPoint& square : occupiedSquares)
+        paintStaticCell(square.x(), square.y());
+    job.staticSprites.swap(queuedSprites);
+    for(const QPoint& square : occupiedSquares)
+        paintCell(square.x(), square.y());
+    job.sprites.swap(queuedSprites);
+    job.obstacles = currentLevel->getObstacleLayer();
+    job.obstacleSprite = obstacleSprite;
+    job.background = backgroundImage;
+    job.atlas = atlasImage;
+    job.sourceRects = spriteRects;
+    job.squareSize = QSize(boxWidth, boxHeight);
+    job.boardSize = ui->gameBoard->size();
+    job.devicePixelRatio = backgroundLayer.devicePixelRatio();
+    job.tileSize = QSize(qMax(1, TILE_SIZE / boxWidth) * boxWidth,
+                         qMax(1, TILE_SIZE / boxHeight) * boxHeight);
+    clearFragments.clear();
+    pendingCells.clear();
+    tileRasterizer.start(job);
+
+    // The bare grid is shown until the tiles come in.
+    staticLayer = backgroundLayer;
+    componentLayer = backgroundLayer;
+    ui->gameBoard->setPixmap(componentLayer);
+}
+
+void MainWindow::showFinishedTiles() {
+    if(!tileRasterizer.isRunning())
+        return;
+    QVector<TileRasterizer::Tile> tiles = tileRasterizer.takeFinishedTiles();
+    if(tiles.isEmpty())
+        return;
+    QPainter staticPainter(&staticLayer);
+    QPainter framePainter(&componentLayer);
+    staticPainter.setCompositionMode(QPainter::CompositionMode_Source);
+    framePainter.setCompositionMode(QPainter::CompositionMode_Source);
+    for(const TileRasterizer::Tile& tile : tiles) {
+        staticPainter.drawImage(tile.area.topLeft(), tile.staticImage);
+        framePainter.drawImage(tile.area.topLeft(), tile.frameImage);
+    }
+    staticPainter.end();
+    framePainter.end();
 
+    // Partly drawn boards are shown as they are. The last tiles go through a normal frame,
+    // which also redraws the squares edited while the tiles were being drawn.
+    if(tileRasterizer.isRunning()) {
+        ui->gameBoard->setPixmap(componentLayer);
+        return;
+    }
+    for(const QPoint& cell : pendingCells) {
+        clearCell(cell.x(), cell.y());
+        paintCell(cell.x(), cell.y());
+    }
+    pendingCells.clear();
+    composeFrame();
+}
+
+bool MainWindow::prepareLayers() {
+    int boardWidth = ui->gameBoard->width();
+    int boardHeight = ui->gameBoard->height();
+    int boxWidth = qMax(1, boardWidth / currentLevel->getWidth());
+    int boxHeight = qMax(1, boardHeight / currentLevel->getHeight());
+    qreal pixelRatio = ui->gameBoard->devicePixelRatioF();
+
+    // Sprites are scaled once per square size and screen, not every time they are drawn.
+    bool resized = spriteAtlas.prepare(QSize(boxWidth, boxHeight), pixelRatio);
+    if(resized || atlasImage.isNull()) {
+        atlasImage = spriteAtlas.getPixmap().toImage();
+        spriteRects.resize(spriteAtlas.getSpriteCount());
+        for(int sprite = 0; sprite < spriteRects.size(); sprite++)
+            spriteRects[sprite] = spriteAtlas.getSourceRect(sprite);
+    }
+    QSize pixelSize(qCeil(boardWidth * pixelRatio), qCeil(boardHeight * pixelRatio));
+    if(!resized && backgroundLayer.size() == pixelSize
+        && backgroundLayer.devicePixelRatio() == pixelRatio)
+        return false;
+
+    // The grid is drawn once per square size and screen, with every square outlined on its own
+    // edges like the old 12x8 image, so lines stay one pixel wide on boards of any size.
+    // Squares are restored from it before being redrawn.
+    backgroundLayer = QPixmap(pixelSize);
+    backgroundLayer.setDevicePixelRatio(pixelRatio);
+    backgroundLayer.fill(Qt::white);
+    QPainter gridPainter(&backgroundLayer);
+    QColor gridColor(GRID_COLOR);
+    int gridWidth = currentLevel->getWidth() * boxWidth;
+    int gridHeight = currentLevel->getHeight() * boxHeight;
+    for(int x = 0; x < currentLevel->getWidth(); x++) {
+        gridPainter.fillRect(x * boxWidth, 0, 1, gridHeight, gridColor);
+        gridPainter.fillRect((x + 1) * boxWidth - 1, 0, 1, gridHeight, gridColor);
+    }
+    for(int y = 0; y < currentLevel->getHeight(); y++) {
+        gridPainter.fillRect(0, y * boxHeight, gridWidth, 1, gridColor);
+        gridPainter.fillRect(0, (y + 1) * boxHeight - 1, gridWidth, 1, gridColor);
+    }
+    gridPainter.end();
+    backgroundImage = backgroundLayer.toImage();
+    staticLayer = QPixmap();
+    return true;
+}
+
+void MainWindow::paintStaticLayer() {
+    for(int x = 0; x < currentLevel->getWidth(); x++) {
+        for(int y = 0; y < currentLevel->getHeight(); y++) {
+            paintStaticCell(x, y);
+        }
+    }
+
+    // Drawn on its own copy of the grid, with the same batching as a frame.
+    staticLayer = backgroundLayer;
+    QPainter staticPainter(&staticLayer);
+    drawQueuedSprites(staticPainter);
+    staticPainter.end();
+}
+
+void MainWindow::clearCell(int x, int y) {
     // Grab the UI measurements for scaling.
-    int boxWidth = ui->gameBoard->width() / currentLevel->WIDTH;
-    int boxHeight = ui->gameBoard->height() / currentLevel->HEIGHT;
+    int boxWidth = qMax(1, ui->gameBoard->width() / currentLevel->getWidth());
+    int boxHeight = qMax(1, ui->gameBoard->height() / currentLevel->getHeight());
     int uiX = x * boxWidth;
     int uiY = y * boxHeight;
 
-    // Set the current wire texture, scaled relative to the.
-    wirePixmap = wirePixmaps.value({direction, color}).scaled(
-        boxWidth, boxHeight,
-        Qt::KeepAspectRatio,
-        Qt::FastTransformation);
+    // Queue the static layer to be copied back over the square, replacing whatever was drawn
+    // there. It is addressed in screen pixels and fragments are placed by their centers.
+    qreal pixelRatio = staticLayer.devicePixelRatio();
+    clearFragments.append(QPainter::PixmapFragment::create(
+        QPointF(uiX + boxWidth / 2.0, uiY + boxHeight / 2.0),
+        QRectF(uiX * pixelRatio, uiY * pixelRatio, boxWidth * pixelRatio, boxHeight * pixelRatio),
+        1 / pixelRatio, 1 / pixelRatio));
+}
+
+void MainWindow::paintStaticCell(int x, int y) {
+    Gate* currentGate = currentLevel->getGate(x, y);
+    bool currentObstacle = currentLevel->getObstacle(x, y);
+    if(currentGate)
+        paintGate(x, y, currentGate->getOperator(), currentGate->getAlignment(), currentGate->getDirection());
+    if(currentObstacle)
+        paintObstacle(x, y);
+}
 
-    // Set up the painter and link to componentLayer.
-    QPainter wirePainter(&componentLayer);
+void MainWindow::paintCell(int x, int y) {
+    Wire* currentWire = currentLevel->getWire(x, y);
+    Gate* currentGate = currentLevel->getGate(x, y);
+    Node* currentNode = currentLevel->getNode(x, y);
+    if(currentWire) {
+        paintWire(x, y, currentWire->getDirection(), currentWire->getSignal().isHigh());
+
+        // Junction branches are drawn as plugs on top of the wire.
+        for (int i = 0; i < currentWire->getBranchCount(); i++)
+            paintWire(x, y, currentWire->getBranchDirection(i),
+                      currentWire->getSignal().isHigh());
+    }
+    // Gate bodies are already on the static layer, but gates feeding back into themselves are
+    // called out on top.
+    if(currentGate && currentLevel->isGateOnLoop(x, y))
+        paintLoop(x, y, currentLevel->isGateOscillating(x, y));
+
+    // Nodes are colored by their signal, so they are drawn with the wires.
+    if(currentNode)
+        paintNode(x, y, currentNode->getSignal().isHigh(), currentNode->getNodeType());
+}
 
-    // Draw to the painter.
-    wirePainter.drawPixmap(uiX, uiY, boxWidth, boxHeight, wirePixmap);
+void MainWindow::paintWire(int x, int y, Wire::Direction direction, bool signal) {
+    QString color = FALSE_COLOR;
 
-    // Draw to the UI.
-    ui->gameBoard->setPixmap(componentLayer);
+    // Change the color to red if the wire tag is A or blue if the wire tag is B.
+    if(signal)
+        color = TRUE_COLOR;
 
+    // Queue the current wire texture for the frame.
+    queueSprite(x, y, wireSprites.value({direction, color}, SpriteAtlas::NO_SPRITE));
 }
 
 
 void MainWindow::loadGatePixmaps() {
+    QHash<QPair<Gate::Operator, QPair<Gate::Ports, Gate::Direction>>, QPixmap> gatePixmaps;
+
     // EAST-facing wires.
     gatePixmaps.insert({Gate::Operator::AND, {Gate::Ports::INOUT, Gate::Direction::EAST}},
                        QPixmap(":/sprites/objects/and_bottom.png"));
@@ -324,87 +533,101 @@ void MainWindow::loadGatePixmaps() {
                        QPixmap(":/sprites/objects/or_top.png").transformed(QTransform().rotate(270)));
     gatePixmaps.insert({Gate::Operator::NOT, {Gate::Ports::INOUT, Gate::Direction::NORTH}},
                        QPixmap(":/sprites/objects/not.png").transformed(QTransform().rotate(270)));
-}
-
-void MainWindow::paintGate(int x, int y, Gate::Operator op, Gate::Ports ports, Gate::Direction dir) {
-    QPixmap gatePixmap;
-    // Grab the UI measurements for scaling.
-    int boxWidth = ui->gameBoard->width() / currentLevel->WIDTH;
-    int boxHeight = ui->gameBoard->height() / currentLevel->HEIGHT;
-    int uiX = x * boxWidth;
-    int uiY = y * boxHeight;
 
-    // Set the current gate texture, scaled relative to the.
-    gatePixmap = gatePixmaps.value({op, {ports, dir}}).scaled(
-        boxWidth, boxHeight,
-        Qt::KeepAspectRatio,
-        Qt::FastTransformation);
-
-    // Set up the painter and link to componentLayer.
-    QPainter wirePainter(&componentLayer);
+    // Operators without sprites of their own reuse the AND or OR ones, named on the output half.
+    const QVector<QPair<Gate::Operator, Gate::Operator>> labeledGates = {
+        {Gate::Operator::XOR, Gate::Operator::OR}, {Gate::Operator::NAND, Gate::Operator::AND},
+        {Gate::Operator::NOR, Gate::Operator::OR}, {Gate::Operator::XNOR, Gate::Operator::OR},
+        {Gate::Operator::DFF, Gate::Operator::AND}, {Gate::Operator::LATCH, Gate::Operator::AND},
+        {Gate::Operator::CLOCK, Gate::Operator::NOT}};
+    for (Gate::Direction dir : {Gate::Direction::NORTH, Gate::Direction::EAST,
+                                Gate::Direction::SOUTH, Gate::Direction::WEST}) {
+        for (const QPair<Gate::Operator, Gate::Operator>& gate : labeledGates) {
+            gatePixmaps.insert({gate.first, {Gate::Ports::IN, dir}},
+                               gatePixmaps.value({gate.second, {Gate::Ports::IN, dir}}));
+            QPixmap outputHalf = gatePixmaps.value({gate.second, {Gate::Ports::INOUT, dir}});
+            QPainter labelPainter(&outputHalf);
+            QFont labelFont = labelPainter.font();
+            labelFont.setBold(true);
+            labelFont.setPixelSize(qMax(1, outputHalf.height() / 4));
+            labelPainter.setFont(labelFont);
+            labelPainter.drawText(outputHalf.rect(), Qt::AlignCenter, GateKernels::getName(gate.first));
+            labelPainter.end();
+            gatePixmaps.insert({gate.first, {Gate::Ports::INOUT, dir}}, outputHalf);
+        }
+    }
 
-    // Draw to the painter.
-    wirePainter.drawPixmap(uiX, uiY, boxWidth, boxHeight, gatePixmap);
+    for(auto it = gatePixmaps.cbegin(); it != gatePixmaps.cend(); ++it)
+        gateSprites.insert(it.key(), spriteAtlas.addSprite(it.value()));
+}
 
-    // Draw to the UI.
-    ui->gameBoard->setPixmap(componentLayer);
+void MainWindow::paintGate(int x, int y, Gate::Operator op, Gate::Ports ports, Gate::Direction dir) {
+    // Queue the current gate texture for the frame.
+    queueSprite(x, y, gateSprites.value({op, {ports, dir}}, SpriteAtlas::NO_SPRITE));
 }
 
 void MainWindow::paintNode(int x, int y, bool signal, Node::Type nodeType) {
     // Set default color. This color is retained if the tag is not A or B.
     QString color = FALSE_COLOR;
 
-    // Holds the current wire texture to be drawn.
-    QPixmap nodePixmap;
-
     // Change the color to red if the wire tag is A or blue if the wire tag is B.
     if(signal)
         color = TRUE_COLOR;
 
-    // Grab the UI measurements for scaling.
-    int boxWidth = ui->gameBoard->width() / currentLevel->WIDTH;
-    int boxHeight = ui->gameBoard->height() / currentLevel->HEIGHT;
-    int uiX = x * boxWidth;
-    int uiY = y * boxHeight;
-
-    // Set the current wire texture, scaled relative to the.
-    nodePixmap = nodePixmaps.value({signal, nodeType}).scaled(
-        boxWidth, boxHeight,
-        Qt::KeepAspectRatio,
-        Qt::FastTransformation);
+    // Queue the current node texture for the frame.
+    queueSprite(x, y, nodeSprites.value({signal, nodeType}, SpriteAtlas::NO_SPRITE));
+}
 
-    // Set up the painter and link to componentLayer.
-    QPainter nodePainter(&componentLayer);
+void MainWindow::paintObstacle(int x, int y) {
+    queueSprite(x, y, obstacleSprite);
+}
 
-    // Draw to the painter.
-    nodePainter.drawPixmap(uiX, uiY, boxWidth, boxHeight, nodePixmap);
+void MainWindow::paintLoop(int x, int y, bool oscillating) {
+    // The outline is shaded if the loop is oscillating.
+    queueSprite(x, y, loopSprites[oscillating]);
+}
 
-    // Draw to the UI.
-    ui->gameBoard->setPixmap(componentLayer);
+void MainWindow::queueSprite(int x, int y, int sprite) {
+    if(sprite == SpriteAtlas::NO_SPRITE)
+        return;
 
+    // Sprites are placed on the board when the queue is drawn.
+    queuedSprites.append({QPoint(x, y), sprite});
 }
 
-void MainWindow::paintObstacle(int x, int y) {
+void MainWindow::drawQueuedSprites(QPainter& painter) {
     // Grab the UI measurements for scaling.
-    int boxWidth = ui->gameBoard->width() / currentLevel->WIDTH;
-    int boxHeight = ui->gameBoard->height() / currentLevel->HEIGHT;
-    int uiX = x * boxWidth;
-    int uiY = y * boxHeight;
-
-    // Holds the current wire texture to be drawn.
-    QPixmap obstaclePixmap = QPixmap(":/sprites/objects/obsticle.png").scaled(
-        boxWidth, boxHeight,
-        Qt::KeepAspectRatio,
-        Qt::FastTransformation);
-
-    // Set up the painter and link to componentLayer.
-    QPainter obstaclePainter(&componentLayer);
+    int boxWidth = qMax(1, ui->gameBoard->width() / currentLevel->getWidth());
+    int boxHeight = qMax(1, ui->gameBoard->height() / currentLevel->getHeight());
+
+    QVector<QPainter::PixmapFragment> spriteFragments;
+    spriteFragments.reserve(queuedSprites.size());
+    for(const TileRasterizer::Sprite& sprite : queuedSprites) {
+        QPoint target(sprite.square.x() * boxWidth, sprite.square.y() * boxHeight);
+        spriteFragments.append(spriteAtlas.getFragment(target, sprite.sprite));
+    }
+    painter.drawPixmapFragments(spriteFragments.constData(), spriteFragments.size(),
+                                spriteAtlas.getPixmap());
+    queuedSprites.clear();
+}
 
-    // Draw to the painter.
-    obstaclePainter.drawPixmap(uiX, uiY, boxWidth, boxHeight, obstaclePixmap);
+void MainWindow::composeFrame() {
+    // One painter draws the whole frame: the static layer under the changed squares first,
+    // then every sprite on top, in the order they were queued, from the atlas in a single batch.
+    QPainter framePainter(&componentLayer);
+    if(!clearFragments.isEmpty()) {
+        framePainter.setCompositionMode(QPainter::CompositionMode_Source);
+        framePainter.drawPixmapFragments(clearFragments.constData(), clearFragments.size(),
+                                         staticLayer);
+        framePainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+    }
+    drawQueuedSprites(framePainter);
+    framePainter.end();
+    clearFragments.clear();
 
-    // Draw to the UI.
+    // The board is handed to the UI once per frame.
     ui->gameBoard->setPixmap(componentLayer);
+    lastFrameNs = frameTimer.nsecsElapsed();
 }
 
 void MainWindow::changeLevel() {
@@ -425,7 +648,11 @@ void MainWindow::changeLevel() {
     });
     currentLevel->levelSetup(levelNum);
     repaint();
-    currentTag = "";
+    currentTag = Tag();
+}
+
+qint64 MainWindow::getLastFrameNs() const {
+    return lastFrameNs;
 }
 
 void MainWindow::unlockNextLevel() {
@@ -463,9 +690,11 @@ void MainWindow::mouseMoveEvent(QMouseEvent *event) {
         mouseX = mouseX - gameBoard->pos().x();
         mouseY = mouseY - gameBoard->pos().y();
 
-        // Project into Canvas Coords
-        gameBoardX = (int)(mouseX / (gameBoard->width() / currentLevel->WIDTH));
-        gameBoardY = (int)(mouseY / (gameBoard->height() / currentLevel->HEIGHT));
+        // Project into Canvas Coords, with the same square size the board is drawn with.
+        int boxWidth = qMax(1, gameBoard->width() / currentLevel->getWidth());
+        int boxHeight = qMax(1, gameBoard->height() / currentLevel->getHeight());
+        gameBoardX = (int)(mouseX / boxWidth);
+        gameBoardY = (int)(mouseY / boxHeight);
 
         //check if the mouse has already been moved into this space before
         if (gameBoardX != oldGameBoardX || gameBoardY != oldGameBoardY)
@@ -476,7 +705,7 @@ void MainWindow::mouseMoveEvent(QMouseEvent *event) {
     if (newPosition) {
         currentLevel->drawWire(gameBoardX, gameBoardY, currentTag);
         newPosition = false;
-        repaint();
+        repaintCells();
     }
 }
 
@@ -487,10 +716,14 @@ void MainWindow::mousePressEvent(QMouseEvent *event) {
     int oldGameBoardY = gameBoardY;
     QLabel* gameBoard = ui->gameBoard;
     if (isInGameBoard(mouseX, mouseY)) {
+        // Everything drawn until the mouse is released is a single undo step.
+        currentLevel->beginEdit();
         mouseX = mouseX - gameBoard->pos().x();
         mouseY = mouseY - gameBoard->pos().y();
-        gameBoardX = (int)(mouseX / (gameBoard->width() / currentLevel->WIDTH));
-        gameBoardY = (int)(mouseY / (gameBoard->height() / currentLevel->HEIGHT));
+        int boxWidth = qMax(1, gameBoard->width() / currentLevel->getWidth());
+        int boxHeight = qMax(1, gameBoard->height() / currentLevel->getHeight());
+        gameBoardX = (int)(mouseX / boxWidth);
+        gameBoardY = (int)(mouseY / boxHeight);
 
         //tool->useTool(sprite, canvasX, canvasY);
         if (gameBoardX != oldGameBoardX || gameBoardY != oldGameBoardY)
@@ -510,7 +743,7 @@ void MainWindow::mousePressEvent(QMouseEvent *event) {
         else
             currentLevel->drawWire(gameBoardX, gameBoardY, currentTag);
         newPosition = false;
-        repaint();
+        repaintCells();
     }
 }
 
@@ -521,6 +754,8 @@ bool MainWindow::isInGameBoard(int x, int y){
 }
 
 void MainWindow::mouseReleaseEvent(QMouseEvent *event){
+    currentLevel->endEdit();
+
     double mouseX = event->position().x();
     double mouseY = event->position().y();
 
@@ -529,6 +764,20 @@ void MainWindow::mouseReleaseEvent(QMouseEvent *event){
         return;
 }
 
+void MainWindow::keyPressEvent(QKeyEvent *event) {
+    bool changed = false;
+    if (event->matches(QKeySequence::Undo))
+        changed = currentLevel->undo();
+    else if (event->matches(QKeySequence::Redo))
+        changed = currentLevel->redo();
+    else {
+        QMainWindow::keyPressEvent(event);
+        return;
+    }
+    if (changed)
+        repaintCells();
+}
+
 void MainWindow::startGame(){
     ui->startingScreen->hide();
     ui->gameBoard->show();
@@ -610,9 +859,11 @@ void MainWindow::levelFiveButtonClicked() {
 }
 
 void MainWindow::clearLevelButtonClicked() {
+    currentLevel->beginEdit();
     currentLevel->clearWires();
     currentLevel->clearGates();
     currentLevel->clearNodes();
+    currentLevel->endEdit();
     currentLevel->removeConfetti();
     setLessonText();
     if(!isLessonShowing) {
@@ -13,13 +13,17 @@
 
 #include <QMainWindow>
 #include <QMouseEvent>
+#include <QKeyEvent>
 #include <Box2D/Box2D.h>
 #include <QGraphicsScene>
 #include <QPushButton>
 #include <QLabel>
 #include <QPropertyAnimation>
+#include <QElapsedTimer>
 
 #include "level.h"
+#include "spriteatlas.h"
+#include "tilerasterizer.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -53,6 +57,13 @@ protected:
      */
     void mouseReleaseEvent(QMouseEvent *event);
 
+    /**
+     * @brief keyPressEvent - Undoes or redoes the last board edit on the
+     * standard undo and redo shortcuts.
+     * @param event - Key pressed.
+     */
+    void keyPressEvent(QKeyEvent *event);
+
 public:
     /**
      * @brief MainWindow - Creates a main window object.
@@ -70,6 +81,13 @@ public:
      */
     void changeLevel();
 
+    /**
+     * @brief getLastFrameNs - Getter for how long the last board repaint took, from reading the
+     * level to handing the finished frame to the UI.
+     * @return The wall time in nanoseconds.
+     */
+    qint64 getLastFrameNs() const;
+
 private slots:
     /**
      * @brief updateWorld - Updates the world when events trigger.
@@ -155,10 +173,56 @@ private:
     QPixmap componentLayer;
 
     /**
-     * @brief backgroundLayer - The background layer where the grid is drawn.
+     * @brief backgroundLayer - The background layer where the grid is drawn, at the board's size.
      */
     QPixmap backgroundLayer;
 
+    /**
+     * @brief backgroundImage - A copy of backgroundLayer for the tile workers, which can't read
+     * pixmaps. Only made again when the grid is redrawn.
+     */
+    QImage backgroundImage;
+
+    /**
+     * @brief atlasImage - A copy of the sprite atlas for the tile workers. Only made again when
+     * the atlas is rebuilt.
+     */
+    QImage atlasImage;
+
+    /**
+     * @brief spriteRects - Where each sprite sits in atlasImage, by id.
+     */
+    QVector<QRect> spriteRects;
+
+    /**
+     * @brief staticLayer - The grid with the obstacles and gate bodies drawn on. These never move
+     * during a level, so the layer is only redrawn when a level is set up or cleared, and each
+     * frame starts from it.
+     */
+    QPixmap staticLayer;
+
+    /**
+     * @brief clearFragments - The grid squares to copy back over componentLayer in the frame
+     * being composed.
+     */
+    QVector<QPainter::PixmapFragment> clearFragments;
+
+    /**
+     * @brief queuedSprites - The atlas sprites to draw in the frame being composed, bottom
+     * first, by square.
+     */
+    QVector<TileRasterizer::Sprite> queuedSprites;
+
+    /**
+     * @brief frameTimer - Times the board repaint in progress.
+     */
+    QElapsedTimer frameTimer;
+
+    /**
+     * @brief lastFrameNs - The wall time of the last board repaint.
+     */
+    qint64 lastFrameNs;
+
     /**
      * @brief scrollAnimation - The scroll animation.
      */
@@ -180,22 +244,71 @@ private:
     const QString TRUE_COLOR = "blue";
 
     /**
-     * @brief wirePixmaps - Holds the wire pixmaps with direction-color pairs as keys
-     * and image Pixmaps as values.
+    * @brief LOOP_COLOR - The color used to outline gates on a feedback loop.
+    */
+    const QString LOOP_COLOR = "orange";
+
+    /**
+    * @brief GRID_COLOR - The color of the lines between board squares.
+    */
+    const QString GRID_COLOR = "#9b9eb0";
+
+    /**
+     * @brief spriteAtlas - Every board texture, pre-scaled to the size of a square.
+     */
+    SpriteAtlas spriteAtlas;
+
+    /**
+     * @brief tileRasterizer - Draws very large boards in tiles on worker threads.
+     */
+    TileRasterizer tileRasterizer;
+
+    /**
+     * @brief pendingCells - Squares edited while tileRasterizer was still drawing the board,
+     * redrawn once its tiles are all in.
+     */
+    QVector<QPoint> pendingCells;
+
+    /**
+     * @brief TILED_BOARD_CELLS - The number of squares from which a board is drawn in tiles
+     * instead of on the GUI thread.
+     */
+    const int TILED_BOARD_CELLS = 4096;
+
+    /**
+     * @brief TILE_SIZE - The rough width and height of a tile in logical pixels, rounded down
+     * to whole squares.
      */
-    QHash<QPair<Wire::Direction, QString>, QPixmap> wirePixmaps;
+    const int TILE_SIZE = 128;
 
     /**
-     * @brief nodePixmaps - Holds the node pixmaps with color as a key
-     * and image Pixmaps as values.
+     * @brief wireSprites - Holds the wire sprites with direction-color pairs as keys
+     * and atlas ids as values.
      */
-    QHash<QPair<bool, Node::Type>, QPixmap> nodePixmaps;
+    QHash<QPair<Wire::Direction, QString>, int> wireSprites;
 
     /**
-     * @brief wirePixmaps - Holds the Gate pixmaps with direction-color pairs as keys
-     * and image Pixmaps as values.
+     * @brief nodeSprites - Holds the node sprites with signal-type pairs as keys
+     * and atlas ids as values.
      */
-    QHash<QPair<Gate::Operator, QPair<Gate::Ports, Gate::Direction>>, QPixmap> gatePixmaps;
+    QHash<QPair<bool, Node::Type>, int> nodeSprites;
+
+    /**
+     * @brief gateSprites - Holds the Gate sprites with operator, ports and direction as keys
+     * and atlas ids as values.
+     */
+    QHash<QPair<Gate::Operator, QPair<Gate::Ports, Gate::Direction>>, int> gateSprites;
+
+    /**
+     * @brief obstacleSprite - The atlas id of the obstacle.
+     */
+    int obstacleSprite;
+
+    /**
+     * @brief loopSprites - The atlas ids of the loop outline, plain and then shaded for
+     * oscillating loops.
+     */
+    int loopSprites[2];
 
     /**
      * @brief completedLevels - holds the numbers of all levels completed thus far.
@@ -219,12 +332,93 @@ private:
      */
     void loadGatePixmaps();
 
+    /**
+     * @brief loadObjectPixmaps - Helper method to load the obstacle and the loop outlines.
+     */
+    void loadObjectPixmaps();
+
+    /**
+     * @brief prepareLayers - Scales the sprites and draws the grid background for the current
+     * square size and screen, if they aren't already.
+     * @return True if anything was redrawn, so the whole board needs redrawing, static layer
+     * included.
+     */
+    bool prepareLayers();
+
     /**
      * @brief repaint - Redraws the whole board based on the current level's data.
      *  Reflects backend updates in the frontend.
      */
     void repaint();
 
+    /**
+     * @brief repaintCells - Redraws only the squares the level changed since the last repaint,
+     * or the whole board if the level was set up or cleared in the meantime.
+     */
+    void repaintCells();
+
+    /**
+     * @brief repaintTiled - Starts redrawing the whole board in tiles on worker threads and shows
+     * the bare grid until they come in. Doesn't wait for any tile.
+     */
+    void repaintTiled();
+
+    /**
+     * @brief showFinishedTiles - Copies the tiles drawn since the last call onto the board and
+     * shows it. Once the last tile is in, squares edited in the meantime are redrawn.
+     */
+    void showFinishedTiles();
+
+    /**
+     * @brief paintStaticLayer - Redraws the static layer from the grid and the current level.
+     */
+    void paintStaticLayer();
+
+    /**
+     * @brief paintStaticCell - Queues the gate body or obstacle at the given x, y square for the
+     * static layer.
+     * @param x - The horizontal grid square index to draw.
+     * @param y - The vertical grid square index to draw.
+     */
+    void paintStaticCell(int x, int y);
+
+    /**
+     * @brief composeFrame - Draws everything queued since the last frame onto componentLayer
+     * with a single painter, then shows the board.
+     */
+    void composeFrame();
+
+    /**
+     * @brief queueSprite - Queues an atlas sprite to be drawn on the given x, y square.
+     * @param x - The horizontal grid square index to draw on.
+     * @param y - The vertical grid square index to draw on.
+     * @param sprite - The sprite's atlas id. SpriteAtlas::NO_SPRITE queues nothing.
+     */
+    void queueSprite(int x, int y, int sprite);
+
+    /**
+     * @brief drawQueuedSprites - Draws every queued sprite from the atlas in a single batch, then
+     * empties the queue.
+     * @param painter - The painter on the layer to draw on.
+     */
+    void drawQueuedSprites(QPainter& painter);
+
+    /**
+     * @brief clearCell - Queues the background of the given x, y square to be restored in the
+     * frame being composed.
+     * @param x - The horizontal grid square index to clear.
+     * @param y - The vertical grid square index to clear.
+     */
+    void clearCell(int x, int y);
+
+    /**
+     * @brief paintCell - Queues the wire, node or loop outline at the given x, y square for the
+     * frame being composed. Everything else is on the static layer.
+     * @param x - The horizontal grid square index to draw.
+     * @param y - The vertical grid square index to draw.
+     */
+    void paintCell(int x, int y);
+
     /**
      * @brief paintWire - Paints a Wire with the appropriate attributes at the
      * given x, y position.
@@ -262,6 +456,15 @@ private:
      */
     void paintObstacle(int x, int y);
 
+    /**
+     * @brief paintLoop - Outlines a gate on a feedback loop at the given x, y position, and
+     * shades it if the loop is oscillating.
+     * @param x - The horizontal grid square index of the gate.
+     * @param y - The vertical grid square index of the gate.
+     * @param oscillating - Whether the loop never settled.
+     */
+    void paintLoop(int x, int y, bool oscillating);
+
     /**
      * @brief unlockNextLevel - Allows the user to select the next level.
      * Unlocks the next level and ensures the rest are still locked.
@@ -271,7 +474,7 @@ private:
     /**
      * @brief currentTag - The tag associated with the current wire being drawn.
      */
-    QString currentTag;
+    Tag currentTag;
 
     /**
      * @brief currentLevel - The level currently being played on.
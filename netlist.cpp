@@ -0,0 +1,281 @@
+#include "netlist.h"
+#include "gatekernels.h"
+#include "level.h"
+#include <QHash>
+#include <QVarLengthArray>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <functional>
+
+Netlist::Netlist() {
+}
+
+bool Netlist::compile(Level* level) {
+    auto reset = [this]() {
+        inputTags.clear();
+        operations.clear();
+        batches.clear();
+        outputSignals.clear();
+        expectedSignals.clear();
+        truthTables.clear();
+    };
+    reset();
+
+    QVector<Node*> roots;
+    QVector<Node*> ends;
+    for (Node* node : level->getNodes()) {
+        // Lanes already hold input combinations, so bus levels can't be compiled.
+        if (node->getSignal().getWidth() != 1)
+            return false;
+        if (node->getNodeType() == Node::Type::ROOT)
+            roots.append(node);
+        else
+            ends.append(node);
+    }
+    if (roots.size() > MAX_INPUTS)
+        return false;
+    std::stable_sort(roots.begin(), roots.end(), [](Node* first, Node* second) {
+        return first->getTag().toString() < second->getTag().toString();
+    });
+
+    // Map each driver's backing wire to what it drives.
+    QHash<Wire*, int> rootSignals;
+    for (Node* root : roots) {
+        inputTags.append(root->getTag());
+        rootSignals.insert(root->getWire(), inputTags.size());
+    }
+    QHash<Wire*, Gate*> gateOutputs;
+    for (Gate* gate : level->getGates()) {
+        if (GateKernels::isStateful(gate->getOperator())
+            || GateKernels::getInputCount(gate->getOperator()) > 2) {
+            reset();
+            return false;
+        }
+        if (gate->getOutputNode())
+            gateOutputs.insert(gate->getOutputNode()->getWire(), gate);
+    }
+
+    // Gates are compiled depth first from their outputs so each lands after its inputs.
+    QHash<Gate*, int> gateSignals;
+    QHash<Gate*, bool> visiting;
+    std::function<int(Gate*)> gateSignal;
+    std::function<int(Wire*)> sinkSignal = [&](Wire* sinkWire) {
+        Wire* currentWire = sinkWire->getHeadConnection();
+        while (currentWire && currentWire->getHeadConnection() != currentWire)
+            currentWire = currentWire->getHeadConnection();
+        if (currentWire == nullptr)
+            return CONSTANT_FALSE;
+        if (rootSignals.contains(currentWire))
+            return rootSignals.value(currentWire);
+        if (Gate* gate = gateOutputs.value(currentWire))
+            return gateSignal(gate);
+        return CONSTANT_FALSE;
+    };
+    gateSignal = [&](Gate* gate) {
+        if (gateSignals.contains(gate))
+            return gateSignals.value(gate);
+        if (visiting.value(gate))
+            return -1;
+        visiting.insert(gate, true);
+
+        // A gate missing an input is dead, just like on the board.
+        int signal = CONSTANT_FALSE;
+        if (gate->isFullyConnected()) {
+            int first = sinkSignal(gate->getInputNode()->getWire());
+            int second = gate->getOtherHalf()
+                             ? sinkSignal(gate->getOtherHalf()->getInputNode()->getWire()) : first;
+            if (first < 0 || second < 0)
+                return -1;
+            operations.append({gate->getOperator(), first, second});
+            signal = getSignalCount() - 1;
+        }
+        visiting.insert(gate, false);
+        gateSignals.insert(gate, signal);
+        return signal;
+    };
+
+    for (Node* end : ends) {
+        int signal = sinkSignal(end->getWire());
+        if (signal < 0) {
+            reset();
+            return false;
+        }
+        outputSignals.append(signal);
+        expectedSignals.append(end->getSignal().getBit(0));
+    }
+    schedule();
+    return true;
+}
+
+int Netlist::getInputCount() const {
+    return inputTags.size();
+}
+
+int Netlist::getOutputCount() const {
+    return outputSignals.size();
+}
+
+int Netlist::getGateCount() const {
+    return operations.size();
+}
+
+Tag Netlist::getInputTag(int input) const {
+    return inputTags[input];
+}
+
+bool Netlist::isOutputConnected(int output) const {
+    return outputSignals[output] != CONSTANT_FALSE;
+}
+
+bool Netlist::getExpectedSignal(int output) const {
+    return expectedSignals[output];
+}
+
+int Netlist::getSignalCount() const {
+    return 1 + inputTags.size() + operations.size();
+}
+
+quint64 Netlist::evaluate(quint64 inputs) const {
+    QVector<quint64> values(getSignalCount(), 0);
+    for (int i = 0; i < inputTags.size(); i++)
+        values[1 + i] = ((inputs >> i) & 1) ? ~quint64(0) : 0;
+    run(values.data(), 1);
+
+    quint64 outputs = 0;
+    for (int i = 0; i < outputSignals.size(); i++)
+        outputs |= (values[outputSignals[i]] & 1) << i;
+    return outputs;
+}
+
+void Netlist::computeTruthTables() {
+    quint64 combinations = quint64(1) << inputTags.size();
+    quint64 blocks = (combinations + LANES - 1) / LANES;
+    quint64 lastMask = combinations % LANES ? (quint64(1) << combinations) - 1 : ~quint64(0);
+
+    truthTables.fill(QVector<quint64>(blocks, 0), outputSignals.size());
+    int signalCount = getSignalCount();
+    QVector<quint64> values(signalCount * WIDE_BLOCKS, 0);
+
+    quint64 block = 0;
+    for (; block + WIDE_BLOCKS <= blocks; block += WIDE_BLOCKS) {
+        for (int i = 0; i < inputTags.size(); i++) {
+            for (int lane = 0; lane < WIDE_BLOCKS; lane++)
+                values[(1 + i) * WIDE_BLOCKS + lane] = inputLanes(i, block + lane);
+        }
+        run(values.data(), WIDE_BLOCKS);
+        for (int i = 0; i < outputSignals.size(); i++) {
+            for (int lane = 0; lane < WIDE_BLOCKS; lane++)
+                truthTables[i][block + lane] = values[outputSignals[i] * WIDE_BLOCKS + lane];
+        }
+    }
+    for (; block < blocks; block++) {
+        for (int i = 0; i < inputTags.size(); i++)
+            values[1 + i] = inputLanes(i, block);
+        run(values.data(), 1);
+        for (int i = 0; i < outputSignals.size(); i++)
+            truthTables[i][block] = values[outputSignals[i]];
+    }
+
+    for (QVector<quint64>& table : truthTables)
+        table[blocks - 1] &= lastMask;
+}
+
+const QVector<quint64>& Netlist::getTruthTable(int output) const {
+    return truthTables[output];
+}
+
+qint64 Netlist::firstDifference(const QVector<quint64>& first, const QVector<quint64>& second) {
+    for (int i = 0; i < first.size(); i++) {
+        quint64 difference = first[i] ^ second[i];
+        if (difference)
+            return qint64(i) * LANES + qCountTrailingZeroBits(difference);
+    }
+    return -1;
+}
+
+void Netlist::schedule() {
+    // A gate's depth is one more than that of its deepest input.
+    int firstGate = 1 + inputTags.size();
+    QVector<int> depths(getSignalCount(), 0);
+    for (int i = 0; i < operations.size(); i++)
+        depths[firstGate + i] = 1 + qMax(depths[operations[i].first], depths[operations[i].second]);
+
+    QVector<int> order(operations.size());
+    for (int i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](int first, int second) {
+        int firstDepth = depths[firstGate + first];
+        int secondDepth = depths[firstGate + second];
+        if (firstDepth != secondDepth)
+            return firstDepth < secondDepth;
+        return operations[first].op < operations[second].op;
+    });
+
+    // Signals before the gates keep their index.
+    QVector<int> renumbered(getSignalCount());
+    for (int signal = 0; signal < firstGate; signal++)
+        renumbered[signal] = signal;
+    for (int i = 0; i < order.size(); i++)
+        renumbered[firstGate + order[i]] = firstGate + i;
+
+    QVector<Operation> sorted;
+    sorted.reserve(operations.size());
+    for (int index : order) {
+        Operation operation = operations[index];
+        operation.first = renumbered[operation.first];
+        operation.second = renumbered[operation.second];
+        sorted.append(operation);
+    }
+    operations = sorted;
+    for (int& signal : outputSignals)
+        signal = renumbered[signal];
+
+    batches.clear();
+    for (int i = 0; i < order.size(); i++) {
+        int depth = depths[firstGate + order[i]];
+        if (!batches.isEmpty() && batches.last().op == operations[i].op
+            && depths[firstGate + order[i - 1]] == depth)
+            batches.last().count++;
+        else
+            batches.append({operations[i].op, i, 1});
+    }
+}
+
+void Netlist::run(quint64* values, int blocks) const {
+    for (int lane = 0; lane < blocks; lane++)
+        values[CONSTANT_FALSE * blocks + lane] = 0;
+    int firstGate = 1 + inputTags.size();
+    QVarLengthArray<quint64, 1024> first;
+    QVarLengthArray<quint64, 1024> second;
+    for (const Batch& batch : batches) {
+        int words = batch.count * blocks;
+        first.resize(words);
+        second.resize(words);
+        for (int i = 0; i < batch.count; i++) {
+            const Operation& operation = operations[batch.start + i];
+            for (int lane = 0; lane < blocks; lane++) {
+                first[i * blocks + lane] = values[operation.first * blocks + lane];
+                second[i * blocks + lane] = values[operation.second * blocks + lane];
+            }
+        }
+
+        // Results of a batch are consecutive signals, so they are written in place. compile
+        // only keeps operators of at most two inputs, so no select is needed.
+        quint64* results = values + (firstGate + batch.start) * blocks;
+        bool evaluated = GateKernels::evaluateBatch(batch.op, first.data(), second.data(), nullptr,
+                                                    results, words);
+        Q_ASSERT(evaluated);
+        Q_UNUSED(evaluated);
+    }
+}
+
+quint64 Netlist::inputLanes(int input, quint64 block) {
+    // Within a block, the low six input bits count through the lanes.
+    static const quint64 lanePatterns[6] = {
+        0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+        0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull
+    };
+    if (input < 6)
+        return lanePatterns[input];
+    return ((block >> (input - 6)) & 1) ? ~quint64(0) : 0;
+}
@@ -0,0 +1,218 @@
+/**
+ * This class is a flat, compiled copy of the logic wired up on a level:
+ * ROOT nodes as inputs, gates as operations in dependency order, and
+ * END nodes as outputs. It evaluates 64 input combinations at a time
+ * with bitwise operations, so whole truth tables can be built and
+ * compared without simulating the board once per combination. Gates of
+ * the same depth and operator are grouped, and each group runs as one
+ * batch through the kernels of GateKernels.
+ *
+ * @authors Max Donaldson, Jason Khong,
+ * Ariadne Petroulakis, Evan Tucker, and Ian Weller
+ *
+ * @version 22 April 2025
+ */
+
+#ifndef NETLIST_H
+#define NETLIST_H
+
+#include <QVector>
+#include "gate.h"
+#include "tag.h"
+
+class Level;
+
+class Netlist {
+
+public:
+    /**
+     * @brief MAX_INPUTS - The most ROOT nodes a netlist can compile. Truth tables hold 2^inputs
+     * bits per output.
+     */
+    static const int MAX_INPUTS = 24;
+
+    /**
+     * @brief LANES - The number of input combinations evaluated together.
+     */
+    static const int LANES = 64;
+
+    /**
+     * @brief Netlist - Creates an empty netlist with no inputs or outputs.
+     */
+    Netlist();
+
+    /**
+     * @brief compile - Rebuilds the netlist from the current wiring of a level. Inputs are the
+     * ROOT nodes in tag order, outputs the END nodes in placement order. Gates that are not
+     * fully connected output false, like on the board.
+     * @param level - The level to compile.
+     * @return False if the level has more than MAX_INPUTS roots, a bus node wider than one lane,
+     * a sequential gate or one with a select input, or its gates form a loop. The netlist is left empty in that case.
+     * Sequential levels are run by the Simulator instead.
+     */
+    bool compile(Level* level);
+
+    /**
+     * @brief getInputCount - Getter for the number of inputs.
+     * @return The number of ROOT nodes compiled.
+     */
+    int getInputCount() const;
+
+    /**
+     * @brief getOutputCount - Getter for the number of outputs.
+     * @return The number of END nodes compiled.
+     */
+    int getOutputCount() const;
+
+    /**
+     * @brief getGateCount - Getter for the number of compiled gate operations.
+     * @return The number of gates, counting two-square gates once.
+     */
+    int getGateCount() const;
+
+    /**
+     * @brief getInputTag - Getter for the tag of an input.
+     * @param input - The input index. Bit input of a combination holds its value.
+     * @return The tag of the ROOT node.
+     */
+    Tag getInputTag(int input) const;
+
+    /**
+     * @brief isOutputConnected - Checks whether an END node has a chain wired into it.
+     * @param output - The output index.
+     * @return True if the output is driven. Undriven outputs always read false.
+     */
+    bool isOutputConnected(int output) const;
+
+    /**
+     * @brief getExpectedSignal - Getter for the signal an END node expects.
+     * @param output - The output index.
+     * @return The END node's signal.
+     */
+    bool getExpectedSignal(int output) const;
+
+    /**
+     * @brief evaluate - Evaluates a single input combination.
+     * @param inputs - The combination, one bit per input.
+     * @return One bit per output.
+     */
+    quint64 evaluate(quint64 inputs) const;
+
+    /**
+     * @brief computeTruthTables - Evaluates every input combination and stores one truth table
+     * per output.
+     */
+    void computeTruthTables();
+
+    /**
+     * @brief getTruthTable - Getter for the truth table of an output, as computed by the last
+     * computeTruthTables call.
+     * @param output - The output index.
+     * @return Bit i of the table is the output for input combination i. The last word is
+     * padded with zeros.
+     */
+    const QVector<quint64>& getTruthTable(int output) const;
+
+    /**
+     * @brief firstDifference - Finds the first input combination two truth tables disagree on.
+     * @param first - One truth table.
+     * @param second - The other truth table, of the same size.
+     * @return The combination, or -1 if the tables match.
+     */
+    static qint64 firstDifference(const QVector<quint64>& first, const QVector<quint64>& second);
+
+private:
+    /**
+     * @brief The Operation struct - One gate: the operator and the signals feeding it. The
+     * result goes into the signal after all inputs and earlier operations.
+     */
+    struct Operation {
+        Gate::Operator op;
+        int first;
+        int second;
+    };
+
+    /**
+     * @brief The Batch struct - A run of consecutive operations with the same operator, none
+     * of which reads another's result.
+     */
+    struct Batch {
+        Gate::Operator op;
+        int start;
+        int count;
+    };
+
+    /**
+     * @brief CONSTANT_FALSE - The signal index that always reads false.
+     */
+    static const int CONSTANT_FALSE = 0;
+
+    /**
+     * @brief inputTags - The tag of each input.
+     */
+    QVector<Tag> inputTags;
+
+    /**
+     * @brief operations - The gates, each after every gate it depends on. Sorted by depth,
+     * then operator.
+     */
+    QVector<Operation> operations;
+
+    /**
+     * @brief batches - The operations split into runs that evaluate together, in order.
+     */
+    QVector<Batch> batches;
+
+    /**
+     * @brief outputSignals - The signal index driving each output.
+     */
+    QVector<int> outputSignals;
+
+    /**
+     * @brief expectedSignals - The signal each END node expects.
+     */
+    QVector<bool> expectedSignals;
+
+    /**
+     * @brief truthTables - One truth table per output.
+     */
+    QVector<QVector<quint64>> truthTables;
+
+    /**
+     * @brief WIDE_BLOCKS - The number of 64-lane blocks runWide evaluates together.
+     */
+    static const int WIDE_BLOCKS = 4;
+
+    /**
+     * @brief getSignalCount - Getter for the number of signals: the constant, the inputs and
+     * one per operation.
+     * @return The signal count.
+     */
+    int getSignalCount() const;
+
+    /**
+     * @brief schedule - Sorts the compiled operations by depth, then operator, renumbers the
+     * signals to match, and splits the operations into batches.
+     */
+    void schedule();
+
+    /**
+     * @brief run - Evaluates every batch over some words of lanes per signal. Each batch
+     * gathers its inputs into one contiguous array per input, then runs its operator's batched
+     * kernel over them, four words per AVX2 instruction where the CPU supports it.
+     * @param values - blocks consecutive words per signal with the inputs filled in. Receives
+     * the rest.
+     * @param blocks - The words per signal, 1 or WIDE_BLOCKS.
+     */
+    void run(quint64* values, int blocks) const;
+
+    /**
+     * @brief inputLanes - Builds the lanes of one input for a block of 64 combinations.
+     * @param input - The input index.
+     * @param block - The block index.
+     * @return The input's value in each lane.
+     */
+    static quint64 inputLanes(int input, quint64 block);
+};
+
+#endif // NETLIST_H
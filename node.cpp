@@ -1,12 +1,12 @@
 #include "node.h"
 
-Node::Node(QObject *parent, int x, int y, Node::Type type, bool signal, QString tag)
+Node::Node(WirePool* wirePool, QObject *parent, int x, int y, Node::Type type, Bus signal, Tag tag)
     : QObject{parent}
 {
     nodeType = type;
-    this->tag = tag;
     this->direction = Node::Direction::NONE;
-    backingWire = new Wire();
+    backingWire = wirePool->get(wirePool->allocate());
+    backingWire->setOwner(Wire::Owner::NODE);
     backingWire->setTag(tag);
     backingWire->setSignal(signal);
     backingWire->setPosition(x, y);
@@ -20,23 +20,22 @@ Node::Node(QObject *parent, int x, int y, Node::Type type, bool signal, QString
 }
 
 Node::~Node() {
-    delete backingWire;
+    backingWire->getPool()->release(backingWire->getId());
 }
 
-void Node::setTag(QString newTag) {
-    tag = newTag;
-    backingWire->setTag(tag);
+void Node::setTag(Tag newTag) {
+    backingWire->setTag(newTag);
 }
 
-QString Node::getTag() {
-    return tag;
+Tag Node::getTag() {
+    return backingWire->getTag();
 }
 
-bool Node::getSignal() {
+Bus Node::getSignal() {
     return backingWire->getSignal();
 }
 
-void Node::setSignal(bool signal) {
+void Node::setSignal(const Bus& signal) {
     backingWire->setSignal(signal);
 }
 
@@ -52,6 +51,14 @@ void Node::setDirection(Node::Direction newDirection) {
     direction = newDirection;
 }
 
+int Node::getX() {
+    return backingWire->getX();
+}
+
+int Node::getY() {
+    return backingWire->getY();
+}
+
 bool Node::getConnected() {
     return backingWire->isFullyConnected();
 }
@@ -16,7 +16,7 @@
 #include <QObject>
 #include <QGraphicsPixmapItem>
 #include <QGraphicsScene>
-#include "wire.h"
+#include "wirepool.h"
 
 class Node : public QObject {
     Q_OBJECT
@@ -32,12 +32,15 @@ public:
 
     /**
      * @brief Node - Creates a Node object
+     * @param wirePool - The pool to take the backing wire from.
      * @param parent - The parent object.
      * @param type - Determines if it is the ROOT or END of the node.
+     * @param signal - The signal a ROOT drives, or the one an END expects. Wider than one lane
+     * for bus nodes.
      * @param tag - The input node.
      */
-    explicit Node(QObject *parent = nullptr, int x = 0, int y = 0,
-                  Node::Type type = Node::Type::ROOT, bool signal = true, QString tag = "A");
+    explicit Node(WirePool* wirePool, QObject *parent = nullptr, int x = 0, int y = 0,
+                  Node::Type type = Node::Type::ROOT, Bus signal = true, Tag tag = Tag());
 
     /**
      * Destructor for the Node class.
@@ -46,27 +49,27 @@ public:
 
     /**
      * @brief setTag = Sets the tag used for connect wire comparisons.
-     * @param newTag - The new QString to set th tag to.
+     * @param newTag - The new Tag to set th tag to.
      */
-    void setTag(QString newTag);
+    void setTag(Tag newTag);
 
     /**
      * @brief getTag - The node's tag.
-     * @return A QString representing the tag.
+     * @return A Tag representing the tag.
      */
-    QString getTag();
+    Tag getTag();
 
     /**
      * @brief getSignal - The signal value of the node.
-     * @return A bool representing the signal.
+     * @return The signal, one lane wide unless the node is on a bus.
      */
-    bool getSignal();
+    Bus getSignal();
 
     /**
      * @brief setSignal - Set's the value of the node's signal.
-     * @param signal - A bool representing the signal value.
+     * @param signal - The signal value.
      */
-    void setSignal(bool signal);
+    void setSignal(const Bus& signal);
 
     /**
      * @brief getNodeType - The type of the node.
@@ -127,11 +130,6 @@ private:
      */
     Node::Direction direction;
 
-    /**
-     * @brief tag - The input node type.
-     */
-    QString tag;
-
     /**
      * @brief backingWire - Stores the wire for the Node. Necessary for managing data storage and
      * wire connections.
@@ -1,9 +0,0 @@
-#include "obstacle.h"
-
-Obstacle::Obstacle(QObject *parent)
-    : QObject{parent}
-{}
-
-Obstacle::~Obstacle() {
-
-}
@@ -0,0 +1,104 @@
+#include "obstaclelayer.h"
+#include <QtAlgorithms>
+
+ObstacleLayer::ObstacleLayer(int width, int height)
+    : width(width), height(height) {
+    wordsPerRow = (width + 63) / 64;
+    bits.fill(0, wordsPerRow * height);
+}
+
+void ObstacleLayer::set(int x, int y) {
+    if (x < 0 || x >= width || y < 0 || y >= height)
+        return;
+    bits[y * wordsPerRow + x / 64] |= quint64(1) << (x % 64);
+}
+
+void ObstacleLayer::reset(int x, int y) {
+    if (x < 0 || x >= width || y < 0 || y >= height)
+        return;
+    bits[y * wordsPerRow + x / 64] &= ~(quint64(1) << (x % 64));
+}
+
+void ObstacleLayer::fillRect(int x, int y, int rectWidth, int rectHeight,
+                             const ObstacleLayer* keepOpen) {
+    if (!clip(x, y, rectWidth, rectHeight))
+        return;
+    int firstWord = x / 64;
+    int lastWord = (x + rectWidth - 1) / 64;
+    for (int row = y; row < y + rectHeight; row++) {
+        quint64* rowBits = bits.data() + row * wordsPerRow;
+        for (int word = firstWord; word <= lastWord; word++) {
+            int first = word == firstWord ? x % 64 : 0;
+            int last = word == lastWord ? (x + rectWidth - 1) % 64 : 63;
+            quint64 mask = spanMask(first, last);
+            if (keepOpen)
+                mask &= ~keepOpen->bits[row * wordsPerRow + word];
+            rowBits[word] |= mask;
+        }
+    }
+}
+
+bool ObstacleLayer::anyInRect(int x, int y, int rectWidth, int rectHeight) const {
+    if (!clip(x, y, rectWidth, rectHeight))
+        return false;
+    int firstWord = x / 64;
+    int lastWord = (x + rectWidth - 1) / 64;
+    for (int row = y; row < y + rectHeight; row++) {
+        const quint64* rowBits = bits.constData() + row * wordsPerRow;
+        for (int word = firstWord; word <= lastWord; word++) {
+            int first = word == firstWord ? x % 64 : 0;
+            int last = word == lastWord ? (x + rectWidth - 1) % 64 : 63;
+            if (rowBits[word] & spanMask(first, last))
+                return true;
+        }
+    }
+    return false;
+}
+
+int ObstacleLayer::countInRect(int x, int y, int rectWidth, int rectHeight) const {
+    if (!clip(x, y, rectWidth, rectHeight))
+        return 0;
+    int total = 0;
+    int firstWord = x / 64;
+    int lastWord = (x + rectWidth - 1) / 64;
+    for (int row = y; row < y + rectHeight; row++) {
+        const quint64* rowBits = bits.constData() + row * wordsPerRow;
+        for (int word = firstWord; word <= lastWord; word++) {
+            int first = word == firstWord ? x % 64 : 0;
+            int last = word == lastWord ? (x + rectWidth - 1) % 64 : 63;
+            total += qPopulationCount(rowBits[word] & spanMask(first, last));
+        }
+    }
+    return total;
+}
+
+int ObstacleLayer::count() const {
+    int total = 0;
+    for (quint64 word : bits)
+        total += qPopulationCount(word);
+    return total;
+}
+
+void ObstacleLayer::clear() {
+    bits.fill(0);
+}
+
+bool ObstacleLayer::clip(int& x, int& y, int& rectWidth, int& rectHeight) const {
+    if (x < 0) {
+        rectWidth += x;
+        x = 0;
+    }
+    if (y < 0) {
+        rectHeight += y;
+        y = 0;
+    }
+    if (x + rectWidth > width)
+        rectWidth = width - x;
+    if (y + rectHeight > height)
+        rectHeight = height - y;
+    return rectWidth > 0 && rectHeight > 0;
+}
+
+quint64 ObstacleLayer::spanMask(int first, int last) {
+    return (~quint64(0) >> (63 - last)) & (~quint64(0) << first);
+}
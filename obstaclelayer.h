@@ -0,0 +1,143 @@
+/**
+ * This class stores the obstacles of a level as a row-major bitset,
+ * one bit per grid square. Obstacles carry no state of their own, so
+ * a blocked square is just a set bit, and rectangle fills, queries and
+ * counts work a 64-bit word at a time.
+ *
+ * @authors Max Donaldson, Jason Khong,
+ * Ariadne Petroulakis, Evan Tucker, and Ian Weller
+ *
+ * @version 22 April 2025
+ */
+
+#ifndef OBSTACLELAYER_H
+#define OBSTACLELAYER_H
+
+#include <QVector>
+
+class ObstacleLayer {
+
+public:
+    /**
+     * @brief ObstacleLayer - Creates a layer with no obstacles.
+     * @param width - The width of the board, in cells.
+     * @param height - The height of the board, in cells.
+     */
+    ObstacleLayer(int width, int height);
+
+    /**
+     * @brief test - Checks whether a square is blocked.
+     * @param x - X position on the grid.
+     * @param y - Y position on the grid.
+     * @return True if the square holds an obstacle. Out of bounds squares read as open.
+     */
+    bool test(int x, int y) const {
+        if (x < 0 || x >= width || y < 0 || y >= height)
+            return false;
+        return (bits[y * wordsPerRow + x / 64] >> (x % 64)) & 1;
+    }
+
+    /**
+     * @brief set - Blocks a single square. Out of bounds positions are ignored.
+     * @param x - X position on the grid.
+     * @param y - Y position on the grid.
+     */
+    void set(int x, int y);
+
+    /**
+     * @brief reset - Opens a single square. Out of bounds positions are ignored.
+     * @param x - X position on the grid.
+     * @param y - Y position on the grid.
+     */
+    void reset(int x, int y);
+
+    /**
+     * @brief fillRect - Blocks every square of a rectangle. The rectangle is clipped to the board.
+     * @param x - The left column.
+     * @param y - The top row.
+     * @param rectWidth - The number of columns.
+     * @param rectHeight - The number of rows.
+     * @param keepOpen - A layer of the same size whose set squares are left as they are, or
+     * nullptr to block the whole rectangle.
+     */
+    void fillRect(int x, int y, int rectWidth, int rectHeight,
+                  const ObstacleLayer* keepOpen = nullptr);
+
+    /**
+     * @brief anyInRect - Checks whether any square of a rectangle is blocked.
+     * @param x - The left column.
+     * @param y - The top row.
+     * @param rectWidth - The number of columns.
+     * @param rectHeight - The number of rows.
+     * @return True if at least one square in the clipped rectangle holds an obstacle.
+     */
+    bool anyInRect(int x, int y, int rectWidth, int rectHeight) const;
+
+    /**
+     * @brief countInRect - Counts the blocked squares of a rectangle.
+     * @param x - The left column.
+     * @param y - The top row.
+     * @param rectWidth - The number of columns.
+     * @param rectHeight - The number of rows.
+     * @return The number of obstacles in the clipped rectangle.
+     */
+    int countInRect(int x, int y, int rectWidth, int rectHeight) const;
+
+    /**
+     * @brief getRowWord - Getter for 64 squares of one row at once.
+     * @param y - The row.
+     * @param word - The word index within the row. Bit i is square word * 64 + i.
+     * @return The bits of the word. Bits past the board edge are clear.
+     */
+    quint64 getRowWord(int y, int word) const {
+        return bits[y * wordsPerRow + word];
+    }
+
+    /**
+     * @brief count - Counts every blocked square on the board.
+     * @return The number of obstacles.
+     */
+    int count() const;
+
+    /**
+     * @brief clear - Opens every square.
+     */
+    void clear();
+
+private:
+    /**
+     * @brief width - The width of the board, in cells.
+     */
+    int width;
+
+    /**
+     * @brief height - The height of the board, in cells.
+     */
+    int height;
+
+    /**
+     * @brief wordsPerRow - The number of 64-bit words covering one row.
+     */
+    int wordsPerRow;
+
+    /**
+     * @brief bits - One bit per square, rows padded to a whole number of words.
+     */
+    QVector<quint64> bits;
+
+    /**
+     * @brief clip - Clips a rectangle to the board.
+     * @return False if nothing of the rectangle is left.
+     */
+    bool clip(int& x, int& y, int& rectWidth, int& rectHeight) const;
+
+    /**
+     * @brief spanMask - Builds the mask of bits first through last of a word, inclusive.
+     * @param first - The lowest bit, 0 to 63.
+     * @param last - The highest bit, first to 63.
+     * @return The mask.
+     */
+    static quint64 spanMask(int first, int last);
+};
+
+#endif // OBSTACLELAYER_H
@@ -0,0 +1,477 @@
+#include "propagator.h"
+#include "level.h"
+#include <algorithm>
+#include <iterator>
+
+Propagator::Propagator(Level* level)
+    : level(level), stale(true), touchedCells(0), unpluggedEnds(0) {
+}
+
+void Propagator::markChanged(Wire* driverWire) {
+    if (driverWire)
+        changedDrivers.append(driverWire);
+}
+
+void Propagator::markDirty(Gate* gate) {
+    if (gate)
+        dirtyGates.append(gate);
+}
+
+void Propagator::markEdited(Wire* wire) {
+    if (stale)
+        return;
+    int net = wireNets.value(wire, -1);
+    if (net >= 0)
+        editedNets.insert(net);
+    editedWires.append(wire->getId());
+}
+
+void Propagator::invalidate() {
+    stale = true;
+}
+
+void Propagator::clear() {
+    changedDrivers.clear();
+    dirtyGates.clear();
+}
+
+int Propagator::getTouchedCells() {
+    return touchedCells;
+}
+
+int Propagator::getUnpluggedEnds() {
+    return unpluggedEnds;
+}
+
+void Propagator::reset() {
+    clear();
+    loops.clear();
+    gateEdges.clear();
+    oscillating.clear();
+    reportedFlags.clear();
+    flagChanges.clear();
+    stale = true;
+}
+
+int Propagator::getGateLevel(Gate* gate) {
+    refresh();
+    int index = gateIndices.value(outputHalf(gate), -1);
+    return index < 0 ? -1 : gateLevels[index];
+}
+
+bool Propagator::isOnLoop(Gate* gate) {
+    refresh();
+    return loops.isOnLoop(outputHalf(gate));
+}
+
+bool Propagator::isOscillating(Gate* gate) {
+    return oscillating.contains(outputHalf(gate));
+}
+
+int Propagator::getLoopCount() {
+    refresh();
+    return loops.getLoopCount();
+}
+
+Gate* Propagator::gateForInput(Wire* sinkWire) {
+    Gate* gate = level->getGate(sinkWire->getX(), sinkWire->getY());
+    if (gate && gate->getInputNode()->getWire() == sinkWire)
+        return gate;
+    return nullptr;
+}
+
+Gate* Propagator::outputHalf(Gate* gate) {
+    if (gate->getOutputNode() == nullptr && gate->getOtherHalf())
+        return gate->getOtherHalf();
+    return gate;
+}
+
+void Propagator::rebuild() {
+    stale = false;
+    editedWires.clear();
+    editedNets.clear();
+    nets.clear();
+    driverNets.clear();
+    wireNets.clear();
+    gates.clear();
+    gateIndices.clear();
+
+    // Every driver gets a net: each ROOT node, then each gate output in placement order.
+    for (Node* node : level->getNodes()) {
+        if (node->getNodeType() == Node::Type::ROOT)
+            nets.append({node->getWire(), -1, {}, {}});
+    }
+    for (Gate* gate : level->getGates()) {
+        if (gate->getOutputNode() == nullptr)
+            continue;
+        int index = gates.size();
+        gateIndices.insert(gate, index);
+        nets.append({gate->getOutputNode()->getWire(), index, {}, {}});
+        gates.append(gate);
+    }
+    int gateCount = gates.size();
+    gateNets.resize(gateCount);
+    for (int net = 0; net < nets.size(); net++) {
+        driverNets.insert(nets[net].driver, net);
+        if (nets[net].gate >= 0)
+            gateNets[nets[net].gate] = net;
+        walkNet(net);
+    }
+
+    // Only the gate to gate edges that changed are passed on, so loops are found around them.
+    QHash<QPair<Gate*, Gate*>, int> edges;
+    gateInputs.fill(QVector<int>(), gateCount);
+    for (int gate = 0; gate < gateCount; gate++) {
+        for (const Sink& sink : nets[gateNets[gate]].sinks) {
+            if (sink.gate < 0)
+                continue;
+            edges[{gates[gate], gates[sink.gate]}]++;
+            gateInputs[sink.gate].append(gate);
+        }
+    }
+    for (auto it = gateEdges.cbegin(); it != gateEdges.cend(); ++it) {
+        for (int count = edges.value(it.key()); count < it.value(); count++)
+            loops.removeEdge(it.key().first, it.key().second);
+    }
+    for (auto it = edges.cbegin(); it != edges.cend(); ++it) {
+        for (int count = gateEdges.value(it.key()); count < it.value(); count++)
+            loops.addEdge(it.key().first, it.key().second);
+    }
+    gateEdges = edges;
+
+    for (auto it = oscillating.begin(); it != oscillating.end();) {
+        if (gateIndices.contains(*it))
+            ++it;
+        else
+            it = oscillating.erase(it);
+    }
+    gateLevels.fill(0, gateCount);
+    affected.fill(false, gateCount);
+    queued.fill(false, gateCount);
+    forced.fill(false, gateCount);
+    evaluations.fill(0, gateCount);
+    evaluated.clear();
+    ready.clear();
+    QVector<int> everyGate(gateCount);
+    for (int gate = 0; gate < gateCount; gate++)
+        everyGate[gate] = gate;
+    levelize(everyGate);
+}
+
+void Propagator::patch() {
+    // An edited wire still on the board, or a node's backing wire, leads to the net it is in now.
+    QSet<Wire*> searched;
+    for (Wire::Id id : editedWires) {
+        Wire* wire = level->wirePool.get(id);
+        if (wire->getOwner() == Wire::Owner::BOARD && !level->isWireOnBoard(id))
+            continue;
+        int net = driverNets.value(findDriver(wire, searched), -1);
+        if (net >= 0)
+            editedNets.insert(net);
+    }
+    editedWires.clear();
+
+    // Walk each net again and pass on only the edges its gate gained or lost.
+    QVector<int> starts;
+    for (int net : editedNets) {
+        int gate = nets[net].gate;
+        QVector<int> oldSinks;
+        QVector<int> newSinks;
+        for (const Sink& sink : nets[net].sinks) {
+            if (sink.gate >= 0)
+                oldSinks.append(sink.gate);
+        }
+        walkNet(net);
+        if (gate < 0)
+            continue;
+        for (const Sink& sink : nets[net].sinks) {
+            if (sink.gate >= 0)
+                newSinks.append(sink.gate);
+        }
+        std::sort(oldSinks.begin(), oldSinks.end());
+        std::sort(newSinks.begin(), newSinks.end());
+        QVector<int> lost;
+        QVector<int> gained;
+        std::set_difference(oldSinks.cbegin(), oldSinks.cend(), newSinks.cbegin(),
+                            newSinks.cend(), std::back_inserter(lost));
+        std::set_difference(newSinks.cbegin(), newSinks.cend(), oldSinks.cbegin(),
+                            oldSinks.cend(), std::back_inserter(gained));
+        for (int sink : lost) {
+            QPair<Gate*, Gate*> edge(gates[gate], gates[sink]);
+            loops.removeEdge(edge.first, edge.second);
+            if (--gateEdges[edge] == 0)
+                gateEdges.remove(edge);
+            gateInputs[sink].removeOne(gate);
+            starts << gate << sink;
+        }
+        for (int sink : gained) {
+            QPair<Gate*, Gate*> edge(gates[gate], gates[sink]);
+            loops.addEdge(edge.first, edge.second);
+            gateEdges[edge]++;
+            gateInputs[sink].append(gate);
+            starts << gate << sink;
+        }
+    }
+    editedNets.clear();
+    if (!starts.isEmpty())
+        levelize(starts);
+}
+
+void Propagator::refresh() {
+    if (stale)
+        rebuild();
+    else if (!editedWires.isEmpty() || !editedNets.isEmpty())
+        patch();
+    else
+        return;
+    loops.takeChangedGates(flagChanges);
+}
+
+void Propagator::walkNet(int net) {
+    Net& current = nets[net];
+    for (Wire* wire : current.wires) {
+        if (wireNets.value(wire, -1) == net)
+            wireNets.remove(wire);
+    }
+    for (const Sink& sink : current.sinks) {
+        if (wireNets.value(sink.wire, -1) == net)
+            wireNets.remove(sink.wire);
+    }
+    current.wires.clear();
+    current.sinks.clear();
+
+    // Walk down every tail and branch.
+    QVector<QPair<Wire*, Wire*>> stack;
+    Wire* firstWire = current.driver->getTailConnection();
+    if (firstWire && firstWire != current.driver)
+        stack.append({firstWire, current.driver});
+    while (!stack.isEmpty()) {
+        QPair<Wire*, Wire*> next = stack.takeLast();
+        Wire* currentWire = next.first;
+        wireNets.insert(currentWire, net);
+        if (currentWire->getTailConnection() == currentWire) {
+            Gate* half = gateForInput(currentWire);
+            int gate = half ? gateIndices.value(outputHalf(half), -1) : -1;
+            current.sinks.append({gate, half, currentWire, next.second});
+            continue;
+        }
+        current.wires.append(currentWire);
+        for (int i = currentWire->getBranchCount() - 1; i >= 0; i--)
+            stack.append({currentWire->getBranchConnection(i), currentWire});
+        if (Wire* tailWire = currentWire->getTailConnection())
+            stack.append({tailWire, currentWire});
+    }
+}
+
+Wire* Propagator::findDriver(Wire* wire, QSet<Wire*>& searched) {
+    while (wire && wire->getHeadConnection() != wire) {
+        if (searched.contains(wire))
+            return nullptr;
+        searched.insert(wire);
+        wire = wire->getHeadConnection();
+    }
+    return wire;
+}
+
+void Propagator::levelize(const QVector<int>& starts) {
+    // Gather every gate downstream of the starts. A loop through one of them is gathered whole.
+    QVector<int> reached;
+    for (int gate : starts) {
+        if (!affected[gate]) {
+            affected[gate] = true;
+            reached.append(gate);
+        }
+    }
+    for (int i = 0; i < reached.size(); i++) {
+        for (const Sink& sink : nets[gateNets[reached[i]]].sinks) {
+            if (sink.gate >= 0 && !affected[sink.gate]) {
+                affected[sink.gate] = true;
+                reached.append(sink.gate);
+            }
+        }
+    }
+
+    // Take each loop as a whole. Gates that weren't reached keep their levels and only raise
+    // those of the gates they feed.
+    QHash<int, int> components;
+    QHash<int, QVector<int>> componentGates;
+    QHash<int, int> pending;
+    QHash<int, int> levels;
+    for (int gate : reached) {
+        int component = loops.getComponent(gates[gate]);
+        components.insert(gate, component);
+        componentGates[component].append(gate);
+        pending[component];
+        levels[component];
+    }
+    for (int gate : reached) {
+        int component = components.value(gate);
+        for (int input : gateInputs[gate]) {
+            if (!affected[input])
+                levels[component] = qMax(levels[component], gateLevels[input] + 1);
+            else if (components.value(input) != component)
+                pending[component]++;
+        }
+    }
+
+    // A component is ready once every reached component feeding it has a level.
+    QVector<int> levelized;
+    for (int gate : reached) {
+        int component = components.value(gate);
+        if (pending.value(component) == 0 && componentGates[component].first() == gate)
+            levelized.append(component);
+    }
+    for (int done = 0; done < levelized.size(); done++) {
+        int component = levelized[done];
+        int level = levels.value(component);
+        for (int gate : componentGates.value(component)) {
+            gateLevels[gate] = level;
+            for (const Sink& sink : nets[gateNets[gate]].sinks) {
+                if (sink.gate < 0)
+                    continue;
+                int sinkComponent = components.value(sink.gate);
+                if (sinkComponent == component)
+                    continue;
+                levels[sinkComponent] = qMax(levels[sinkComponent], level + 1);
+                if (--pending[sinkComponent] == 0)
+                    levelized.append(sinkComponent);
+            }
+        }
+    }
+    for (int gate : reached)
+        affected[gate] = false;
+}
+
+bool Propagator::comesAfter(int first, int second) const {
+    if (gateLevels[first] != gateLevels[second])
+        return gateLevels[first] > gateLevels[second];
+    return first > second;
+}
+
+void Propagator::enqueue(int gate) {
+    if (gate < 0 || queued[gate])
+        return;
+    queued[gate] = true;
+    ready.append(gate);
+    std::push_heap(ready.begin(), ready.end(), [this](int first, int second) {
+        return comesAfter(first, second);
+    });
+}
+
+void Propagator::pushNet(int net) {
+    const Net& current = nets[net];
+    Bus signal = current.driver->getSignal();
+    Tag tag = current.driver->getTag();
+    for (Wire* wire : current.wires) {
+        wire->setSignal(signal);
+        wire->setTag(tag);
+        touchedCells++;
+    }
+
+    for (const Sink& sink : current.sinks) {
+        // Gate inputs take on the new values:
+        if (sink.half) {
+            sink.half->getInputNode()->setTag(tag);
+            sink.half->getInputNode()->setSignal(signal);
+            enqueue(sink.gate);
+            continue;
+        }
+
+        // END nodes keep their expected values, so a mismatch unplugs the branch:
+        if (sink.wire->getHeadConnection() != sink.parent)
+            continue;
+        if (sink.wire->getSignal() != signal || sink.wire->getTag() != tag) {
+            sink.parent->replaceTail(sink.wire, nullptr);
+            sink.wire->setHeadConnection(nullptr);
+            unpluggedEnds++;
+            editedNets.insert(net);
+        }
+    }
+}
+
+void Propagator::propagate() {
+    touchedCells = 0;
+    unpluggedEnds = 0;
+    if (changedDrivers.isEmpty() && dirtyGates.isEmpty())
+        return;
+    refresh();
+
+    // Push the changed drivers, then evaluate the queued gates in level order. Every gate
+    // feeding a gate comes before it, so each one is evaluated once with its inputs settled.
+    // Only a gate on a loop can be queued again, by a later gate of the same loop.
+    for (Gate* gate : dirtyGates) {
+        int index = gateIndices.value(outputHalf(gate), -1);
+        if (index < 0)
+            continue;
+        forced[index] = true;
+        enqueue(index);
+    }
+    for (Wire* driverWire : changedDrivers) {
+        int net = driverNets.value(driverWire, -1);
+        if (net >= 0)
+            pushNet(net);
+    }
+    QSet<int> exhausted;
+    while (!ready.isEmpty()) {
+        std::pop_heap(ready.begin(), ready.end(), [this](int first, int second) {
+            return comesAfter(first, second);
+        });
+        int index = ready.takeLast();
+        queued[index] = false;
+        Gate* gate = gates[index];
+        if (evaluations[index] >= LOOP_BUDGET) {
+            exhausted.insert(loops.getComponent(gate));
+            continue;
+        }
+        if (evaluations[index]++ == 0)
+            evaluated.append(index);
+        Node* outputNode = gate->getOutputNode();
+        Bus oldSignal = outputNode->getSignal();
+        Tag oldTag = outputNode->getTag();
+        gate->evaluate();
+        touchedCells++;
+
+        // Unchanged outputs stop here, unless an edit already set them.
+        if (outputNode->getSignal() != oldSignal || outputNode->getTag() != oldTag
+            || forced[index])
+            pushNet(gateNets[index]);
+        forced[index] = false;
+    }
+
+    // A loop that settled this time is no longer flagged, even the gates it didn't revisit.
+    QSet<int> settled;
+    for (int index : evaluated) {
+        int component = loops.getComponent(gates[index]);
+        if (exhausted.contains(component)) {
+            oscillating.insert(gates[index]);
+            flagChanges.insert(gates[index]);
+        }
+        else
+            settled.insert(component);
+        evaluations[index] = 0;
+    }
+    for (auto it = oscillating.begin(); it != oscillating.end();) {
+        if (settled.contains(loops.getComponent(*it))) {
+            flagChanges.insert(*it);
+            it = oscillating.erase(it);
+        }
+        else
+            ++it;
+    }
+    evaluated.clear();
+    clear();
+}
+
+void Propagator::reportFlags() {
+    for (Gate* gate : flagChanges) {
+        quint8 flags = (loops.isOnLoop(gate) ? 1 : 0) | (oscillating.contains(gate) ? 2 : 0);
+        if (reportedFlags.value(gate) == flags)
+            continue;
+        reportedFlags.insert(gate, flags);
+        for (Gate* half : {gate, gate->getOtherHalf()}) {
+            if (half)
+                level->markCellDirty(half->getInputNode()->getX(), half->getInputNode()->getY());
+        }
+    }
+    flagChanges.clear();
+}
@@ -0,0 +1,415 @@
+/**
+ * This class moves signals through a level's circuit after an edit.
+ * The wiring is compiled into a levelized DAG: every driver (a ROOT node
+ * or gate output) owns a net listing the wire cells it reaches through
+ * every tail and junction branch and the gate inputs and END nodes it
+ * feeds, and every gate gets a level above each gate feeding it. Placing
+ * or removing a wire only walks the nets it was and is part of again,
+ * and only the gates downstream of a gate to gate edge that changed get
+ * new levels. Changed drivers and dirty gates are queued up, then only
+ * the fan-out cone of those changes is recomputed, visiting each gate
+ * once in level order.
+ *
+ * Feedback loops are tracked by a CycleDetector as the wiring changes.
+ * The gates of a loop share a level and are re-evaluated until they
+ * settle, but only LOOP_BUDGET times each per call, so a loop that
+ * oscillates is frozen and flagged instead of spinning forever.
+ *
+ * @authors Max Donaldson, Jason Khong,
+ * Ariadne Petroulakis, Evan Tucker, and Ian Weller
+ *
+ * @version 22 April 2025
+ */
+
+#ifndef PROPAGATOR_H
+#define PROPAGATOR_H
+
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QVector>
+#include "cycledetector.h"
+#include "wire.h"
+#include "gate.h"
+
+class Level;
+
+class Propagator {
+
+public:
+    /**
+     * @brief LOOP_BUDGET - The most times a gate on a loop is evaluated per propagate call.
+     */
+    static const int LOOP_BUDGET = 64;
+
+    /**
+     * @brief Propagator - Creates an engine with nothing queued.
+     * @param level - The level whose grid is used to find gate inputs.
+     */
+    explicit Propagator(Level* level);
+
+    /**
+     * @brief markChanged - Queues a driver whose signal or tag has changed. The driver is the
+     * backing wire of a ROOT node or of a gate's output node.
+     * @param driverWire - The backing wire at the head of the changed net.
+     */
+    void markChanged(Wire* driverWire);
+
+    /**
+     * @brief markDirty - Queues a gate whose inputs have changed and needs re-evaluating.
+     * @param gate - Either half of the gate.
+     */
+    void markDirty(Gate* gate);
+
+    /**
+     * @brief markEdited - Notes that a wire was placed, removed or relinked, so the nets it was and
+     * is part of are walked again before the next propagate call.
+     * @param wire - The edited wire.
+     */
+    void markEdited(Wire* wire);
+
+    /**
+     * @brief invalidate - Notes that gates or nodes were placed or removed, or that many wires
+     * changed at once, so the whole DAG is rebuilt on the next propagate call.
+     */
+    void invalidate();
+
+    /**
+     * @brief propagate - Recomputes the fan-out cone of everything queued since the last call.
+     * Branches ending in an END node that no longer matches the new signal or tag are unplugged.
+     */
+    void propagate();
+
+    /**
+     * @brief clear - Drops everything queued without propagating it.
+     */
+    void clear();
+
+    /**
+     * @brief reset - Drops everything queued and forgets the circuit, including its loops. Used
+     * when the gates are deleted.
+     */
+    void reset();
+
+    /**
+     * @brief getTouchedCells - Getter for the amount of work done by the last propagate call.
+     * @return The number of wire cells written plus gates evaluated.
+     */
+    int getTouchedCells();
+
+    /**
+     * @brief getUnpluggedEnds - Getter for the number of END nodes unplugged by the last
+     * propagate call.
+     * @return The unplugged END node count.
+     */
+    int getUnpluggedEnds();
+
+    /**
+     * @brief getGateLevel - Gets how deep a gate sits in the DAG built by the last propagate
+     * call.
+     * @param gate - Either half of the gate.
+     * @return 0 for gates only fed by ROOT nodes or nothing, one more than the deepest gate
+     * feeding it otherwise, or -1 if the gate isn't placed. Every gate of a loop has the same
+     * level.
+     */
+    int getGateLevel(Gate* gate);
+
+    /**
+     * @brief isOnLoop - Checks whether a gate is part of a feedback loop.
+     * @param gate - Either half of the gate.
+     * @return True if the gate's output finds its way back to one of its inputs.
+     */
+    bool isOnLoop(Gate* gate);
+
+    /**
+     * @brief isOscillating - Checks whether a gate's loop ran out of budget without settling the
+     * last time it was propagated.
+     * @param gate - Either half of the gate.
+     * @return True if the gate's loop is oscillating.
+     */
+    bool isOscillating(Gate* gate);
+
+    /**
+     * @brief getLoopCount - Getter for the number of feedback loops in the circuit.
+     * @return The loop count.
+     */
+    int getLoopCount();
+
+    /**
+     * @brief reportFlags - Marks the squares of the gates whose loop flags changed since the last
+     * call as needing a redraw. Only the gates the loop detector and propagate noted are looked
+     * at, as of the last time the DAG was brought up to date.
+     */
+    void reportFlags();
+
+    /**
+     * @brief gateForInput - Finds the gate half that owns a sink wire as its input.
+     * @param sinkWire - A backing wire at the tail end of a chain.
+     * @return The gate half owning the wire, or nullptr if it belongs to an END node.
+     */
+    Gate* gateForInput(Wire* sinkWire);
+
+private:
+    /**
+     * @brief The Sink struct - A gate input or END node fed by a net.
+     */
+    struct Sink {
+        /**
+         * @brief gate - The index in gates of the fed gate, or -1 for an END node.
+         */
+        int gate;
+
+        /**
+         * @brief half - The gate half whose input is fed, or nullptr for an END node.
+         */
+        Gate* half;
+
+        /**
+         * @brief wire - The backing wire of the fed input.
+         */
+        Wire* wire;
+
+        /**
+         * @brief parent - The wire whose tail or branch plugs into the input.
+         */
+        Wire* parent;
+    };
+
+    /**
+     * @brief The Net struct - The wiring hanging off one driver.
+     */
+    struct Net {
+        /**
+         * @brief driver - The backing wire of the ROOT node or gate output at the head.
+         */
+        Wire* driver;
+
+        /**
+         * @brief gate - The index in gates of the driving gate, or -1 for a ROOT node.
+         */
+        int gate;
+
+        /**
+         * @brief wires - The board wire cells reached, head first.
+         */
+        QVector<Wire*> wires;
+
+        /**
+         * @brief sinks - The inputs fed.
+         */
+        QVector<Sink> sinks;
+    };
+
+    /**
+     * @brief level - The level being propagated.
+     */
+    Level* level;
+
+    /**
+     * @brief changedDrivers - Drivers queued by markChanged.
+     */
+    QVector<Wire*> changedDrivers;
+
+    /**
+     * @brief dirtyGates - Gates queued by markDirty.
+     */
+    QVector<Gate*> dirtyGates;
+
+    /**
+     * @brief stale - Whether gates or nodes changed since the DAG was built.
+     */
+    bool stale;
+
+    /**
+     * @brief editedWires - The wires passed to markEdited since the DAG was last brought up to
+     * date.
+     */
+    QVector<Wire::Id> editedWires;
+
+    /**
+     * @brief editedNets - The nets that held an edited wire, or unplugged an END node, since the
+     * DAG was last brought up to date.
+     */
+    QSet<int> editedNets;
+
+    /**
+     * @brief nets - The net of every driver: each ROOT node, then each gate in gates.
+     */
+    QVector<Net> nets;
+
+    /**
+     * @brief driverNets - The net of each driver's backing wire.
+     */
+    QHash<Wire*, int> driverNets;
+
+    /**
+     * @brief wireNets - The net each board wire and sink wire was part of when last walked.
+     */
+    QHash<Wire*, int> wireNets;
+
+    /**
+     * @brief loops - The strongly connected components of the gates, updated edge by edge.
+     */
+    CycleDetector loops;
+
+    /**
+     * @brief gateEdges - How many times each gate feeds each other gate, as passed to loops.
+     */
+    QHash<QPair<Gate*, Gate*>, int> gateEdges;
+
+    /**
+     * @brief oscillating - The output halves of the gates on loops that last ran out of budget.
+     */
+    QSet<Gate*> oscillating;
+
+    /**
+     * @brief reportedFlags - The loop flags of each output half as last reported to the level:
+     * 1 if it is on a loop, plus 2 if the loop is oscillating.
+     */
+    QHash<Gate*, quint8> reportedFlags;
+
+    /**
+     * @brief flagChanges - The output halves whose loop flags may have changed since the last
+     * reportFlags call.
+     */
+    QSet<Gate*> flagChanges;
+
+    /**
+     * @brief gates - The output half of every gate, in placement order.
+     */
+    QVector<Gate*> gates;
+
+    /**
+     * @brief gateIndices - The index in gates of each output half.
+     */
+    QHash<Gate*, int> gateIndices;
+
+    /**
+     * @brief gateLevels - The level of each gate.
+     */
+    QVector<int> gateLevels;
+
+    /**
+     * @brief gateNets - The net driven by each gate.
+     */
+    QVector<int> gateNets;
+
+    /**
+     * @brief gateInputs - The gates feeding each gate, once per edge.
+     */
+    QVector<QVector<int>> gateInputs;
+
+    /**
+     * @brief affected - Whether each gate was reached by the current levelize call.
+     */
+    QVector<bool> affected;
+
+    /**
+     * @brief queued - Whether each gate is waiting in ready.
+     */
+    QVector<bool> queued;
+
+    /**
+     * @brief forced - Whether each gate was marked dirty, so its output is pushed even if the
+     * evaluation doesn't change it. Edits set a gate's output as they connect it.
+     */
+    QVector<bool> forced;
+
+    /**
+     * @brief evaluations - How many times each gate was evaluated this call.
+     */
+    QVector<int> evaluations;
+
+    /**
+     * @brief evaluated - The gates evaluated this call.
+     */
+    QVector<int> evaluated;
+
+    /**
+     * @brief ready - The queued gates, as a heap ordered by level and then by index.
+     */
+    QVector<int> ready;
+
+    /**
+     * @brief touchedCells - Work counter for the last propagate call.
+     */
+    int touchedCells;
+
+    /**
+     * @brief unpluggedEnds - END nodes unplugged during the last propagate call.
+     */
+    int unpluggedEnds;
+
+    /**
+     * @brief outputHalf - Gets the half of a gate holding the output node.
+     * @param gate - Either half of the gate.
+     * @return The half with the output node. Gates are tracked by this half.
+     */
+    Gate* outputHalf(Gate* gate);
+
+    /**
+     * @brief rebuild - Compiles the nets of every driver, passes the gate edges that changed on
+     * to the loop detector, and levelizes the loops and remaining gates.
+     */
+    void rebuild();
+
+    /**
+     * @brief patch - Walks the nets of the edited wires again, passes the gate edges they gained
+     * or lost on to the loop detector, and levelizes the gates downstream of those edges.
+     */
+    void patch();
+
+    /**
+     * @brief refresh - Rebuilds if gates or nodes changed since the last build, or patches the
+     * nets of any wires edited since.
+     */
+    void refresh();
+
+    /**
+     * @brief walkNet - Lists the wire cells and sinks of a net again, down every tail and
+     * branch of its driver.
+     * @param net - The net index.
+     */
+    void walkNet(int net);
+
+    /**
+     * @brief findDriver - Follows head connections up from a wire to the driver of its chain,
+     * unless it meets a wire an earlier search already passed through.
+     * @param wire - A wire in the chain.
+     * @param searched - The wires passed through so far. Those passed now are added.
+     * @return The driver's backing wire, or nullptr if the chain is cut off from any driver or
+     * was already searched.
+     */
+    Wire* findDriver(Wire* wire, QSet<Wire*>& searched);
+
+    /**
+     * @brief levelize - Gives new levels to some gates and every gate downstream of them. Each
+     * loop takes the level of its highest input, and the gates upstream keep theirs.
+     * @param starts - The gates at the ends of the gate to gate edges that changed.
+     */
+    void levelize(const QVector<int>& starts);
+
+    /**
+     * @brief comesAfter - Orders the ready heap.
+     * @param first - The index of one gate.
+     * @param second - The index of another.
+     * @return True if the first gate is evaluated after the second: it has a higher level, or the
+     * same level and a higher index.
+     */
+    bool comesAfter(int first, int second) const;
+
+    /**
+     * @brief enqueue - Queues a gate for evaluation unless it already was this call.
+     * @param gate - The gate's index in gates.
+     */
+    void enqueue(int gate);
+
+    /**
+     * @brief pushNet - Copies the driver's signal and tag to every cell of its net. Updates and
+     * queues each fed gate, and unplugs END nodes that no longer match.
+     * @param net - The net index.
+     */
+    void pushNet(int net);
+};
+
+#endif // PROPAGATOR_H
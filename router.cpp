@@ -0,0 +1,313 @@
+#include "router.h"
+#include "level.h"
+#include <QtAlgorithms>
+
+Router::Router(Level* level)
+    : level(level), width(0), height(0), wordsPerRow(0), keepPortsClear(false) {
+}
+
+void Router::setKeepPortsClear(bool keepClear) {
+    keepPortsClear = keepClear;
+}
+
+bool Router::findRoute(int sourceX, int sourceY, int targetX, int targetY, Tag tag,
+                       QVector<QPoint>& route) {
+    route.clear();
+    if (tag.isEmpty())
+        return false;
+
+    // The source must be an output drawWire would start a chain from, or a wire to branch.
+    Node* sourceNode = level->getNode(sourceX, sourceY);
+    Gate* sourceGate = level->getGate(sourceX, sourceY);
+    Wire* sourceWire = level->getWire(sourceX, sourceY);
+    Bus signal;
+    if (sourceNode) {
+        if (sourceNode->getNodeType() != Node::Type::ROOT || sourceNode->getConnected()
+            || sourceNode->getTag() != tag)
+            return false;
+        signal = sourceNode->getSignal();
+    }
+    else if (sourceGate) {
+        if (sourceGate->getOutputNode() == nullptr)
+            sourceGate = sourceGate->getOtherHalf();
+        if (sourceGate == nullptr || !sourceGate->canDrive()
+            || sourceGate->getOutputNode()->getConnected() || sourceGate->getTag() != tag)
+            return false;
+        signal = sourceGate->getOutputNode()->getSignal();
+    }
+    else if (sourceWire) {
+        if (!sourceWire->isFullyConnected() || sourceWire->getTag() != tag
+            || sourceWire->getBranchCount() >= Wire::MAX_BRANCHES)
+            return false;
+        signal = sourceWire->getSignal();
+    }
+    else
+        return false;
+
+    // The target must be an input the chain would plug into.
+    Node* targetNode = level->getNode(targetX, targetY);
+    Gate* targetGate = level->getGate(targetX, targetY);
+    if (targetNode) {
+        if (targetNode->getNodeType() != Node::Type::END || targetNode->getConnected()
+            || targetNode->getTag() != tag || targetNode->getSignal() != signal)
+            return false;
+    }
+    else if (targetGate == nullptr || targetGate->getInputNode()->getConnected())
+        return false;
+
+    resize();
+    buildOpen(tag, signal, sourceNode, sourceGate, targetNode, targetGate);
+    if (sourceNode)
+        markPort(starts, sourceX, sourceY, sourceNode->getDirection(), true);
+    else if (sourceGate)
+        markPort(starts, sourceGate->getInputNode()->getX(), sourceGate->getInputNode()->getY(),
+                 sourceGate->getOutputDirection(), true);
+    else
+        markBranches(sourceWire, tag);
+    if (targetNode)
+        markPort(goals, targetX, targetY, Node::Direction::NONE, true);
+    else
+        markPort(goals, targetX, targetY, targetGate->getInputDirection(), true);
+
+    int goal = search();
+    if (goal < 0)
+        return false;
+
+    // Walk back down the search steps to a start square.
+    int x = goal % width;
+    int y = goal / width;
+    int step = distances[goal];
+    route.resize(step + 1);
+    route[step] = QPoint(x, y);
+    while (step > 0) {
+        step--;
+        for (int i = 0; i < 4; i++) {
+            int nextX = x + CellGrid::NEIGHBOR_X[i];
+            int nextY = y + CellGrid::NEIGHBOR_Y[i];
+            if (nextX >= 0 && nextX < width && nextY >= 0 && nextY < height
+                && distances[nextY * width + nextX] == step) {
+                x = nextX;
+                y = nextY;
+                break;
+            }
+        }
+        route[step] = QPoint(x, y);
+    }
+    return true;
+}
+
+void Router::markBranches(Wire* sourceWire, Tag tag) {
+    Wire::Direction direction;
+    Level::Cell around[4];
+
+    // A square next to several junctions branches off the first one placeWire finds.
+    for (int i = 0; i < 4; i++) {
+        int x = sourceWire->getX() + CellGrid::NEIGHBOR_X[i];
+        int y = sourceWire->getY() + CellGrid::NEIGHBOR_Y[i];
+        if (!level->isEmptySpace(x, y))
+            continue;
+        level->grid.neighbors(x, y, around);
+        if (level->findJunction(around, tag, direction) == sourceWire)
+            mark(starts, x, y);
+    }
+}
+
+void Router::resize() {
+    width = level->getWidth();
+    height = level->getHeight();
+    wordsPerRow = (width + 63) / 64;
+    open.fill(0, height * wordsPerRow);
+    starts.fill(0, height * wordsPerRow);
+    goals.fill(0, height * wordsPerRow);
+}
+
+void Router::buildOpen(Tag tag, const Bus& signal, Node* sourceNode, Gate* sourceGate,
+                       Node* targetNode, Gate* targetGate) {
+    // Start from every square that is on the board and free of obstacles.
+    quint64 lastWordMask = width % 64 ? (quint64(1) << (width % 64)) - 1 : ~quint64(0);
+    for (int y = 0; y < height; y++) {
+        for (int word = 0; word < wordsPerRow; word++) {
+            quint64 onBoard = word == wordsPerRow - 1 ? lastWordMask : ~quint64(0);
+            open[y * wordsPerRow + word] = ~level->obstacles.getRowWord(y, word) & onBoard;
+        }
+    }
+
+    // Take out occupied squares, and squares next to an open wire end of the same tag since
+    // drawWire would extend that wire instead.
+    for (Wire::Id id : level->wires) {
+        Wire* wire = level->wirePool.get(id);
+        unmark(open, wire->getX(), wire->getY());
+        if (!wire->isFullyConnected() && wire->getTag() == tag)
+            unmarkAround(open, wire->getX(), wire->getY());
+    }
+
+    // Take out squares where another port would start or end the chain.
+    for (Node* node : level->getNodes()) {
+        unmark(open, node->getX(), node->getY());
+        if (node == sourceNode || node == targetNode || node->getTag() != tag)
+            continue;
+        if (node->getNodeType() == Node::Type::ROOT && !node->getConnected())
+            markPort(open, node->getX(), node->getY(), node->getDirection(), false);
+        else if (node->getNodeType() == Node::Type::END && node->getSignal() == signal)
+            unmarkAround(open, node->getX(), node->getY());
+    }
+    for (Gate* gate : level->getGates()) {
+        int x = gate->getInputNode()->getX();
+        int y = gate->getInputNode()->getY();
+        unmark(open, x, y);
+        if (keepPortsClear && gate != sourceGate && gate->getOutputNode()
+            && !gate->getOutputNode()->getConnected())
+            markPort(open, x, y, gate->getOutputDirection(), false);
+        if (gate == sourceGate || gate == targetGate)
+            continue;
+        if (gate->getOutputNode() && gate->isFullyConnected() && gate->getTag() == tag)
+            markPort(open, x, y, gate->getOutputDirection(), false);
+        if (!gate->isFullyConnected())
+            markPort(open, x, y, gate->getInputDirection(), false);
+    }
+}
+
+int Router::search() {
+    // Each row keeps a mask of which blocks of words hold frontier bits, so a step only
+    // touches the words next to the frontier rather than the whole board.
+    int blockWords = (wordsPerRow + 63) / 64;
+    QVector<quint64> frontier(open.size(), 0);
+    QVector<quint64> next(open.size(), 0);
+    QVector<quint64> visited(open.size(), 0);
+    QVector<quint64> frontierBlocks(height, 0);
+    QVector<quint64> nextBlocks(height, 0);
+    distances.fill(-1, width * height);
+
+    int goal = -1;
+    auto reach = [&](int y, int word, quint64 bits, int step) {
+        int i = y * wordsPerRow + word;
+        visited[i] |= bits;
+        quint64 reachedGoals = bits & goals[i];
+        if (goal < 0 && reachedGoals)
+            goal = y * width + word * 64 + qCountTrailingZeroBits(reachedGoals);
+        while (bits) {
+            distances[y * width + word * 64 + qCountTrailingZeroBits(bits)] = step;
+            bits &= bits - 1;
+        }
+    };
+
+    int firstRow = height;
+    int lastRow = -1;
+    for (int y = 0; y < height; y++) {
+        for (int word = 0; word < wordsPerRow; word++) {
+            quint64 bits = starts[y * wordsPerRow + word] & open[y * wordsPerRow + word];
+            if (bits == 0)
+                continue;
+            frontier[y * wordsPerRow + word] = bits;
+            frontierBlocks[y] |= quint64(1) << (word / blockWords);
+            reach(y, word, bits, 0);
+            firstRow = qMin(firstRow, y);
+            lastRow = y;
+        }
+    }
+
+    for (int step = 1; goal < 0 && firstRow <= lastRow; step++) {
+        // Grow the frontier one square in every direction, a word at a time.
+        int nextFirstRow = height;
+        int nextLastRow = -1;
+        for (int y = qMax(0, firstRow - 1); y <= qMin(height - 1, lastRow + 1); y++) {
+            quint64 blocks = frontierBlocks[y];
+            if (y > 0)
+                blocks |= frontierBlocks[y - 1];
+            if (y < height - 1)
+                blocks |= frontierBlocks[y + 1];
+            blocks |= blocks << 1 | blocks >> 1;
+            while (blocks) {
+                int block = qCountTrailingZeroBits(blocks);
+                blocks &= blocks - 1;
+                int lastWord = qMin(wordsPerRow, (block + 1) * blockWords);
+                for (int word = block * blockWords; word < lastWord; word++) {
+                    int i = y * wordsPerRow + word;
+                    quint64 here = frontier[i];
+                    quint64 grown = here << 1 | here >> 1;
+                    if (word > 0)
+                        grown |= frontier[i - 1] >> 63;
+                    if (word < wordsPerRow - 1)
+                        grown |= frontier[i + 1] << 63;
+                    if (y > 0)
+                        grown |= frontier[i - wordsPerRow];
+                    if (y < height - 1)
+                        grown |= frontier[i + wordsPerRow];
+                    quint64 bits = grown & open[i] & ~visited[i];
+                    if (bits == 0)
+                        continue;
+                    next[i] = bits;
+                    nextBlocks[y] |= quint64(1) << block;
+                    reach(y, word, bits, step);
+                    nextFirstRow = qMin(nextFirstRow, y);
+                    nextLastRow = y;
+                }
+            }
+        }
+
+        // Wipe the old frontier so its buffer can hold the step after next.
+        for (int y = firstRow; y <= lastRow; y++) {
+            quint64 blocks = frontierBlocks[y];
+            while (blocks) {
+                int block = qCountTrailingZeroBits(blocks);
+                blocks &= blocks - 1;
+                int lastWord = qMin(wordsPerRow, (block + 1) * blockWords);
+                for (int word = block * blockWords; word < lastWord; word++)
+                    frontier[y * wordsPerRow + word] = 0;
+            }
+            frontierBlocks[y] = 0;
+        }
+        frontier.swap(next);
+        frontierBlocks.swap(nextBlocks);
+        firstRow = nextFirstRow;
+        lastRow = nextLastRow;
+    }
+    return goal;
+}
+
+void Router::mark(QVector<quint64>& board, int x, int y) {
+    if (x >= 0 && x < width && y >= 0 && y < height)
+        board[y * wordsPerRow + x / 64] |= quint64(1) << (x % 64);
+}
+
+void Router::unmark(QVector<quint64>& board, int x, int y) {
+    if (x >= 0 && x < width && y >= 0 && y < height)
+        board[y * wordsPerRow + x / 64] &= ~(quint64(1) << (x % 64));
+}
+
+void Router::unmarkAround(QVector<quint64>& board, int x, int y) {
+    unmark(board, x, y - 1);
+    unmark(board, x + 1, y);
+    unmark(board, x, y + 1);
+    unmark(board, x - 1, y);
+}
+
+void Router::markPort(QVector<quint64>& board, int x, int y, Node::Direction direction,
+                      bool value) {
+    auto apply = [&](int squareX, int squareY) {
+        if (value)
+            mark(board, squareX, squareY);
+        else
+            unmark(board, squareX, squareY);
+    };
+    switch (direction) {
+    case Node::Direction::N :
+        apply(x, y - 1);
+        break;
+    case Node::Direction::E :
+        apply(x + 1, y);
+        break;
+    case Node::Direction::S :
+        apply(x, y + 1);
+        break;
+    case Node::Direction::W :
+        apply(x - 1, y);
+        break;
+    case Node::Direction::NONE :
+        apply(x, y - 1);
+        apply(x + 1, y);
+        apply(x, y + 1);
+        apply(x - 1, y);
+        break;
+    }
+}
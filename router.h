@@ -0,0 +1,171 @@
+/**
+ * This class finds wire routes for a level. The board is flattened into
+ * bitboards, one bit per square packed into 64-bit words row by row, and
+ * a breadth-first search grows its frontier a whole word at a time by
+ * shifting rows left, right, up and down. The first port reached gives
+ * the shortest route that drawWire would connect square by square.
+ *
+ * @authors Max Donaldson, Jason Khong,
+ * Ariadne Petroulakis, Evan Tucker, and Ian Weller
+ *
+ * @version 22 April 2025
+ */
+
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include <QPoint>
+#include <QVector>
+#include "gate.h"
+#include "node.h"
+#include "tag.h"
+
+class Level;
+
+class Router {
+
+public:
+    /**
+     * @brief Router - Creates a router for a level.
+     * @param level - The level whose board is searched.
+     */
+    explicit Router(Level* level);
+
+    /**
+     * @brief findRoute - Finds the shortest wire route from an output port to an input port.
+     * Squares next to any other port or open wire end that drawWire would connect to are
+     * avoided, so placing the route square by square connects exactly the two ports given.
+     * @param sourceX - X position of a ROOT node, either half of a gate, or a fully connected
+     * wire with a free branch for the route to fan out of.
+     * @param sourceY - Y position of the source.
+     * @param targetX - X position of an END node or a gate half with an open input.
+     * @param targetY - Y position of the target.
+     * @param tag - The tag of the wire. It must match the source and, for END nodes, the target.
+     * @param route - Receives the squares to draw, starting next to the source.
+     * @return False if either port can't be wired or no route exists.
+     */
+    bool findRoute(int sourceX, int sourceY, int targetX, int targetY, Tag tag,
+                   QVector<QPoint>& route);
+
+    /**
+     * @brief setKeepPortsClear - Sets whether routes also stay off the squares in front of
+     * gate ports that aren't wired yet, whatever their tag, so a circuit can be wired one
+     * route at a time without walling in a gate. Off by default.
+     * @param keepClear - True to keep unwired gate ports clear.
+     */
+    void setKeepPortsClear(bool keepClear);
+
+private:
+    /**
+     * @brief level - The level being routed.
+     */
+    Level* level;
+
+    /**
+     * @brief width - The board width of the last search.
+     */
+    int width;
+
+    /**
+     * @brief height - The board height of the last search.
+     */
+    int height;
+
+    /**
+     * @brief wordsPerRow - The number of 64-bit words holding one row of a bitboard.
+     */
+    int wordsPerRow;
+
+    /**
+     * @brief keepPortsClear - Whether routes stay off the squares in front of unwired gate ports.
+     */
+    bool keepPortsClear;
+
+    /**
+     * @brief open - The squares a route may pass through.
+     */
+    QVector<quint64> open;
+
+    /**
+     * @brief starts - The squares a route may begin on.
+     */
+    QVector<quint64> starts;
+
+    /**
+     * @brief goals - The squares a route may end on.
+     */
+    QVector<quint64> goals;
+
+    /**
+     * @brief distances - The search step each reached square was found on, or -1.
+     */
+    QVector<int> distances;
+
+    /**
+     * @brief resize - Sizes every bitboard to the level and clears them.
+     */
+    void resize();
+
+    /**
+     * @brief buildOpen - Marks the empty squares that no foreign port or wire end would
+     * connect to.
+     * @param tag - The tag of the route.
+     * @param signal - The signal the route carries.
+     * @param sourceNode - The ROOT node the route starts from, or nullptr.
+     * @param sourceGate - The gate output half the route starts from, or nullptr.
+     * @param targetNode - The END node the route ends at, or nullptr.
+     * @param targetGate - The gate half the route ends at, or nullptr.
+     */
+    void buildOpen(Tag tag, const Bus& signal, Node* sourceNode, Gate* sourceGate, Node* targetNode,
+                   Gate* targetGate);
+
+    /**
+     * @brief markBranches - Marks the start squares of a route branching off a wire: the empty
+     * squares next to it that placeWire would connect to it.
+     * @param sourceWire - The wire to branch off.
+     * @param tag - The tag of the route.
+     */
+    void markBranches(Wire* sourceWire, Tag tag);
+
+    /**
+     * @brief search - Runs the breadth-first search from starts until a goal is reached.
+     * @return The index of the goal square reached, or -1.
+     */
+    int search();
+
+    /**
+     * @brief mark - Sets the bit of a square, ignoring squares off the board.
+     * @param board - The bitboard to change.
+     * @param x - X position of the square.
+     * @param y - Y position of the square.
+     */
+    void mark(QVector<quint64>& board, int x, int y);
+
+    /**
+     * @brief unmark - Clears the bit of a square, ignoring squares off the board.
+     * @param board - The bitboard to change.
+     * @param x - X position of the square.
+     * @param y - Y position of the square.
+     */
+    void unmark(QVector<quint64>& board, int x, int y);
+
+    /**
+     * @brief unmarkAround - Clears the bits of the four squares next to a square.
+     * @param board - The bitboard to change.
+     * @param x - X position of the center square.
+     * @param y - Y position of the center square.
+     */
+    void unmarkAround(QVector<quint64>& board, int x, int y);
+
+    /**
+     * @brief markPort - Sets the square a port faces, or all four neighbors if it faces any way.
+     * @param board - The bitboard to change.
+     * @param x - X position of the port.
+     * @param y - Y position of the port.
+     * @param direction - The way the port faces.
+     * @param value - True to set the bits, false to clear them.
+     */
+    void markPort(QVector<quint64>& board, int x, int y, Node::Direction direction, bool value);
+};
+
+#endif // ROUTER_H
@@ -0,0 +1,226 @@
+#include "simulator.h"
+#include "gatekernels.h"
+#include "level.h"
+#include <QHash>
+
+static_assert(Simulator::WHEEL_SIZE > Gate::MAX_DELAY, "events must not wrap onto the running tick");
+
+Simulator::Simulator()
+    : wheel(WHEEL_SIZE), time(0), eventCount(0), pendingEvents(0) {
+}
+
+void Simulator::compile(Level* level) {
+    inputTags.clear();
+    inputSignals.clear();
+    inputNets.clear();
+    outputNets.clear();
+    expectedSignals.clear();
+    elements.clear();
+
+    // Every driver gets a net: the constant, each ROOT node, then each gate output.
+    int netCount = 1;
+    QHash<Wire*, int> drivers;
+    QVector<Node*> ends;
+    for (Node* node : level->getNodes()) {
+        if (node->getNodeType() != Node::Type::ROOT) {
+            ends.append(node);
+            continue;
+        }
+        inputTags.append(node->getTag());
+        inputSignals.append(node->getSignal());
+        inputNets.append(netCount);
+        drivers.insert(node->getWire(), netCount++);
+    }
+    QVector<Gate*> outputHalves;
+    for (Gate* gate : level->getGates()) {
+        if (gate->getOutputNode()) {
+            outputHalves.append(gate);
+            drivers.insert(gate->getOutputNode()->getWire(), netCount++);
+        }
+    }
+
+    // A sink reads whatever drives the head of its chain.
+    auto sinkNet = [&](Wire* sinkWire) {
+        Wire* currentWire = sinkWire;
+        while (currentWire && currentWire->getHeadConnection() != currentWire)
+            currentWire = currentWire->getHeadConnection();
+        return currentWire ? drivers.value(currentWire, int(CONSTANT_FALSE)) : int(CONSTANT_FALSE);
+    };
+    for (Gate* gate : outputHalves) {
+        Element element;
+        element.op = gate->getOperator();
+        element.live = gate->canDrive();
+        element.timed = GateKernels::isTimed(element.op);
+        element.ticking = false;
+        element.delay = gate->getDelay();
+        element.first = sinkNet(gate->getInputNode()->getWire());
+        element.second = gate->getOtherHalf()
+                             ? sinkNet(gate->getOtherHalf()->getInputNode()->getWire())
+                             : element.first;
+        element.output = drivers.value(gate->getOutputNode()->getWire());
+        elements.append(element);
+    }
+    for (Node* end : ends) {
+        outputNets.append(sinkNet(end->getWire()));
+        expectedSignals.append(end->getSignal());
+    }
+
+    // Readers are grouped by net so a change visits them in one contiguous run.
+    readerStarts.fill(0, netCount + 1);
+    auto forEachRead = [&](const std::function<void(int, int)>& visit) {
+        for (int i = 0; i < elements.size(); i++) {
+            const Element& element = elements[i];
+            visit(element.first, i);
+            if (element.second != element.first)
+                visit(element.second, i);
+            if (element.timed)
+                visit(element.output, i);
+        }
+    };
+    forEachRead([&](int net, int) { readerStarts[net + 1]++; });
+    for (int net = 0; net < netCount; net++)
+        readerStarts[net + 1] += readerStarts[net];
+    readers.fill(0, readerStarts[netCount]);
+    QVector<int> filled = readerStarts;
+    forEachRead([&](int net, int index) { readers[filled[net]++] = index; });
+
+    values.fill(Bus(), netCount);
+    reset();
+}
+
+void Simulator::reset() {
+    for (std::vector<Event>& slot : wheel)
+        slot.clear();
+    time = 0;
+    eventCount = 0;
+    pendingEvents = 0;
+    values.fill(Bus());
+    for (int i = 0; i < inputNets.size(); i++)
+        values[inputNets[i]] = inputSignals[i];
+    for (Element& element : elements) {
+        element.state = Bus();
+        element.lastControl = Bus();
+        element.scheduled = Bus();
+        element.ticking = false;
+    }
+    for (int i = 0; i < elements.size(); i++)
+        step(i, true);
+}
+
+void Simulator::setInput(int input, const Bus& value) {
+    schedule(inputNets[input], value, 0);
+}
+
+void Simulator::advance(qint64 ticks) {
+    qint64 end = time + ticks;
+    while (time < end && pendingEvents > 0) {
+        // Gates schedule at least one tick ahead, so this slot only shrinks by being run.
+        std::vector<Event>& slot = wheel[time % WHEEL_SIZE];
+        for (std::size_t i = 0; i < slot.size(); i++)
+            apply(slot[i]);
+        pendingEvents -= qint64(slot.size());
+        eventCount += qint64(slot.size());
+        slot.clear();
+        time++;
+    }
+    time = qMax(time, end);
+}
+
+int Simulator::run(int steps, qint64 ticksPerStep, const std::function<bool(int)>& sample) {
+    for (int i = 0; i < steps; i++) {
+        advance(ticksPerStep);
+        if (!sample(i))
+            return i + 1;
+    }
+    return steps;
+}
+
+qint64 Simulator::getTime() const {
+    return time;
+}
+
+qint64 Simulator::getEventCount() const {
+    return eventCount;
+}
+
+qint64 Simulator::getPendingEventCount() const {
+    return pendingEvents;
+}
+
+int Simulator::getInputCount() const {
+    return inputTags.size();
+}
+
+Tag Simulator::getInputTag(int input) const {
+    return inputTags[input];
+}
+
+int Simulator::getOutputCount() const {
+    return outputNets.size();
+}
+
+Bus Simulator::getOutput(int output) const {
+    return values[outputNets[output]];
+}
+
+Bus Simulator::getExpected(int output) const {
+    return expectedSignals[output];
+}
+
+int Simulator::getGateCount() const {
+    return elements.size();
+}
+
+Bus Simulator::getGateOutput(int gate) const {
+    return values[elements[gate].output];
+}
+
+bool Simulator::outputsMatch() const {
+    for (int i = 0; i < outputNets.size(); i++) {
+        if (values[outputNets[i]] != expectedSignals[i])
+            return false;
+    }
+    return true;
+}
+
+void Simulator::schedule(int net, const Bus& value, int delay) {
+    wheel[(time + delay) % WHEEL_SIZE].push_back({net, value});
+    pendingEvents++;
+}
+
+void Simulator::apply(const Event& event) {
+    if (values[event.net] == event.value)
+        return;
+    values[event.net] = event.value;
+    for (int i = readerStarts[event.net]; i < readerStarts[event.net + 1]; i++) {
+        int index = readers[i];
+        step(index, elements[index].output == event.net);
+    }
+}
+
+void Simulator::step(int index, bool timerFired) {
+    Element& element = elements[index];
+    if (!element.live)
+        return;
+    const Bus& first = values[element.first];
+    const Bus& second = values[element.second];
+
+    // A running clock ignores its enable until its timer fires.
+    if (element.timed) {
+        if (!timerFired && element.ticking)
+            return;
+        Bus before = element.state;
+        GateKernels::step(element.op, first, second, element.state, element.lastControl);
+        element.ticking = element.state != before;
+        if (element.ticking)
+            schedule(element.output, element.state, element.delay);
+        return;
+    }
+
+    // The last value scheduled is where the net ends up, so repeating it adds nothing.
+    Bus output = GateKernels::step(element.op, first, second, element.state, element.lastControl);
+    if (output == element.scheduled)
+        return;
+    element.scheduled = output;
+    schedule(element.output, output, element.delay);
+}
@@ -0,0 +1,274 @@
+/**
+ * This class runs a level's circuit over time, headless. The wiring is
+ * compiled into flat arrays of nets and gates, and signal changes are
+ * events on a timing wheel: each event sets a net at a tick, and every
+ * gate reading that net is stepped and schedules its output after its
+ * own propagation delay. Clocks toggle on their own timer, flip-flops
+ * capture on rising clock edges and latches follow D while enabled, so
+ * counters and state machines can be run for thousands of cycles when a
+ * solution is validated. Events at the same tick run in the order they
+ * were scheduled and gates are visited in placement order, so every run
+ * is deterministic.
+ *
+ * @authors Max Donaldson, Jason Khong,
+ * Ariadne Petroulakis, Evan Tucker, and Ian Weller
+ *
+ * @version 22 April 2025
+ */
+
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <QVector>
+#include <functional>
+#include <vector>
+#include "bus.h"
+#include "gate.h"
+#include "tag.h"
+
+class Level;
+
+class Simulator {
+
+public:
+    /**
+     * @brief WHEEL_SIZE - The number of ticks the timing wheel holds. It is longer than any gate
+     * delay, so an event never wraps onto a slot still being run.
+     */
+    static const int WHEEL_SIZE = 256;
+
+    /**
+     * @brief Simulator - Creates a simulator with no circuit.
+     */
+    Simulator();
+
+    /**
+     * @brief compile - Rebuilds the circuit from the current wiring of a level and resets it.
+     * Inputs are the ROOT nodes and outputs the END nodes, both in placement order. Gates that
+     * can't drive output false, like on the board. Loops are allowed; they are cut
+     * by the gate delays.
+     * @param level - The level to compile.
+     */
+    void compile(Level* level);
+
+    /**
+     * @brief reset - Goes back to tick 0: every gate state is cleared, the inputs take their
+     * ROOT signals, and each gate is stepped once so its output and any clock get scheduled.
+     */
+    void reset();
+
+    /**
+     * @brief setInput - Changes an input at the current tick.
+     * @param input - The input index.
+     * @param value - The new signal.
+     */
+    void setInput(int input, const Bus& value);
+
+    /**
+     * @brief advance - Runs every event before the given number of ticks from now.
+     * @param ticks - How far to move time.
+     */
+    void advance(qint64 ticks);
+
+    /**
+     * @brief run - Advances in steps and samples the circuit after each one, e.g. once per clock
+     * cycle.
+     * @param steps - The number of steps.
+     * @param ticksPerStep - The ticks per step.
+     * @param sample - Called after each step with the step index. Returning false stops the run.
+     * @return The number of steps run.
+     */
+    int run(int steps, qint64 ticksPerStep, const std::function<bool(int)>& sample);
+
+    /**
+     * @brief getTime - Getter for the current tick.
+     * @return The tick.
+     */
+    qint64 getTime() const;
+
+    /**
+     * @brief getEventCount - Getter for the number of events run since the last reset.
+     * @return The event count.
+     */
+    qint64 getEventCount() const;
+
+    /**
+     * @brief getPendingEventCount - Getter for the number of events waiting on the wheel.
+     * @return The event count. Zero once the circuit has settled and no clock is running.
+     */
+    qint64 getPendingEventCount() const;
+
+    /**
+     * @brief getInputCount - Getter for the number of inputs.
+     * @return The number of ROOT nodes compiled.
+     */
+    int getInputCount() const;
+
+    /**
+     * @brief getInputTag - Getter for the tag of an input.
+     * @param input - The input index.
+     * @return The tag of the ROOT node.
+     */
+    Tag getInputTag(int input) const;
+
+    /**
+     * @brief getOutputCount - Getter for the number of outputs.
+     * @return The number of END nodes compiled.
+     */
+    int getOutputCount() const;
+
+    /**
+     * @brief getOutput - Gets the signal an END node is currently receiving.
+     * @param output - The output index.
+     * @return The signal. Unconnected outputs read false.
+     */
+    Bus getOutput(int output) const;
+
+    /**
+     * @brief getExpected - Getter for the signal an END node expects.
+     * @param output - The output index.
+     * @return The END node's signal.
+     */
+    Bus getExpected(int output) const;
+
+    /**
+     * @brief getGateCount - Getter for the number of gates.
+     * @return The number of gates, counting two-square gates once.
+     */
+    int getGateCount() const;
+
+    /**
+     * @brief getGateOutput - Gets the signal a gate is currently outputting, e.g. the state of a
+     * flip-flop whose output only feeds back into the circuit.
+     * @param gate - The gate index, in the placement order of the halves holding the outputs.
+     * @return The signal.
+     */
+    Bus getGateOutput(int gate) const;
+
+    /**
+     * @brief outputsMatch - Checks whether every END node currently receives its whole expected
+     * vector.
+     * @return True if all outputs match.
+     */
+    bool outputsMatch() const;
+
+private:
+    /**
+     * @brief The Element struct - One gate, read from its output half.
+     */
+    struct Element {
+        Gate::Operator op;
+        bool live;
+        bool timed;
+        bool ticking;
+        int delay;
+        int first;
+        int second;
+        int output;
+        Bus state;
+        Bus lastControl;
+        Bus scheduled;
+    };
+
+    /**
+     * @brief The Event struct - A net taking a new value.
+     */
+    struct Event {
+        int net;
+        Bus value;
+    };
+
+    /**
+     * @brief CONSTANT_FALSE - The net that always reads false, driving unconnected inputs.
+     */
+    static const int CONSTANT_FALSE = 0;
+
+    /**
+     * @brief inputTags - The tag of each input.
+     */
+    QVector<Tag> inputTags;
+
+    /**
+     * @brief inputSignals - The ROOT signal of each input, applied on reset.
+     */
+    QVector<Bus> inputSignals;
+
+    /**
+     * @brief inputNets - The net each input drives.
+     */
+    QVector<int> inputNets;
+
+    /**
+     * @brief outputNets - The net each output reads.
+     */
+    QVector<int> outputNets;
+
+    /**
+     * @brief expectedSignals - The signal each END node expects.
+     */
+    QVector<Bus> expectedSignals;
+
+    /**
+     * @brief elements - The gates, in placement order.
+     */
+    QVector<Element> elements;
+
+    /**
+     * @brief readerStarts - Where each net's readers start in readers. One more entry than nets.
+     */
+    QVector<int> readerStarts;
+
+    /**
+     * @brief readers - The elements reading each net, grouped by net. A clock also reads its own
+     * output, which is its timer.
+     */
+    QVector<int> readers;
+
+    /**
+     * @brief values - The current value of each net.
+     */
+    QVector<Bus> values;
+
+    /**
+     * @brief wheel - One list of events per tick, indexed by tick modulo WHEEL_SIZE.
+     */
+    std::vector<std::vector<Event>> wheel;
+
+    /**
+     * @brief time - The current tick.
+     */
+    qint64 time;
+
+    /**
+     * @brief eventCount - Events run since the last reset.
+     */
+    qint64 eventCount;
+
+    /**
+     * @brief pendingEvents - Events on the wheel.
+     */
+    qint64 pendingEvents;
+
+    /**
+     * @brief schedule - Puts an event on the wheel.
+     * @param net - The net to set.
+     * @param value - Its new value.
+     * @param delay - The ticks from now, below WHEEL_SIZE.
+     */
+    void schedule(int net, const Bus& value, int delay);
+
+    /**
+     * @brief apply - Runs an event, stepping the readers of the net if its value changed.
+     * @param event - The event.
+     */
+    void apply(const Event& event);
+
+    /**
+     * @brief step - Steps one gate on its current inputs and schedules its output.
+     * @param index - The element index.
+     * @param timerFired - Whether a clock's own output just changed.
+     */
+    void step(int index, bool timerFired);
+};
+
+#endif // SIMULATOR_H
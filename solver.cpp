@@ -0,0 +1,564 @@
+#include "solver.h"
+#include "gatekernels.h"
+#include "level.h"
+#include <QElapsedTimer>
+#include <algorithm>
+#include <thread>
+
+Solver::Solver(Level* layout)
+    : layout(layout), threadCount(qMax(1u, std::thread::hardware_concurrency())), nodeLimit(0),
+    status(Status::UNSOLVABLE), branching(false), elapsedMs(0), pendingTasks(0), idleWorkers(0),
+    totalNodes(0), stopping(false), limitReached(false), solved(false) {
+}
+
+Solver::~Solver() {
+}
+
+void Solver::setThreadCount(int count) {
+    threadCount = qMax(1, count);
+}
+
+void Solver::setNodeLimit(qint64 limit) {
+    nodeLimit = limit;
+}
+
+Solver::Status Solver::solve() {
+    QElapsedTimer timer;
+    timer.start();
+
+    // Every thread searches its own copy of the layout.
+    workers.clear();
+    for (int i = 0; i < threadCount; i++) {
+        std::unique_ptr<Worker> worker(new Worker);
+        worker->level.reset(new Level(nullptr, nullptr, nullptr, layout->getWidth(),
+                                      layout->getHeight()));
+        worker->level->copyLayout(layout);
+        workers.push_back(std::move(worker));
+    }
+    solution.clear();
+    solved = false;
+    stopping = false;
+    limitReached = false;
+    totalNodes = 0;
+    idleWorkers = 0;
+
+    // Branching off finished chains multiplies the drawings to search, so it is only tried
+    // once every drawing without it has been ruled out.
+    for (bool pass : {false, true}) {
+        branching = pass;
+        for (int i = 0; i < SHARDS; i++)
+            seenStates[i].clear();
+
+        // The whole search starts as one branch with no moves.
+        workers[0]->tasks.push_back(QVector<Move>());
+        pendingTasks = 1;
+        std::vector<std::thread> threads;
+        for (int i = 1; i < threadCount; i++)
+            threads.emplace_back(&Solver::run, this, i);
+        run(0);
+        for (std::thread& thread : threads)
+            thread.join();
+        if (stopping)
+            break;
+    }
+
+    if (solved)
+        status = Status::SOLVED;
+    else if (limitReached)
+        status = Status::ABORTED;
+    else
+        status = Status::UNSOLVABLE;
+    elapsedMs = timer.elapsed();
+    return status;
+}
+
+Solver::Status Solver::getStatus() const {
+    return status;
+}
+
+QVector<Solver::Move> Solver::getSolution() const {
+    return solution;
+}
+
+qint64 Solver::getNodesVisited() const {
+    qint64 total = 0;
+    for (const std::unique_ptr<Worker>& worker : workers)
+        total += worker->nodesVisited;
+    return total;
+}
+
+qint64 Solver::getNodesPruned() const {
+    qint64 total = 0;
+    for (const std::unique_ptr<Worker>& worker : workers)
+        total += worker->nodesPruned;
+    return total;
+}
+
+qint64 Solver::getRepeatedStates() const {
+    qint64 total = 0;
+    for (const std::unique_ptr<Worker>& worker : workers)
+        total += worker->repeatedStates;
+    return total;
+}
+
+qint64 Solver::getSteals() const {
+    qint64 total = 0;
+    for (const std::unique_ptr<Worker>& worker : workers)
+        total += worker->steals;
+    return total;
+}
+
+int Solver::getThreadCount() const {
+    return threadCount;
+}
+
+qint64 Solver::getElapsedMs() const {
+    return elapsedMs;
+}
+
+void Solver::run(int index) {
+    Worker& worker = *workers[index];
+    Level* level = worker.level.get();
+    QVector<Move> task;
+    bool idle = false;
+    while (true) {
+        if (takeTask(index, task)) {
+            if (idle) {
+                idleWorkers--;
+                idle = false;
+            }
+            if (!stopping) {
+                // Rewind to the empty layout and replay the moves leading to the branch.
+                while (level->canUndo())
+                    level->undo();
+                Chain chain = {false, 0, 0};
+                bool replayed = true;
+                for (const Move& move : task) {
+                    if (!tryMove(level, move, chain)) {
+                        replayed = false;
+                        break;
+                    }
+                }
+                if (replayed)
+                    search(worker, task, chain);
+            }
+            if (--pendingTasks == 0)
+                workAvailable.notify_all();
+            continue;
+        }
+        if (pendingTasks == 0)
+            break;
+        if (!idle) {
+            idleWorkers++;
+            idle = true;
+        }
+
+        // Sleep until a branch is queued. The timeout covers a wake-up sent between the
+        // failed steal and the wait.
+        std::unique_lock<std::mutex> guard(idleLock);
+        workAvailable.wait_for(guard, std::chrono::milliseconds(1));
+    }
+    if (idle)
+        idleWorkers--;
+}
+
+bool Solver::takeTask(int index, QVector<Move>& task) {
+    {
+        Worker& worker = *workers[index];
+        std::lock_guard<std::mutex> guard(worker.lock);
+        if (!worker.tasks.empty()) {
+            task = worker.tasks.back();
+            worker.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Steal the oldest branch of another thread: it is the closest to the root, so it is
+    // likely the largest piece of work.
+    for (int i = 1; i < threadCount; i++) {
+        Worker& victim = *workers[(index + i) % threadCount];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            workers[index]->steals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Solver::search(Worker& worker, QVector<Move>& path, Chain chain) {
+    if (stopping)
+        return false;
+    Level* level = worker.level.get();
+    worker.nodesVisited++;
+    if (nodeLimit > 0 && ++totalNodes > nodeLimit) {
+        limitReached = true;
+        stopping = true;
+        return false;
+    }
+
+    if (isSolved(level)) {
+        std::lock_guard<std::mutex> guard(solutionLock);
+        if (!solved) {
+            solved = true;
+            solution = path;
+        }
+        stopping = true;
+        return true;
+    }
+    BoardKey key;
+    keyBoard(worker, key);
+    if (!markSeen(std::move(key))) {
+        worker.repeatedStates++;
+        return false;
+    }
+    if (isHopeless(worker, chain, branching)) {
+        worker.nodesPruned++;
+        return false;
+    }
+
+    QVector<Move> moves;
+    listMoves(level, chain, branching, moves);
+
+    // Queue the other branches where idle threads can steal them. They are counted before any
+    // can be stolen, so a thief finishing one can't bring the count to zero early.
+    if (moves.size() > 1 && idleWorkers > 0) {
+        std::lock_guard<std::mutex> guard(worker.lock);
+        pendingTasks += moves.size() - 1;
+        for (int i = 1; i < moves.size(); i++) {
+            QVector<Move> task = path;
+            task.append(moves[i]);
+            worker.tasks.push_back(task);
+        }
+        moves.resize(1);
+        workAvailable.notify_all();
+    }
+
+    for (const Move& move : moves) {
+        Chain next = chain;
+        if (!tryMove(level, move, next))
+            continue;
+        path.append(move);
+        if (search(worker, path, next))
+            return true;
+        path.removeLast();
+        level->undo();
+        if (stopping)
+            return false;
+    }
+    return false;
+}
+
+void Solver::listMoves(Level* level, Chain chain, bool branching, QVector<Move>& moves) {
+    moves.clear();
+    QVector<QPoint> squares;
+    if (chain.open) {
+        Tag tag = level->getWire(chain.x, chain.y)->getTag();
+        portSquares(level, chain.x, chain.y, Node::Direction::NONE, squares);
+        for (const QPoint& square : squares)
+            moves.append({square.x(), square.y(), tag});
+        return;
+    }
+
+    // Start a new chain from any output that is still free.
+    for (Node* node : level->getNodes()) {
+        if (node->getNodeType() != Node::Type::ROOT || node->getConnected())
+            continue;
+        portSquares(level, node->getX(), node->getY(), node->getDirection(), squares);
+        for (const QPoint& square : squares)
+            moves.append({square.x(), square.y(), node->getTag()});
+    }
+    for (Gate* gate : level->getGates()) {
+        Node* output = gate->getOutputNode();
+        if (output == nullptr || !gate->canDrive() || output->getConnected())
+            continue;
+        portSquares(level, output->getX(), output->getY(), output->getDirection(), squares);
+        for (const QPoint& square : squares)
+            moves.append({square.x(), square.y(), gate->getTag()});
+    }
+
+    // Or fan out of a finished chain, which is the only way one output feeds several inputs.
+    if (!branching)
+        return;
+    QVector<Wire*> junctions;
+    listJunctions(level, junctions);
+    for (Wire* wire : junctions) {
+        portSquares(level, wire->getX(), wire->getY(), Node::Direction::NONE, squares);
+        for (const QPoint& square : squares)
+            moves.append({square.x(), square.y(), wire->getTag()});
+    }
+}
+
+bool Solver::tryMove(Level* level, const Move& move, Chain& chain) {
+    Wire* endWire = chain.open ? level->getWire(chain.x, chain.y) : nullptr;
+
+    // Inputs next to the square that are already wired must not be taken over.
+    QVector<Wire*> wiredInputs;
+    static const int offsetX[4] = {0, 1, 0, -1};
+    static const int offsetY[4] = {-1, 0, 1, 0};
+    for (int i = 0; i < 4; i++) {
+        int x = move.x + offsetX[i];
+        int y = move.y + offsetY[i];
+        Node* node = level->getNode(x, y);
+        Gate* gate = level->getGate(x, y);
+        if (node && node->getNodeType() == Node::Type::END && node->getConnected())
+            wiredInputs.append(node->getWire());
+        else if (gate && gate->getInputNode()->getConnected())
+            wiredInputs.append(gate->getInputNode()->getWire());
+    }
+
+    if (!level->isEmptySpace(move.x, move.y))
+        return false;
+    level->drawWire(move.x, move.y, move.tag);
+    Wire* wire = level->getWire(move.x, move.y);
+    if (wire == nullptr)
+        return false;
+    if ((endWire && wire->getHeadConnection() != endWire)
+        || wiredInputs.contains(wire->getTailConnection())) {
+        level->undo();
+        return false;
+    }
+    chain = {wire->getTailConnection() == nullptr, move.x, move.y};
+    return true;
+}
+
+bool Solver::isHopeless(Worker& worker, Chain chain, bool branching) {
+    Level* level = worker.level.get();
+    int width = level->getWidth();
+    int height = level->getHeight();
+    QVector<Node*> nodes = level->getNodes();
+    QVector<Gate*> gates = level->getGates();
+    QVector<QPoint> squares;
+
+    // Flood the empty squares from every output that can still start a chain. A square is
+    // reached when its mark holds this call's stamp, so the marks are only cleared when the
+    // stamp wraps around.
+    QVector<quint32>& marks = worker.floodMarks;
+    if (marks.size() != width * height || ++worker.floodStamp == 0) {
+        marks.fill(0, width * height);
+        worker.floodStamp = 1;
+    }
+    quint32 stamp = worker.floodStamp;
+    QVector<QPoint>& queue = worker.floodQueue;
+    queue.clear();
+    int flooded = 0;
+    auto reached = [&](const QPoint& square) {
+        return marks[square.y() * width + square.x()] == stamp;
+    };
+    auto seed = [&](const QPoint& square) {
+        if (!reached(square)) {
+            marks[square.y() * width + square.x()] = stamp;
+            queue.append(square);
+        }
+    };
+    auto flood = [&]() {
+        for (; flooded < queue.size(); flooded++) {
+            QPoint square = queue[flooded];
+            portSquares(level, square.x(), square.y(), Node::Direction::NONE, squares);
+            for (const QPoint& square : squares)
+                seed(square);
+        }
+    };
+
+    Tag chainTag;
+    Bus chainSignal;
+    if (chain.open) {
+        Wire* endWire = level->getWire(chain.x, chain.y);
+        chainTag = endWire->getTag();
+        chainSignal = endWire->getSignal();
+        portSquares(level, chain.x, chain.y, Node::Direction::NONE, squares);
+        for (const QPoint& square : squares)
+            seed(square);
+        flood();
+
+        // The open chain needs something it can plug into.
+        bool pluggable = false;
+        for (Node* node : nodes) {
+            if (node->getNodeType() != Node::Type::END || node->getConnected()
+                || node->getTag() != chainTag || node->getSignal() != chainSignal)
+                continue;
+            portSquares(level, node->getX(), node->getY(), Node::Direction::NONE, squares);
+            for (const QPoint& square : squares)
+                pluggable = pluggable || reached(square);
+        }
+        for (Gate* gate : gates) {
+            Node* input = gate->getInputNode();
+            if (input->getConnected())
+                continue;
+            portSquares(level, input->getX(), input->getY(), input->getDirection(), squares);
+            for (const QPoint& square : squares)
+                pluggable = pluggable || reached(square);
+        }
+        if (!pluggable)
+            return true;
+    }
+
+    // Every ROOT node still has to be wired out.
+    bool gatesPending = false;
+    for (Node* node : nodes) {
+        if (node->getNodeType() != Node::Type::ROOT || node->getConnected())
+            continue;
+        portSquares(level, node->getX(), node->getY(), node->getDirection(), squares);
+        if (squares.isEmpty())
+            return true;
+        for (const QPoint& square : squares)
+            seed(square);
+    }
+    for (Gate* gate : gates) {
+        Node* output = gate->getOutputNode();
+        if (output == nullptr || output->getConnected())
+            continue;
+
+        // A gate that can't drive yet, or a sequential one that drives before its data input
+        // is wired, may still turn into a source for any END node.
+        if (!gate->canDrive() || !gate->isFullyConnected())
+            gatesPending = true;
+        portSquares(level, output->getX(), output->getY(), output->getDirection(), squares);
+        for (const QPoint& square : squares)
+            seed(square);
+    }
+    QVector<Wire*> junctions;
+    if (branching)
+        listJunctions(level, junctions);
+    for (Wire* wire : junctions) {
+        portSquares(level, wire->getX(), wire->getY(), Node::Direction::NONE, squares);
+        for (const QPoint& square : squares)
+            seed(square);
+    }
+    flood();
+
+    for (Node* end : nodes) {
+        if (end->getNodeType() != Node::Type::END || end->getConnected())
+            continue;
+
+        // Every END node still has to be reachable...
+        bool reachable = false;
+        portSquares(level, end->getX(), end->getY(), Node::Direction::NONE, squares);
+        for (const QPoint& square : squares)
+            reachable = reachable || reached(square);
+        if (!reachable)
+            return true;
+
+        // ...and have enough sources left with its tag and signal, unless an unfinished gate
+        // could still make one. While branching, a single source feeds any number of them.
+        if (gatesPending)
+            continue;
+        int needed = 0;
+        int sources = chain.open && chainTag == end->getTag() && chainSignal == end->getSignal();
+        for (Wire* wire : junctions) {
+            if (wire->getTag() == end->getTag() && wire->getSignal() == end->getSignal())
+                sources++;
+        }
+        for (Node* node : nodes) {
+            if (node->getTag() != end->getTag() || node->getSignal() != end->getSignal()
+                || node->getConnected())
+                continue;
+            if (node->getNodeType() == Node::Type::END)
+                needed++;
+            else
+                sources++;
+        }
+        for (Gate* gate : gates) {
+            Node* output = gate->getOutputNode();
+            if (output && !output->getConnected() && gate->canDrive()
+                && gate->getTag() == end->getTag() && output->getSignal() == end->getSignal())
+                sources++;
+        }
+        if (branching ? sources == 0 : needed > sources)
+            return true;
+    }
+    return false;
+}
+
+bool Solver::isSolved(Level* level) {
+    for (Node* node : level->getNodes()) {
+        if (!node->getConnected())
+            return false;
+    }
+    return true;
+}
+
+void Solver::keyBoard(Worker& worker, BoardKey& key) {
+    // Each wire is one record of its square and shape, then its tag. The square comes first
+    // and no two wires share one, so sorting by the first word puts the records in an order
+    // that doesn't depend on the order the wires were drawn in.
+    Level* level = worker.level.get();
+    QVector<QPair<quint64, Wire*>>& records = worker.boardRecords;
+    records.clear();
+    for (Wire::Id id : level->wires) {
+        Wire* wire = level->wirePool.get(id);
+        quint64 square = quint64(wire->getY()) * level->getWidth() + wire->getX();
+        records.append({(square << 8) | (quint64(wire->getBranchCount()) << 5)
+                            | (quint64(wire->getDirection()) << 1)
+                            | (wire->getTailConnection() == nullptr), wire});
+    }
+    std::sort(records.begin(), records.end(),
+              [](const QPair<quint64, Wire*>& first, const QPair<quint64, Wire*>& second) {
+        return first.first < second.first;
+    });
+
+    key.hash = 0;
+    key.words.clear();
+    key.words.reserve(records.size() * (1 + Tag::WORDS));
+    for (const QPair<quint64, Wire*>& record : records) {
+        key.words.append(record.first);
+        for (int i = 0; i < Tag::WORDS; i++)
+            key.words.append(record.second->getTag().getWord(i));
+    }
+
+    // Flip-flops, latches and clocks remember earlier inputs, so the same wires can leave
+    // them in different states. Gates are in the same order on every copy of the layout.
+    for (Gate* gate : level->getGates()) {
+        if (gate->getOutputNode() == nullptr || !GateKernels::isStateful(gate->getOperator()))
+            continue;
+        for (const Bus& value : {gate->getState(), gate->getLastControl()}) {
+            key.words.append(quint64(value.getWidth()));
+            for (int i = 0; i * 64 < value.getWidth(); i++)
+                key.words.append(value.getWord(i));
+        }
+    }
+    for (quint64 word : key.words) {
+        quint64 mixed = (key.hash + word) * 0x9E3779B97F4A7C15ull;
+        mixed ^= mixed >> 30;
+        mixed *= 0xBF58476D1CE4E5B9ull;
+        mixed ^= mixed >> 27;
+        key.hash = mixed;
+    }
+}
+
+void Solver::portSquares(Level* level, int x, int y, Node::Direction direction,
+                         QVector<QPoint>& squares) {
+    static const int offsetX[4] = {0, 1, 0, -1};
+    static const int offsetY[4] = {-1, 0, 1, 0};
+    static const Node::Direction directions[4] = {
+        Node::Direction::N, Node::Direction::E, Node::Direction::S, Node::Direction::W
+    };
+    squares.clear();
+    for (int i = 0; i < 4; i++) {
+        if (direction != Node::Direction::NONE && direction != directions[i])
+            continue;
+        int squareX = x + offsetX[i];
+        int squareY = y + offsetY[i];
+        if (squareX >= 0 && squareX < level->getWidth() && squareY >= 0
+            && squareY < level->getHeight() && level->isEmptySpace(squareX, squareY))
+            squares.append(QPoint(squareX, squareY));
+    }
+}
+
+void Solver::listJunctions(Level* level, QVector<Wire*>& junctions) {
+    junctions.clear();
+    for (Wire::Id id : level->wires) {
+        Wire* wire = level->wirePool.get(id);
+        if (wire->getOwner() == Wire::Owner::BOARD && wire->isFullyConnected()
+            && wire->getBranchCount() < Wire::MAX_BRANCHES)
+            junctions.append(wire);
+    }
+}
+
+bool Solver::markSeen(BoardKey key) {
+    int shard = key.hash % SHARDS;
+    std::lock_guard<std::mutex> guard(seenLocks[shard]);
+    return seenStates[shard].insert(std::move(key)).second;
+}
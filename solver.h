@@ -0,0 +1,400 @@
+/**
+ * This class checks whether a level layout can be won. It searches the
+ * wire drawings a player could make, one chain at a time, by calling
+ * drawWire on private copies of the level and undoing through their
+ * journals, so every connection follows the game's own rules. Chains
+ * start from free outputs, and only a second pass, run if the first finds
+ * nothing, also branches them off finished chains. The search tree is
+ * split across threads that steal unexplored branches from each other,
+ * and branches that can no longer reach every END node with a matching
+ * tag and signal are cut off early. When the search finishes without a
+ * solution, the layout is proven unsolvable.
+ *
+ * @authors Max Donaldson, Jason Khong,
+ * Ariadne Petroulakis, Evan Tucker, and Ian Weller
+ *
+ * @version 22 April 2025
+ */
+
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <QPair>
+#include <QPoint>
+#include <QVector>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+#include "node.h"
+#include "tag.h"
+
+class Level;
+
+class Solver {
+
+public:
+    /**
+     * @brief The Status enum - The outcome of a search.
+     */
+    enum class Status {
+        SOLVED, UNSOLVABLE, ABORTED
+    };
+
+    /**
+     * @brief The Move struct - One drawWire call of a solution.
+     */
+    struct Move {
+        int x;
+        int y;
+        Tag tag;
+    };
+
+    /**
+     * @brief Solver - Creates a solver for the layout of a level. The level is only read by
+     * solve, and must not change while it runs.
+     * @param layout - The level whose nodes, gates and obstacles are solved. Its wires are
+     * ignored.
+     */
+    explicit Solver(Level* layout);
+
+    ~Solver();
+
+    /**
+     * @brief setThreadCount - Sets how many threads search. Defaults to one per core.
+     * @param count - The thread count, at least one.
+     */
+    void setThreadCount(int count);
+
+    /**
+     * @brief setNodeLimit - Caps the number of search nodes, after which the search gives up.
+     * @param limit - The most nodes to visit, or 0 for no limit.
+     */
+    void setNodeLimit(qint64 limit);
+
+    /**
+     * @brief solve - Runs the search to completion.
+     * @return SOLVED with a solution, UNSOLVABLE once every drawing has been ruled out, or
+     * ABORTED if the node limit was reached first.
+     */
+    Status solve();
+
+    /**
+     * @brief getStatus - Getter for the outcome of the last solve call.
+     * @return The status.
+     */
+    Status getStatus() const;
+
+    /**
+     * @brief getSolution - Getter for the winning drawing found by the last solve call.
+     * @return The drawWire calls that win the level when replayed in order on a fresh copy.
+     */
+    QVector<Move> getSolution() const;
+
+    /**
+     * @brief getNodesVisited - Getter for the number of search nodes visited.
+     * @return The number of board states expanded across all threads.
+     */
+    qint64 getNodesVisited() const;
+
+    /**
+     * @brief getNodesPruned - Getter for the number of search nodes cut off by reachability
+     * and signal checks.
+     * @return The number of pruned states.
+     */
+    qint64 getNodesPruned() const;
+
+    /**
+     * @brief getRepeatedStates - Getter for the number of board states skipped because they
+     * had been reached before in another order.
+     * @return The number of repeated states.
+     */
+    qint64 getRepeatedStates() const;
+
+    /**
+     * @brief getSteals - Getter for the number of branches taken from another thread.
+     * @return The number of steals.
+     */
+    qint64 getSteals() const;
+
+    /**
+     * @brief getThreadCount - Getter for the number of threads used.
+     * @return The thread count.
+     */
+    int getThreadCount() const;
+
+    /**
+     * @brief getElapsedMs - Getter for the wall time of the last solve call.
+     * @return The time in milliseconds.
+     */
+    qint64 getElapsedMs() const;
+
+private:
+    /**
+     * @brief The Worker struct - The private level and branch queue of one search thread.
+     */
+    struct Worker {
+        std::unique_ptr<Level> level;
+        std::mutex lock;
+        std::deque<QVector<Move>> tasks;
+        qint64 nodesVisited = 0;
+        qint64 nodesPruned = 0;
+        qint64 repeatedStates = 0;
+        qint64 steals = 0;
+
+        /**
+         * @brief floodMarks - The flood stamp of each square, reused by every isHopeless call.
+         */
+        QVector<quint32> floodMarks;
+
+        /**
+         * @brief floodStamp - The stamp of the latest isHopeless call.
+         */
+        quint32 floodStamp = 0;
+
+        /**
+         * @brief floodQueue - The squares reached by the latest isHopeless call.
+         */
+        QVector<QPoint> floodQueue;
+
+        /**
+         * @brief boardRecords - The wire records of the latest keyBoard call, before sorting.
+         */
+        QVector<QPair<quint64, Wire*>> boardRecords;
+    };
+
+    /**
+     * @brief The BoardKey struct - An exact record of a board state, with its hash.
+     */
+    struct BoardKey {
+        quint64 hash;
+        QVector<quint64> words;
+
+        bool operator==(const BoardKey& other) const {
+            return hash == other.hash && words == other.words;
+        }
+    };
+
+    /**
+     * @brief The BoardKeyHash struct - Hashes a BoardKey for the seen-state table.
+     */
+    struct BoardKeyHash {
+        size_t operator()(const BoardKey& key) const {
+            return key.hash;
+        }
+    };
+
+    /**
+     * @brief The Chain struct - The open end of the chain being drawn, if any.
+     */
+    struct Chain {
+        bool open;
+        int x;
+        int y;
+    };
+
+    /**
+     * @brief SHARDS - The number of separately locked parts of the seen-state table.
+     */
+    static const int SHARDS = 64;
+
+    /**
+     * @brief layout - The level being solved.
+     */
+    Level* layout;
+
+    /**
+     * @brief threadCount - The number of search threads.
+     */
+    int threadCount;
+
+    /**
+     * @brief nodeLimit - The most nodes to visit, or 0 for no limit.
+     */
+    qint64 nodeLimit;
+
+    /**
+     * @brief status - The outcome of the last search.
+     */
+    Status status;
+
+    /**
+     * @brief branching - Whether the current pass of the search branches chains off finished
+     * ones.
+     */
+    bool branching;
+
+    /**
+     * @brief solution - The winning drawing of the last search.
+     */
+    QVector<Move> solution;
+
+    /**
+     * @brief elapsedMs - The wall time of the last search.
+     */
+    qint64 elapsedMs;
+
+    /**
+     * @brief workers - One per search thread.
+     */
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    /**
+     * @brief pendingTasks - Branches queued or being searched. The search ends at zero.
+     */
+    std::atomic<int> pendingTasks;
+
+    /**
+     * @brief idleWorkers - Threads waiting for a branch to steal.
+     */
+    std::atomic<int> idleWorkers;
+
+    /**
+     * @brief idleLock - The lock idle threads wait on.
+     */
+    std::mutex idleLock;
+
+    /**
+     * @brief workAvailable - Wakes idle threads when branches are queued or the search ends.
+     */
+    std::condition_variable workAvailable;
+
+    /**
+     * @brief totalNodes - Nodes visited by all threads, for the node limit.
+     */
+    std::atomic<qint64> totalNodes;
+
+    /**
+     * @brief stopping - Set once a solution is found or the node limit is hit.
+     */
+    std::atomic<bool> stopping;
+
+    /**
+     * @brief limitReached - Set if the node limit cut the search short.
+     */
+    std::atomic<bool> limitReached;
+
+    /**
+     * @brief solved - Whether solution holds a win. Guarded by solutionLock.
+     */
+    bool solved;
+
+    /**
+     * @brief solutionLock - Guards solution.
+     */
+    std::mutex solutionLock;
+
+    /**
+     * @brief seenLocks - One lock per shard of seenStates.
+     */
+    std::mutex seenLocks[SHARDS];
+
+    /**
+     * @brief seenStates - The board states already expanded. Keys are compared in full, so a
+     * hash collision can't cut off a branch that was never searched.
+     */
+    std::unordered_set<BoardKey, BoardKeyHash> seenStates[SHARDS];
+
+    /**
+     * @brief run - The loop of one search thread: take a branch, replay it, search it.
+     * @param index - The worker index.
+     */
+    void run(int index);
+
+    /**
+     * @brief takeTask - Pops the newest branch of a worker, or steals the oldest branch of
+     * another worker.
+     * @param index - The worker index.
+     * @param task - Receives the moves leading to the branch.
+     * @return True if a branch was taken.
+     */
+    bool takeTask(int index, QVector<Move>& task);
+
+    /**
+     * @brief search - Depth-first search below the current board of a worker.
+     * @param worker - The worker whose level holds the board.
+     * @param path - The moves leading to the current board.
+     * @param chain - The open chain of the current board.
+     * @return True if a solution was found below.
+     */
+    bool search(Worker& worker, QVector<Move>& path, Chain chain);
+
+    /**
+     * @brief listMoves - Lists the squares the next wire may go on. While a chain is open it
+     * can only grow from its end, otherwise a new chain starts from any free output or, while
+     * branching, off a finished one.
+     * @param level - The board.
+     * @param chain - The open chain.
+     * @param branching - Whether new chains may branch off finished ones.
+     * @param moves - Receives the moves.
+     */
+    static void listMoves(Level* level, Chain chain, bool branching, QVector<Move>& moves);
+
+    /**
+     * @brief tryMove - Draws a wire and checks it extended the intended chain without taking
+     * over an END node or gate input that was already wired.
+     * @param level - The board.
+     * @param move - The move to draw.
+     * @param chain - The open chain before the move. Receives the open chain after it.
+     * @return False if the move was rejected. The board is left unchanged in that case.
+     */
+    static bool tryMove(Level* level, const Move& move, Chain& chain);
+
+    /**
+     * @brief isHopeless - Checks whether a board can no longer be won: a node is walled in,
+     * an END node has no source left with its tag and signal, or the open chain can't reach
+     * anything to plug into.
+     * @param worker - The worker whose level holds the board. Its flood buffers are reused.
+     * @param chain - The open chain.
+     * @param branching - Whether new chains may branch off finished ones.
+     * @return True if the board can be pruned.
+     */
+    static bool isHopeless(Worker& worker, Chain chain, bool branching);
+
+    /**
+     * @brief isSolved - Checks whether every node of a board is connected.
+     * @param level - The board.
+     * @return True if the level is won.
+     */
+    static bool isSolved(Level* level);
+
+    /**
+     * @brief keyBoard - Records the wires of a board, sorted by square, and the state of each
+     * flip-flop, latch and clock, and hashes them. Signals and the outputs of combinational
+     * gates follow from those, so equal keys mean equal states.
+     * @param worker - The worker whose level holds the board.
+     * @param key - Receives the key.
+     */
+    static void keyBoard(Worker& worker, BoardKey& key);
+
+    /**
+     * @brief portSquares - Lists the on-board squares a port can be wired from.
+     * @param level - The board.
+     * @param x - X position of the port.
+     * @param y - Y position of the port.
+     * @param direction - The way the port faces. NONE means any way.
+     * @param squares - Receives the squares.
+     */
+    static void portSquares(Level* level, int x, int y, Node::Direction direction,
+                            QVector<QPoint>& squares);
+
+    /**
+     * @brief listJunctions - Lists the board wires a new chain can branch off: finished ones
+     * with a branch to spare.
+     * @param level - The board.
+     * @param junctions - Receives the wires.
+     */
+    static void listJunctions(Level* level, QVector<Wire*>& junctions);
+
+    /**
+     * @brief markSeen - Records a board state as expanded.
+     * @param key - The key of the state.
+     * @return False if the state had been recorded before.
+     */
+    bool markSeen(BoardKey key);
+};
+
+#endif // SOLVER_H
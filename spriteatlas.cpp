@@ -0,0 +1,78 @@
+#include "spriteatlas.h"
+#include <QtMath>
+
+SpriteAtlas::SpriteAtlas()
+    : columns(1), devicePixelRatio(1), stale(true) {
+}
+
+int SpriteAtlas::addSprite(const QPixmap& source) {
+    sources.append(source);
+    drawings.append(Drawing());
+    stale = true;
+    return sources.size() - 1;
+}
+
+int SpriteAtlas::addSprite(const Drawing& drawing) {
+    sources.append(QPixmap());
+    drawings.append(drawing);
+    stale = true;
+    return sources.size() - 1;
+}
+
+bool SpriteAtlas::prepare(const QSize& squareSize, qreal devicePixelRatio) {
+    if (!stale && squareSize == this->squareSize && devicePixelRatio == this->devicePixelRatio)
+        return false;
+    stale = false;
+    this->squareSize = squareSize;
+    this->devicePixelRatio = devicePixelRatio;
+    pixelSize = QSize(qMax(1, qCeil(squareSize.width() * devicePixelRatio)),
+                      qMax(1, qCeil(squareSize.height() * devicePixelRatio)));
+
+    // Lay the squares out close to square, so the atlas stays well within pixmap limits.
+    int count = qMax(1, int(sources.size()));
+    columns = qMax(1, qCeil(qSqrt(count)));
+    int rows = (count + columns - 1) / columns;
+    atlas = QPixmap(columns * pixelSize.width(), rows * pixelSize.height());
+    atlas.fill(Qt::transparent);
+
+    // Squares are painted in screen pixels. Images are stretched without smoothing to keep
+    // their pixel art look, and drawings are scaled so they work in logical pixels.
+    QPainter atlasPainter(&atlas);
+    for (int sprite = 0; sprite < sources.size(); sprite++) {
+        QRect square = getSourceRect(sprite);
+        if (drawings[sprite]) {
+            atlasPainter.save();
+            atlasPainter.translate(square.topLeft());
+            atlasPainter.scale(devicePixelRatio, devicePixelRatio);
+            drawings[sprite](atlasPainter, QRect(QPoint(0, 0), squareSize));
+            atlasPainter.restore();
+        }
+        else
+            atlasPainter.drawPixmap(square, sources[sprite]);
+    }
+    atlasPainter.end();
+    atlas.setDevicePixelRatio(devicePixelRatio);
+    return true;
+}
+
+QPainter::PixmapFragment SpriteAtlas::getFragment(const QPoint& target, int sprite) const {
+    // Fragments are placed by their centers and sized by their source, in the atlas' pixels.
+    QRect source = getSourceRect(sprite);
+    return QPainter::PixmapFragment::create(
+        QPointF(target.x() + squareSize.width() / 2.0, target.y() + squareSize.height() / 2.0),
+        source, qreal(squareSize.width()) / source.width(),
+        qreal(squareSize.height()) / source.height());
+}
+
+const QPixmap& SpriteAtlas::getPixmap() const {
+    return atlas;
+}
+
+QRect SpriteAtlas::getSourceRect(int sprite) const {
+    return QRect((sprite % columns) * pixelSize.width(), (sprite / columns) * pixelSize.height(),
+                 pixelSize.width(), pixelSize.height());
+}
+
+int SpriteAtlas::getSpriteCount() const {
+    return sources.size();
+}
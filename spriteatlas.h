@@ -0,0 +1,138 @@
+/**
+ * This class packs the board sprites into a single pixmap, pre-scaled to
+ * the size of one board square. Each sprite is registered once and then
+ * addressed by a small integer id, so drawing a square is a plain copy
+ * out of the atlas instead of scaling or loading an image every time,
+ * and a whole frame of squares can be copied in one batch.
+ * The atlas is rebuilt only when the square size or the screen's device
+ * pixel ratio changes.
+ *
+ * @authors Max Donaldson, Jason Khong,
+ * Ariadne Petroulakis, Evan Tucker, and Ian Weller
+ *
+ * @version 22 April 2025
+ */
+
+#ifndef SPRITEATLAS_H
+#define SPRITEATLAS_H
+
+#include <QPainter>
+#include <QPixmap>
+#include <QRect>
+#include <QSize>
+#include <QVector>
+#include <functional>
+
+class SpriteAtlas {
+
+public:
+    /**
+     * @brief NO_SPRITE - The id given back for a sprite that was never registered.
+     */
+    static const int NO_SPRITE = -1;
+
+    /**
+     * @brief Drawing - Paints a sprite that has no image into its square of the atlas.
+     */
+    using Drawing = std::function<void(QPainter& painter, const QRect& square)>;
+
+    /**
+     * @brief SpriteAtlas - Creates an empty atlas.
+     */
+    SpriteAtlas();
+
+    /**
+     * @brief addSprite - Registers an image, which is stretched to fill a square.
+     * @param source - The image at its original size.
+     * @return The new sprite's id.
+     */
+    int addSprite(const QPixmap& source);
+
+    /**
+     * @brief addSprite - Registers a sprite painted at the square size, e.g. an outline whose
+     * pen shouldn't be scaled.
+     * @param drawing - Paints the sprite in logical pixels within the given square.
+     * @return The new sprite's id.
+     */
+    int addSprite(const Drawing& drawing);
+
+    /**
+     * @brief prepare - Scales every sprite into the atlas for the given square size, unless the
+     * atlas is already at that size.
+     * @param squareSize - The size of one board square, in logical pixels.
+     * @param devicePixelRatio - The ratio of screen pixels to logical pixels.
+     * @return True if the atlas was rebuilt.
+     */
+    bool prepare(const QSize& squareSize, qreal devicePixelRatio);
+
+    /**
+     * @brief getFragment - Describes a copy of a sprite onto a board square, so a whole frame of
+     * sprites can be drawn with one QPainter::drawPixmapFragments call on the atlas.
+     * @param target - The top left corner of the square, in logical pixels.
+     * @param sprite - The sprite's id.
+     * @return The fragment, scaled from the atlas' pixels down to the logical square size.
+     */
+    QPainter::PixmapFragment getFragment(const QPoint& target, int sprite) const;
+
+    /**
+     * @brief getPixmap - Getter for the atlas itself.
+     * @return Every sprite, one square each, left to right and top to bottom.
+     */
+    const QPixmap& getPixmap() const;
+
+    /**
+     * @brief getSourceRect - Gets where a sprite sits in the atlas.
+     * @param sprite - The sprite's id.
+     * @return The sprite's square in the atlas' own pixels.
+     */
+    QRect getSourceRect(int sprite) const;
+
+    /**
+     * @brief getSpriteCount - Getter for the number of registered sprites.
+     * @return The sprite count.
+     */
+    int getSpriteCount() const;
+
+private:
+    /**
+     * @brief sources - The image of each sprite, or a null pixmap for drawn sprites.
+     */
+    QVector<QPixmap> sources;
+
+    /**
+     * @brief drawings - The drawing of each sprite, or an empty function for images.
+     */
+    QVector<Drawing> drawings;
+
+    /**
+     * @brief atlas - The scaled sprites, each in its own square.
+     */
+    QPixmap atlas;
+
+    /**
+     * @brief columns - The number of sprites on each row of the atlas.
+     */
+    int columns;
+
+    /**
+     * @brief pixelSize - The size of one atlas square in screen pixels.
+     */
+    QSize pixelSize;
+
+    /**
+     * @brief squareSize - The square size the atlas was last prepared for.
+     */
+    QSize squareSize;
+
+    /**
+     * @brief devicePixelRatio - The device pixel ratio the atlas was last prepared for.
+     */
+    qreal devicePixelRatio;
+
+    /**
+     * @brief stale - Whether sprites were added since the atlas was last prepared.
+     */
+    bool stale;
+};
+
+#endif // SPRITEATLAS_H
@@ -0,0 +1,50 @@
+#include "tag.h"
+
+Tag Tag::fromString(const QString& text) {
+    Tag tag;
+    for (QChar rootId : text) {
+        int id = idOf(rootId);
+        if (id >= 0 && id < CAPACITY)
+            tag.bits[id / 64] |= quint64(1) << (id % 64);
+    }
+    return tag;
+}
+
+QString Tag::toString() const {
+    QString text;
+    for (int i = 0; i < WORDS; i++) {
+        quint64 word = bits[i];
+        while (word) {
+            int bit = qCountTrailingZeroBits(word);
+            text.append(charOf(i * 64 + bit));
+            word &= word - 1;
+        }
+    }
+    return text;
+}
+
+int Tag::count() const {
+    int total = 0;
+    for (int i = 0; i < WORDS; i++)
+        total += qPopulationCount(bits[i]);
+    return total;
+}
+
+int Tag::idOf(QChar rootId) {
+    char16_t c = rootId.unicode();
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'Z')
+        return 10 + (c - 'A');
+    if (c >= 'a' && c <= 'z')
+        return 36 + (c - 'a');
+    return -1;
+}
+
+QChar Tag::charOf(int id) {
+    if (id < 10)
+        return QChar('0' + id);
+    if (id < 36)
+        return QChar('A' + (id - 10));
+    return QChar('a' + (id - 36));
+}
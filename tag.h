@@ -0,0 +1,138 @@
+/**
+ * This class represents a wire tag: the set of ROOT node IDs whose
+ * signals have been merged into a wire. Tags are stored as a fixed-width
+ * bitset so merging is a bitwise OR and matching is an integer compare.
+ * Display strings are only built at the UI edge.
+ *
+ * @authors Max Donaldson, Jason Khong,
+ * Ariadne Petroulakis, Evan Tucker, and Ian Weller
+ *
+ * @version 22 April 2025
+ */
+
+#ifndef TAG_H
+#define TAG_H
+
+#include <QString>
+
+class Tag {
+
+public:
+    /**
+     * @brief WORDS - The number of 64-bit words in a tag. Raise this to support more root IDs.
+     */
+    static const int WORDS = 1;
+
+    /**
+     * @brief CAPACITY - The number of distinct root IDs a tag can hold.
+     */
+    static const int CAPACITY = 64 * WORDS;
+
+    /**
+     * @brief ID_COUNT - The number of root IDs that have a character. Bits from here up are
+     * never set.
+     */
+    static const int ID_COUNT = 62;
+
+    /**
+     * @brief Tag - Creates an empty tag.
+     */
+    Tag() : bits{} {}
+
+    /**
+     * @brief fromString - Builds a tag from its display string, where every character is one
+     * root ID. Characters without an ID are ignored.
+     * @param text - The display string, e.g. "AB".
+     * @return The tag holding each root ID in the string.
+     */
+    static Tag fromString(const QString& text);
+
+    /**
+     * @brief toString - Builds the display string of this tag, with root IDs in sorted order.
+     * @return The display string, e.g. "AB".
+     */
+    QString toString() const;
+
+    /**
+     * @brief united - Merges two tags.
+     * @param other - The tag to merge with.
+     * @return A tag holding the root IDs of both tags.
+     */
+    Tag united(const Tag& other) const {
+        Tag result;
+        for (int i = 0; i < WORDS; i++)
+            result.bits[i] = bits[i] | other.bits[i];
+        return result;
+    }
+
+    /**
+     * @brief isEmpty - Checks if the tag holds no root IDs.
+     * @return True if the tag is empty.
+     */
+    bool isEmpty() const {
+        for (int i = 0; i < WORDS; i++) {
+            if (bits[i])
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief count - Gets the number of root IDs held.
+     * @return The number of set bits.
+     */
+    int count() const;
+
+    /**
+     * @brief getWord - Getter for one word of the bitset.
+     * @param index - The word index, below WORDS.
+     * @return The bits of the word.
+     */
+    quint64 getWord(int index) const {
+        return bits[index];
+    }
+
+    /**
+     * @brief setWord - Setter for one word of the bitset.
+     * @param index - The word index, below WORDS.
+     * @param word - The bits of the word.
+     */
+    void setWord(int index, quint64 word) {
+        bits[index] = word;
+    }
+
+    bool operator==(const Tag& other) const {
+        for (int i = 0; i < WORDS; i++) {
+            if (bits[i] != other.bits[i])
+                return false;
+        }
+        return true;
+    }
+
+    bool operator!=(const Tag& other) const {
+        return !(*this == other);
+    }
+
+    /**
+     * @brief idOf - Gets the bit index used for a root ID character. Digits, then upper case,
+     * then lower case letters, so ascending bits print in the same order as a sorted string.
+     * @param rootId - The root ID character.
+     * @return The bit index, or -1 if the character has no ID.
+     */
+    static int idOf(QChar rootId);
+
+    /**
+     * @brief charOf - Gets the root ID character for a bit index. Inverse of idOf.
+     * @param id - The bit index.
+     * @return The root ID character.
+     */
+    static QChar charOf(int id);
+
+private:
+    /**
+     * @brief bits - One bit per root ID.
+     */
+    quint64 bits[WORDS];
+};
+
+#endif // TAG_H
@@ -0,0 +1,165 @@
+#include "tilerasterizer.h"
+#include <QtMath>
+
+TileRasterizer::TileRasterizer()
+    : columns(0), tileCount(0), threadCount(qMax(1u, std::thread::hardware_concurrency())),
+    nextTile(0), cancelled(false), takenCount(0) {
+}
+
+TileRasterizer::~TileRasterizer() {
+    cancel();
+}
+
+void TileRasterizer::start(const Job& job) {
+    cancel();
+    this->job = job;
+    QSize tileSize(qMax(1, job.tileSize.width()), qMax(1, job.tileSize.height()));
+    this->job.tileSize = tileSize;
+    columns = (job.boardSize.width() + tileSize.width() - 1) / tileSize.width();
+    int rows = (job.boardSize.height() + tileSize.height() - 1) / tileSize.height();
+    tileCount = columns * rows;
+    sortSprites(job.staticSprites, staticStarts, staticOrder);
+    sortSprites(job.sprites, spriteStarts, spriteOrder);
+
+    nextTile = 0;
+    cancelled = false;
+    takenCount = 0;
+    for (int i = 0; i < qMin(threadCount, tileCount); i++)
+        threads.emplace_back(&TileRasterizer::run, this);
+}
+
+void TileRasterizer::cancel() {
+    cancelled = true;
+    for (std::thread& thread : threads)
+        thread.join();
+    threads.clear();
+    std::lock_guard<std::mutex> guard(finishedLock);
+    finished.clear();
+    takenCount = tileCount;
+}
+
+bool TileRasterizer::isRunning() const {
+    return takenCount < tileCount;
+}
+
+QVector<TileRasterizer::Tile> TileRasterizer::takeFinishedTiles() {
+    QVector<Tile> tiles;
+    {
+        std::lock_guard<std::mutex> guard(finishedLock);
+        tiles.swap(finished);
+    }
+    takenCount += tiles.size();
+
+    // The workers have run out of tiles by now, so this doesn't wait.
+    if (!isRunning()) {
+        for (std::thread& thread : threads)
+            thread.join();
+        threads.clear();
+    }
+    return tiles;
+}
+
+int TileRasterizer::getTileCount() const {
+    return tileCount;
+}
+
+int TileRasterizer::getThreadCount() const {
+    return threadCount;
+}
+
+void TileRasterizer::run() {
+    qreal pixelRatio = job.devicePixelRatio;
+    while (!cancelled) {
+        int index = nextTile++;
+        if (index >= tileCount)
+            return;
+        Tile tile;
+        tile.area = QRect((index % columns) * job.tileSize.width(),
+                          (index / columns) * job.tileSize.height(),
+                          job.tileSize.width(), job.tileSize.height())
+                        .intersected(QRect(QPoint(0, 0), job.boardSize));
+
+        // Each tile is painted in board coordinates, starting from its part of the grid.
+        QImage image(qCeil(tile.area.width() * pixelRatio), qCeil(tile.area.height() * pixelRatio),
+                     QImage::Format_ARGB32_Premultiplied);
+        image.setDevicePixelRatio(pixelRatio);
+        QPainter staticPainter(&image);
+        staticPainter.translate(-tile.area.x(), -tile.area.y());
+        staticPainter.setCompositionMode(QPainter::CompositionMode_Source);
+        staticPainter.drawImage(QRectF(tile.area), job.background,
+                                QRectF(tile.area.x() * pixelRatio, tile.area.y() * pixelRatio,
+                                       tile.area.width() * pixelRatio,
+                                       tile.area.height() * pixelRatio));
+        staticPainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        drawObstacles(staticPainter, tile.area);
+        drawSprites(staticPainter, job.staticSprites, staticOrder, staticStarts[index],
+                    staticStarts[index + 1]);
+        staticPainter.end();
+        tile.staticImage = image;
+
+        // The frame goes on a copy, which the painter makes as it starts.
+        QPainter framePainter(&image);
+        framePainter.translate(-tile.area.x(), -tile.area.y());
+        drawSprites(framePainter, job.sprites, spriteOrder, spriteStarts[index],
+                    spriteStarts[index + 1]);
+        framePainter.end();
+        tile.frameImage = image;
+
+        std::lock_guard<std::mutex> guard(finishedLock);
+        if (!cancelled)
+            finished.append(tile);
+    }
+}
+
+void TileRasterizer::sortSprites(const QVector<Sprite>& sprites, QVector<int>& starts,
+                                 QVector<int>& order) const {
+    // Counting sort by tile, so each tile still draws its sprites bottom first.
+    QVector<int> tiles(sprites.size());
+    starts.fill(0, tileCount + 1);
+    int squareWidth = job.squareSize.width();
+    int squareHeight = job.squareSize.height();
+    for (int i = 0; i < sprites.size(); i++) {
+        int column = qBound(0, sprites[i].square.x() * squareWidth / job.tileSize.width(),
+                            columns - 1);
+        int row = qBound(0, sprites[i].square.y() * squareHeight / job.tileSize.height(),
+                         tileCount / columns - 1);
+        tiles[i] = row * columns + column;
+        starts[tiles[i] + 1]++;
+    }
+    for (int tile = 0; tile < tileCount; tile++)
+        starts[tile + 1] += starts[tile];
+    QVector<int> next = starts;
+    order.resize(sprites.size());
+    for (int i = 0; i < sprites.size(); i++)
+        order[next[tiles[i]]++] = i;
+}
+
+void TileRasterizer::drawObstacles(QPainter& painter, const QRect& area) const {
+    // Tiles are a whole number of squares, so each tile owns the squares it starts on.
+    int squareWidth = qMax(1, job.squareSize.width());
+    int squareHeight = qMax(1, job.squareSize.height());
+    int lastX = area.right() / squareWidth;
+    int lastY = area.bottom() / squareHeight;
+    for (int y = area.top() / squareHeight; y <= lastY; y++) {
+        for (int x = area.left() / squareWidth; x <= lastX; x++) {
+            if (job.obstacles.test(x, y))
+                drawSprite(painter, x, y, job.obstacleSprite);
+        }
+    }
+}
+
+void TileRasterizer::drawSprites(QPainter& painter, const QVector<Sprite>& sprites,
+                                 const QVector<int>& order, int start, int end) const {
+    for (int i = start; i < end; i++) {
+        const Sprite& sprite = sprites[order[i]];
+        drawSprite(painter, sprite.square.x(), sprite.square.y(), sprite.sprite);
+    }
+}
+
+void TileRasterizer::drawSprite(QPainter& painter, int x, int y, int sprite) const {
+    if (sprite < 0 || sprite >= job.sourceRects.size())
+        return;
+    painter.drawImage(QRectF(x * job.squareSize.width(), y * job.squareSize.height(),
+                             job.squareSize.width(), job.squareSize.height()),
+                      job.atlas, QRectF(job.sourceRects[sprite]));
+}
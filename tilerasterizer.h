@@ -0,0 +1,296 @@
+/**
+ * This class draws very large boards off the GUI thread. The board is
+ * split into square tiles, and a pool of threads paints each tile into
+ * its own QImage from the grid and a snapshot of the board's contents:
+ * first the static layer, then the wires and other sprites on top. Each
+ * worker finds the obstacles and sprites of its tile and places them
+ * itself, so the GUI thread only copies sprite ids for the occupied
+ * squares and never waits on the workers. It collects finished tiles
+ * whenever it likes and shows them as they come in, and starting over,
+ * e.g. for a new level, drops whatever was still being drawn.
+ *
+ * @authors Max Donaldson, Jason Khong,
+ * Ariadne Petroulakis, Evan Tucker, and Ian Weller
+ *
+ * @version 22 April 2025
+ */
+
+#ifndef TILERASTERIZER_H
+#define TILERASTERIZER_H
+
+#include <QImage>
+#include <QPainter>
+#include <QPoint>
+#include <QRect>
+#include <QSize>
+#include <QVector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "obstaclelayer.h"
+
+class TileRasterizer {
+
+public:
+    /**
+     * @brief The Sprite struct - One atlas sprite on one board square.
+     */
+    struct Sprite {
+        /**
+         * @brief square - The x, y square on the grid.
+         */
+        QPoint square;
+
+        /**
+         * @brief sprite - The sprite's id in the atlas.
+         */
+        int sprite;
+    };
+
+    /**
+     * @brief The Job struct - Everything needed to draw a board, copied so the workers never
+     * touch the level or the window.
+     */
+    struct Job {
+        /**
+         * @brief background - The grid, scaled to the board in screen pixels.
+         */
+        QImage background;
+
+        /**
+         * @brief atlas - The sprite atlas the sprites are cut from.
+         */
+        QImage atlas;
+
+        /**
+         * @brief sourceRects - Where each sprite sits in the atlas, in its own pixels, by id.
+         */
+        QVector<QRect> sourceRects;
+
+        /**
+         * @brief squareSize - The size of one board square, in logical pixels.
+         */
+        QSize squareSize;
+
+        /**
+         * @brief boardSize - The size of the board, in logical pixels.
+         */
+        QSize boardSize;
+
+        /**
+         * @brief devicePixelRatio - The ratio of screen pixels to logical pixels.
+         */
+        qreal devicePixelRatio;
+
+        /**
+         * @brief tileSize - The size of every tile but those on the right and bottom edges, in
+         * logical pixels. It should be a whole number of squares, so no sprite straddles tiles.
+         */
+        QSize tileSize;
+
+        /**
+         * @brief obstacles - The blocked squares, which go on the static layer. A copy shares its
+         * bits with the level's layer until the level changes them, so it is free to take.
+         */
+        ObstacleLayer obstacles = ObstacleLayer(0, 0);
+
+        /**
+         * @brief obstacleSprite - The sprite drawn on every blocked square.
+         */
+        int obstacleSprite;
+
+        /**
+         * @brief staticSprites - The other sprites of the static layer, bottom first.
+         */
+        QVector<Sprite> staticSprites;
+
+        /**
+         * @brief sprites - The sprites drawn over the static layer, bottom first.
+         */
+        QVector<Sprite> sprites;
+    };
+
+    /**
+     * @brief The Tile struct - A finished part of the board.
+     */
+    struct Tile {
+        /**
+         * @brief area - Where the tile goes on the board, in logical pixels.
+         */
+        QRect area;
+
+        /**
+         * @brief staticImage - The static layer within the area.
+         */
+        QImage staticImage;
+
+        /**
+         * @brief frameImage - The whole frame within the area.
+         */
+        QImage frameImage;
+    };
+
+    /**
+     * @brief TileRasterizer - Creates a rasterizer with one thread per core and nothing to draw.
+     */
+    TileRasterizer();
+
+    /**
+     * @brief ~TileRasterizer - Drops the job in progress and waits for its threads.
+     */
+    ~TileRasterizer();
+
+    /**
+     * @brief start - Drops the job in progress, if any, sorts the sprites of a new one into
+     * tiles and starts drawing them. Returns right away.
+     * @param job - The board to draw.
+     */
+    void start(const Job& job);
+
+    /**
+     * @brief cancel - Drops the job in progress, if any. Waits for each worker to finish at most
+     * the tile it is on.
+     */
+    void cancel();
+
+    /**
+     * @brief isRunning - Checks whether a job has tiles that were not taken yet.
+     * @return True until every tile of the job has been handed over by takeFinishedTiles.
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief takeFinishedTiles - Hands over the tiles finished since the last call.
+     * @return The tiles, in no particular order.
+     */
+    QVector<Tile> takeFinishedTiles();
+
+    /**
+     * @brief getTileCount - Getter for the number of tiles of the current or last job.
+     * @return The tile count.
+     */
+    int getTileCount() const;
+
+    /**
+     * @brief getThreadCount - Getter for the number of drawing threads.
+     * @return The thread count.
+     */
+    int getThreadCount() const;
+
+private:
+    /**
+     * @brief job - The board being drawn. Read only while the workers run.
+     */
+    Job job;
+
+    /**
+     * @brief columns - The number of tiles across the board.
+     */
+    int columns;
+
+    /**
+     * @brief tileCount - The number of tiles of the job.
+     */
+    int tileCount;
+
+    /**
+     * @brief staticStarts - Where each tile's sprites start in staticOrder. One more entry than
+     * tiles.
+     */
+    QVector<int> staticStarts;
+
+    /**
+     * @brief staticOrder - The static sprites of each tile, grouped by tile, bottom first.
+     */
+    QVector<int> staticOrder;
+
+    /**
+     * @brief spriteStarts - Where each tile's sprites start in spriteOrder. One more entry than
+     * tiles.
+     */
+    QVector<int> spriteStarts;
+
+    /**
+     * @brief spriteOrder - The other sprites of each tile, grouped by tile, bottom first.
+     */
+    QVector<int> spriteOrder;
+
+    /**
+     * @brief threadCount - The number of drawing threads.
+     */
+    int threadCount;
+
+    /**
+     * @brief threads - The threads drawing the job.
+     */
+    std::vector<std::thread> threads;
+
+    /**
+     * @brief nextTile - The next tile for a worker to pick up.
+     */
+    std::atomic<int> nextTile;
+
+    /**
+     * @brief cancelled - Set to make the workers stop after their current tile.
+     */
+    std::atomic<bool> cancelled;
+
+    /**
+     * @brief finished - Tiles drawn but not taken yet. Guarded by finishedLock.
+     */
+    QVector<Tile> finished;
+
+    /**
+     * @brief finishedLock - Guards finished.
+     */
+    std::mutex finishedLock;
+
+    /**
+     * @brief takenCount - The number of tiles of the job taken so far.
+     */
+    int takenCount;
+
+    /**
+     * @brief run - The loop of one drawing thread.
+     */
+    void run();
+
+    /**
+     * @brief sortSprites - Groups sprites by the tile holding their squares.
+     * @param sprites - The sprites, bottom first.
+     * @param starts - Receives where each tile's sprites start, plus one last entry.
+     * @param order - Receives the sprite indices, grouped by tile, keeping their order.
+     */
+    void sortSprites(const QVector<Sprite>& sprites, QVector<int>& starts,
+                     QVector<int>& order) const;
+
+    /**
+     * @brief drawObstacles - Draws the obstacles of a tile out of the atlas.
+     * @param painter - The painter on the tile, in board coordinates.
+     * @param area - The tile, in logical pixels.
+     */
+    void drawObstacles(QPainter& painter, const QRect& area) const;
+
+    /**
+     * @brief drawSprites - Draws some of a tile's sprites out of the atlas.
+     * @param painter - The painter on the tile, in board coordinates.
+     * @param sprites - Every sprite of the job of one kind.
+     * @param order - The sprite indices grouped by tile.
+     * @param start - The first index in order to draw.
+     * @param end - One past the last index in order to draw.
+     */
+    void drawSprites(QPainter& painter, const QVector<Sprite>& sprites,
+                     const QVector<int>& order, int start, int end) const;
+
+    /**
+     * @brief drawSprite - Draws one sprite out of the atlas onto its square.
+     * @param painter - The painter on the tile, in board coordinates.
+     * @param x - X position on the grid.
+     * @param y - Y position on the grid.
+     * @param sprite - The sprite's id.
+     */
+    void drawSprite(QPainter& painter, int x, int y, int sprite) const;
+};
+
+#endif // TILERASTERIZER_H
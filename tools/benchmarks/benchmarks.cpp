@@ -0,0 +1,371 @@
+#include "cellgrid.h"
+#include "generator.h"
+#include "level.h"
+#include "simulator.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+namespace {
+
+// Every benchmark runs this many rounds on fresh levels and reports the fastest one.
+const int ROUNDS = 3;
+
+/**
+ * @brief rowsLayout - Builds a board of lanes, each a ROOT node on the left edge and a
+ * matching END node on the right one, with a row of obstacles under every lane.
+ * @param width - The width of the board.
+ * @param height - The height of the board. Each lane takes two rows.
+ * @return The layout.
+ */
+LevelPack::Layout rowsLayout(int width, int height) {
+    LevelPack::Layout layout{width, height, {}};
+    Tag tag = Tag::fromString("A");
+    for (int y = 0; y + 1 < height; y += 2) {
+        LevelPack::Record root{LevelPack::Kind::ROOT, 0, y};
+        root.tag = tag;
+        LevelPack::Record end{LevelPack::Kind::END, width - 1, y};
+        end.tag = tag;
+        LevelPack::Record obstacles{LevelPack::Kind::OBSTACLES, 0, y + 1};
+        obstacles.width = width;
+        layout.records << root << end << obstacles;
+    }
+    return layout;
+}
+
+/**
+ * @brief routeRows - Wires every lane of a rowsLayout board end to end.
+ * @param level - The level holding the layout.
+ * @return The number of wire squares drawn.
+ */
+int routeRows(Level& level) {
+    int width = level.getWidth();
+    int squares = 0;
+    for (int y = 0; y + 1 < level.getHeight(); y += 2) {
+        if (level.routeWire(0, y, width - 1, y, Tag::fromString("A")))
+            squares += width - 2;
+    }
+    return squares;
+}
+
+/**
+ * @brief benchClearWires - Times clearWires on a 1024x1024 board with 512 full-width wires.
+ * @param out - Where the result goes.
+ */
+void benchClearWires(QTextStream& out) {
+    const int size = 1024;
+    LevelPack::Layout layout = rowsLayout(size, size);
+    qint64 best = -1;
+    int squares = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        Level level(nullptr, nullptr, nullptr, size, size);
+        level.loadLayout(layout);
+        squares = routeRows(level);
+
+        QElapsedTimer timer;
+        timer.start();
+        level.clearWires();
+        qint64 elapsed = timer.nsecsElapsed();
+        if (best < 0 || elapsed < best)
+            best = elapsed;
+    }
+    out << "clearwires: " << squares << " wire squares on a " << size << "x" << size
+        << " board cleared in " << best / 1e6 << " ms\n";
+}
+
+/**
+ * @brief gatesLayout - Builds a board of lanes like rowsLayout, with a NOT gate halfway along
+ * each lane.
+ * @param width - The width of the board.
+ * @param height - The height of the board. Each lane takes two rows.
+ * @return The layout.
+ */
+LevelPack::Layout gatesLayout(int width, int height) {
+    LevelPack::Layout layout = rowsLayout(width, height);
+    for (LevelPack::Record& end : layout.records) {
+        if (end.kind == LevelPack::Kind::END)
+            end.signal = true;
+    }
+    for (int y = 0; y + 1 < height; y += 2) {
+        LevelPack::Record gate{LevelPack::Kind::GATE, width / 2, y};
+        gate.op = Gate::Operator::NOT;
+        gate.direction = Gate::Direction::EAST;
+        layout.records << gate;
+    }
+    return layout;
+}
+
+/**
+ * @brief benchDrawWire - Times the drawWire calls that plug the lanes of a 256x256 gatesLayout
+ * board into their gates. Everything else is wired beforehand, so each call edits a circuit of
+ * 128 gates and about 32000 wire squares.
+ * @param out - Where the result goes.
+ */
+void benchDrawWire(QTextStream& out) {
+    const int size = 256;
+    const int plugX = size / 2 - 1;
+    LevelPack::Layout layout = gatesLayout(size, size);
+    Tag tag = Tag::fromString("A");
+    qint64 best = -1;
+    int calls = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        Level level(nullptr, nullptr, nullptr, size, size);
+        level.loadLayout(layout);
+        for (int y = 0; y + 1 < size; y += 2) {
+            for (int x = 1; x < plugX; x++)
+                level.drawWire(x, y, tag);
+            level.routeWire(plugX + 1, y, size - 1, y, tag);
+        }
+
+        // The first plug also compiles the wiring drawn so far, so it isn't timed.
+        level.drawWire(plugX, 0, tag);
+        calls = 0;
+        QElapsedTimer timer;
+        timer.start();
+        for (int y = 2; y + 1 < size; y += 2) {
+            level.drawWire(plugX, y, tag);
+            calls++;
+        }
+        qint64 elapsed = timer.nsecsElapsed();
+        if (best < 0 || elapsed < best)
+            best = elapsed;
+    }
+    out << "drawwire: " << calls << " gates plugged in on a " << size << "x" << size
+        << " board, " << best / calls << " ns per call\n";
+}
+
+/**
+ * @brief benchNeighbors - Reads the four neighbors of every square of a half-wired 64x64 board,
+ * first with four bounds-checked at() calls the way the find* helpers used to, then with one
+ * neighbors() call, and reports the cost per square of each.
+ * @param out - Where the result goes.
+ */
+void benchNeighbors(QTextStream& out) {
+    const int size = 64;
+    const int passes = 2000;
+    CellGrid grid(size, size);
+    for (int y = 0; y < size; y += 4) {
+        for (int x = 0; x < size; x++)
+            grid.set(x, y, {CellGrid::Component::WIRE, quint32(y * size + x)});
+    }
+
+    // Both scans count the occupied neighbors, so neither can be optimized away.
+    auto scan = [&](bool table, int& occupied) {
+        qint64 best = -1;
+        for (int round = 0; round < ROUNDS; round++) {
+            occupied = 0;
+            QElapsedTimer timer;
+            timer.start();
+            for (int pass = 0; pass < passes; pass++) {
+                for (int y = 0; y < size; y++) {
+                    for (int x = 0; x < size; x++) {
+                        CellGrid::Cell around[4];
+                        if (table)
+                            grid.neighbors(x, y, around);
+                        else {
+                            for (int i = 0; i < 4; i++)
+                                around[i] = grid.at(x + CellGrid::NEIGHBOR_X[i],
+                                                    y + CellGrid::NEIGHBOR_Y[i]);
+                        }
+                        for (const CellGrid::Cell& cell : around)
+                            occupied += cell.kind != CellGrid::Component::NONE;
+                    }
+                }
+            }
+            qint64 elapsed = timer.nsecsElapsed();
+            if (best < 0 || elapsed < best)
+                best = elapsed;
+        }
+        return double(best) / (qint64(passes) * size * size);
+    };
+    int checkedOccupied = 0;
+    int tableOccupied = 0;
+    double checked = scan(false, checkedOccupied);
+    double table = scan(true, tableOccupied);
+    out << "neighbors: " << size << "x" << size << " board, four at() calls " << checked
+        << " ns per square, neighbors() " << table << " ns per square"
+        << (checkedOccupied == tableOccupied ? "" : ", MISMATCH") << "\n";
+}
+
+/**
+ * @brief benchGeneratorRun - Generates a batch of levels and reports the wall-clock rate and
+ * the counters of every stage.
+ * @param out - Where the result goes.
+ * @param generator - The configured generator.
+ * @param name - What the batch is called in the output.
+ * @param count - The number of levels to generate.
+ */
+void benchGeneratorRun(QTextStream& out, Generator& generator, const QString& name, int count) {
+    int generated = generator.generate(count);
+    out << "generator " << name << ", " << generator.getThreadCount() << " threads: "
+        << generated << " levels in " << generator.getElapsedMs() << " ms, "
+        << generator.getLevelsPerMinute() << " levels/min\n";
+    const char* stageNames[] = {"synthesis", "placement", "validation"};
+    Generator::Stage stages[] = {Generator::Stage::SYNTHESIS, Generator::Stage::PLACEMENT,
+                                 Generator::Stage::VALIDATION};
+    for (int i = 0; i < 3; i++) {
+        Generator::StageStats stats = generator.getStageStats(stages[i]);
+        out << "    " << stageNames[i] << ": " << stats.passed << "/" << stats.attempts
+            << " passed, " << generator.getStageThroughput(stages[i]) << " per thread second\n";
+    }
+}
+
+/**
+ * @brief benchGenerator - Times the level generator on the built-in board size and on a large
+ * board with ten inputs, first on one thread and then on one per core.
+ * @param out - Where the result goes.
+ */
+void benchGenerator(QTextStream& out) {
+    for (bool oneThread : {true, false}) {
+        Generator small(Level::DEFAULT_WIDTH, Level::DEFAULT_HEIGHT);
+        small.setSeed(1);
+        if (oneThread)
+            small.setThreadCount(1);
+        benchGeneratorRun(out, small, "12x8", 2000);
+
+        Generator large(64, 48);
+        large.setSeed(1);
+        large.setInputCount(10);
+        if (oneThread)
+            large.setThreadCount(1);
+        benchGeneratorRun(out, large, "64x48 with 10 inputs", 200);
+    }
+}
+
+/**
+ * @brief shiftLayout - Builds a board of shift registers, one every three rows. Each starts with
+ * a slow CLOCK gate feeding its first DFF, and every DFF is clocked by a fast CLOCK gate of its
+ * own above the lane. The clocks of neighboring DFFs have different tags, so the two wires going
+ * into each DFF never share one.
+ * @param width - The width of the board.
+ * @param height - The height of the board.
+ * @return The layout.
+ */
+LevelPack::Layout shiftLayout(int width, int height) {
+    LevelPack::Layout layout{width, height, {}};
+    const char* clockTags[] = {"B", "C"};
+    for (int y = 1; y + 1 < height; y += 3) {
+        LevelPack::Record root{LevelPack::Kind::ROOT, 0, y};
+        root.signal = true;
+        root.tag = Tag::fromString("A");
+        LevelPack::Record data{LevelPack::Kind::GATE, 2, y};
+        data.op = Gate::Operator::CLOCK;
+        data.direction = Gate::Direction::EAST;
+        data.delay = 7;
+        layout.records << root << data;
+        for (int x = 7, stage = 0; x < width; x += 5, stage++) {
+            LevelPack::Record enable{LevelPack::Kind::ROOT, x - 4, y - 1};
+            enable.signal = true;
+            enable.tag = Tag::fromString(clockTags[stage % 2]);
+            LevelPack::Record clock{LevelPack::Kind::GATE, x - 2, y - 1};
+            clock.op = Gate::Operator::CLOCK;
+            clock.direction = Gate::Direction::EAST;
+            clock.delay = 1;
+            LevelPack::Record flipFlop{LevelPack::Kind::GATE, x, y};
+            flipFlop.op = Gate::Operator::DFF;
+            flipFlop.direction = Gate::Direction::EAST;
+            layout.records << enable << clock << flipFlop;
+        }
+    }
+    return layout;
+}
+
+/**
+ * @brief routeShift - Wires every register of a shiftLayout board, clocks first so each DFF
+ * output carries its clock's tag before the next data wire is routed from it.
+ * @param level - The level holding the layout.
+ * @return The number of DFFs wired.
+ */
+int routeShift(Level& level) {
+    int wired = 0;
+    for (int y = 1; y + 1 < level.getHeight(); y += 3) {
+        level.routeWire(0, y, 2, y, Tag::fromString("A"));
+        for (int x = 7; x < level.getWidth(); x += 5) {
+            Tag clockTag = level.getNode(x - 4, y - 1)->getTag();
+            level.routeWire(x - 4, y - 1, x - 2, y - 1, clockTag);
+            level.routeWire(x - 2, y - 1, x, y - 1, level.getGate(x - 2, y - 1)->getTag());
+        }
+        for (int x = 7; x < level.getWidth(); x += 5) {
+            if (level.routeWire(x - 5, y, x, y, level.getGate(x - 5, y)->getTag()))
+                wired++;
+        }
+    }
+    return wired;
+}
+
+/**
+ * @brief benchSimulator - Runs the shift registers of a 256x256 shiftLayout board for a fixed
+ * number of ticks and reports the rate of gate events. Every fast clock toggles each tick and
+ * shifts its DFF on every other one, so the board stays busy the whole run.
+ * @param out - Where the result goes.
+ */
+void benchSimulator(QTextStream& out) {
+    const int size = 256;
+    const qint64 ticks = 4096;
+    LevelPack::Layout layout = shiftLayout(size, size);
+    Level level(nullptr, nullptr, nullptr, size, size);
+    level.loadLayout(layout);
+    int flipFlops = routeShift(level);
+    Simulator simulator;
+    simulator.compile(&level);
+    qint64 best = -1;
+    qint64 events = 0;
+    for (int round = 0; round < ROUNDS; round++) {
+        simulator.reset();
+        QElapsedTimer timer;
+        timer.start();
+        simulator.advance(ticks);
+        qint64 elapsed = timer.nsecsElapsed();
+        if (best < 0 || elapsed < best)
+            best = elapsed;
+        events = simulator.getEventCount();
+    }
+    out << "simulator: " << flipFlops << " DFFs and " << simulator.getGateCount()
+        << " gates for " << ticks << " ticks, " << events << " events, "
+        << qint64(events * 1e9 / qMax(best, qint64(1))) << " events/s\n";
+}
+
+/**
+ * @brief Benchmark - A benchmark and the name it is run by.
+ */
+struct Benchmark {
+    const char* name;
+    void (*run)(QTextStream& out);
+};
+
+const Benchmark BENCHMARKS[] = {
+    {"clearwires", benchClearWires},
+    {"drawwire", benchDrawWire},
+    {"generator", benchGenerator},
+    {"neighbors", benchNeighbors},
+    {"simulator", benchSimulator},
+};
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QStringList known;
+    for (const Benchmark& benchmark : BENCHMARKS)
+        known.append(QString::fromLatin1(benchmark.name));
+    QStringList names;
+    for (int i = 1; i < argc; i++) {
+        names.append(QString::fromLocal8Bit(argv[i]));
+        if (!known.contains(names.last())) {
+            err << "usage: benchmarks [" << known.join(" | ") << "]...\n";
+            return 2;
+        }
+    }
+
+    for (const Benchmark& benchmark : BENCHMARKS) {
+        if (names.isEmpty() || names.contains(QString::fromLatin1(benchmark.name))) {
+            benchmark.run(out);
+            out.flush();
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+QT       += core gui widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+# Times the game's hot paths on headless levels. Build it in release mode and run it with the
+# names of the benchmarks to run, or none to run them all:
+#   benchmarks clearwires drawwire generator neighbors simulator
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    $$files(../../Box2D/*.cpp, true) \
+    ../../bus.cpp \
+    ../../cellgrid.cpp \
+    ../../confettieffect.cpp \
+    ../../cycledetector.cpp \
+    ../../gate.cpp \
+    ../../gatekernels.cpp \
+    ../../generator.cpp \
+    ../../journal.cpp \
+    ../../level.cpp \
+    ../../levelpack.cpp \
+    ../../netlist.cpp \
+    ../../node.cpp \
+    ../../obstaclelayer.cpp \
+    ../../propagator.cpp \
+    ../../router.cpp \
+    ../../simulator.cpp \
+    ../../solver.cpp \
+    ../../tag.cpp \
+    ../../wire.cpp \
+    ../../wirepool.cpp \
+    benchmarks.cpp
+
+HEADERS += \
+    ../../bus.h \
+    ../../cellgrid.h \
+    ../../confettieffect.h \
+    ../../cycledetector.h \
+    ../../gate.h \
+    ../../gatekernels.h \
+    ../../generator.h \
+    ../../journal.h \
+    ../../level.h \
+    ../../levelpack.h \
+    ../../netlist.h \
+    ../../node.h \
+    ../../obstaclelayer.h \
+    ../../propagator.h \
+    ../../router.h \
+    ../../simulator.h \
+    ../../solver.h \
+    ../../tag.h \
+    ../../wire.h \
+    ../../wirepool.h
@@ -0,0 +1,176 @@
+#include "levelpack.h"
+#include <QCoreApplication>
+#include <QTextStream>
+
+namespace {
+
+// Every built-in level is laid out on a 12x8 board.
+const int WIDTH = 12;
+const int HEIGHT = 8;
+
+/**
+ * @brief Builder - Collects the setup calls of one level, in the same form Level makes them.
+ */
+struct Builder {
+    LevelPack::Layout layout{WIDTH, HEIGHT, {}};
+
+    void setNode(int x, int y, Bus signal, const QString& tag, Node::Type type) {
+        LevelPack::Record node{type == Node::Type::ROOT ? LevelPack::Kind::ROOT
+                                                        : LevelPack::Kind::END, x, y};
+        node.signal = signal;
+        node.tag = Tag::fromString(tag);
+        layout.records.append(node);
+    }
+
+    void drawGate(int x, int y, Gate::Operator op, Gate::Direction dir) {
+        LevelPack::Record gate{LevelPack::Kind::GATE, x, y};
+        gate.op = op;
+        gate.direction = dir;
+        layout.records.append(gate);
+    }
+
+    void addObstacle(int x, int y) {
+        addObstacleRect(x, y, 1, 1);
+    }
+
+    void addObstacleRect(int x, int y, int width, int height) {
+        LevelPack::Record obstacles{LevelPack::Kind::OBSTACLES, x, y};
+        obstacles.width = width;
+        obstacles.height = height;
+        layout.records.append(obstacles);
+    }
+
+    void placeBorder() {
+        layout.records.append(LevelPack::Record{LevelPack::Kind::BORDER, 0, 0});
+    }
+};
+
+// The layouts below were the levelSetup switch of Level. Index 0 is the default layout used
+// for level numbers the pack doesn't hold.
+LevelPack::Layout builtInLevel(int levelNum) {
+    Builder level;
+    switch (levelNum) {
+    case 1:
+        level.setNode(2, 2, true, "A", Node::Type::ROOT);
+        level.setNode(2, 5, true, "B", Node::Type::ROOT);
+        level.placeBorder();
+
+        //Bottom and Top lines:
+        level.addObstacleRect(3, 2, 6, 1);
+        level.addObstacleRect(3, 5, 6, 1);
+        level.addObstacle(9, 5);
+        level.addObstacle(7, 3);
+        level.addObstacle(8, 3);
+        level.drawGate(6, 4, Gate::Operator::AND, Gate::Direction::EAST);
+        level.setNode(9, 2, true, "AB", Node::Type::END);
+        break;
+    case 2:
+        level.setNode(2, 2, false, "A", Node::Type::ROOT);
+        level.drawGate(4, 3, Gate::Operator::NOT, Gate::Direction::SOUTH);
+        level.setNode(2, 5, true, "B", Node::Type::ROOT);
+        level.placeBorder();
+
+        //Top and bottom rows:
+        level.addObstacleRect(7, 2, 3, 1);
+        level.addObstacleRect(7, 5, 3, 1);
+        level.addObstacle(8,3);
+        level.drawGate(7, 4, Gate::Operator::AND, Gate::Direction::EAST);
+        level.setNode(9, 3, true, "AB", Node::Type::END);
+        break;
+    case 3:
+        // Top Row
+        level.addObstacleRect(0, 0, 12, 2);
+
+        // Left Side
+        level.addObstacleRect(0, 0, 2, 8);
+
+        // Right side
+        level.addObstacleRect(10, 0, 2, 8);
+
+        // Bottom side
+        level.addObstacleRect(0, 7, 12, 1);
+        level.addObstacle(8, 5);
+        level.addObstacle(8, 6);
+        level.addObstacle(8, 4);
+        level.addObstacle(8, 7);
+        level.addObstacle(2, 2);
+        level.addObstacle(3, 2);
+        level.setNode(6, 6, false, "B", Node::Type::ROOT);
+        level.setNode(9, 2, false, "A", Node::Type::ROOT);
+        level.setNode(9, 6, true, "AB", Node::Type::END);
+        level.drawGate(3, 5, Gate::Operator::OR, Gate::Direction::EAST);
+        level.drawGate(7, 5, Gate::Operator::NOT, Gate::Direction::NORTH);
+        break;
+    case 4:
+        level.placeBorder();
+        level.addObstacleRect(9, 2, 1, 4);
+        level.setNode(5, 2, false, "A", Node::Type::ROOT);
+        level.setNode(6, 2, false, "B", Node::Type::ROOT);
+        level.setNode(4, 4, false, "C", Node::Type::ROOT);
+        level.setNode(7, 3, true, "ABC", Node::Type::END);
+        level.drawGate(2, 4, Gate::Operator::OR, Gate::Direction::SOUTH);
+        level.drawGate(7, 5, Gate::Operator::OR, Gate::Direction::EAST);
+        level.drawGate(8, 3, Gate::Operator::NOT, Gate::Direction::NORTH);
+        break;
+    case 5:
+        level.setNode(0, 0, false, "A", Node::Type::ROOT);
+        level.setNode(0, 3, true, "B", Node::Type::ROOT);
+        level.setNode(3, 1, true, "C", Node::Type::ROOT);
+        level.setNode(4, 1, false, "D", Node::Type::ROOT);
+        level.setNode(1, 7, true, "E", Node::Type::ROOT);
+        level.drawGate(1, 2, Gate::Operator::NOT, Gate::Direction::EAST);
+        level.drawGate(1, 5, Gate::Operator::OR, Gate::Direction::SOUTH);
+        level.addObstacle(3,5);
+        level.addObstacle(3,6);
+        level.drawGate(6, 1, Gate::Operator::OR, Gate::Direction::EAST);
+        level.drawGate(5, 4, Gate::Operator::AND, Gate::Direction::EAST);
+        level.setNode(6, 3, true, "F", Node::Type::ROOT);
+        level.drawGate(5, 7, Gate::Operator::AND, Gate::Direction::EAST);
+        level.drawGate(8, 7, Gate::Operator::NOT, Gate::Direction::EAST);
+        level.setNode(9, 1, false, "G", Node::Type::ROOT);
+        level.drawGate(8, 3, Gate::Operator::AND, Gate::Direction::SOUTH);
+        level.drawGate(9, 4, Gate::Operator::NOT, Gate::Direction::EAST);
+        level.drawGate(10, 6, Gate::Operator::AND, Gate::Direction::SOUTH);
+        level.setNode(11, 7, true, "ABCDEFG", Node::Type::END);
+        level.addObstacle(6,6);
+        level.addObstacle(7,6);
+        level.addObstacle(7,5);
+        level.addObstacle(8,5);
+        level.addObstacle(7,4);
+        level.addObstacle(7,3);
+        level.addObstacle(7,2);
+        level.addObstacle(10,1);
+        break;
+    default:
+        level.setNode(0, 3, true, "A", Node::Type::ROOT);
+        level.setNode(0, 5, false, "B", Node::Type::ROOT);
+        level.setNode(8, 3, true, "AB", Node::Type::END);
+        level.addObstacle(0, 0);
+        level.drawGate(6, 4, Gate::Operator::AND, Gate::Direction::EAST);
+        level.drawGate(7, 1, Gate::Operator::OR, Gate::Direction::SOUTH);
+        level.drawGate(8, 7, Gate::Operator::NOT, Gate::Direction::EAST);
+        break;
+    }
+    return level.layout;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QTextStream err(stderr);
+    if (argc != 2) {
+        err << "usage: levelpacker <output.pack>\n";
+        return 2;
+    }
+
+    QVector<LevelPack::Layout> layouts;
+    for (int levelNum = 0; levelNum <= 5; levelNum++)
+        layouts.append(builtInLevel(levelNum));
+    if (!LevelPack::write(QString::fromLocal8Bit(argv[1]), layouts)) {
+        err << "levelpacker: could not write " << argv[1] << "\n";
+        return 1;
+    }
+    return 0;
+}
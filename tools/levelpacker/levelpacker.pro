@@ -0,0 +1,19 @@
+QT       += core
+QT       -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+# Writes levels.pack, the level pack the game ships in. Run it from the repository root:
+#   levelpacker levels.pack
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../levelpack.cpp \
+    ../../tag.cpp \
+    levelpacker.cpp
+
+HEADERS += \
+    ../../levelpack.h \
+    ../../tag.h
@@ -1,54 +1,118 @@
 #include "wire.h"
+#include "wirepool.h"
 
-class Node;
-
-Wire::Wire(QObject *parent)
-    : QObject{parent}
+Wire::Wire()
+    : pool(nullptr), x(0), y(0), id(NULL_ID)
 {
-    headConnection = nullptr;
-    tailConnection = nullptr;
+    headConnection = NULL_ID;
+    tailConnection = NULL_ID;
+    branchConnections[0] = NULL_ID;
+    branchConnections[1] = NULL_ID;
+    branchCount = 0;
     direction = Direction::NONE;
+    owner = Owner::BOARD;
     signal = true;
-    tag = "";
 }
 
-Wire::~Wire() {
+Wire::Id Wire::getId() {
+    return id;
+}
+
+WirePool* Wire::getPool() {
+    return pool;
+}
+
+Wire::Owner Wire::getOwner() {
+    return owner;
 }
 
-bool Wire::getSignal() {
+void Wire::setOwner(Owner newOwner) {
+    touch();
+    owner = newOwner;
+}
+
+Bus Wire::getSignal() {
     return signal;
 }
 
-void Wire::setSignal(bool newSignal) {
+void Wire::setSignal(const Bus& newSignal) {
+    touch();
     signal = newSignal;
 }
 
-QString Wire::getTag() {
+Tag Wire::getTag() {
     return tag;
 }
 
-void Wire::setTag(QString newTag) {
+void Wire::setTag(Tag newTag) {
+    touch();
     tag = newTag;
 }
 
 bool Wire::isFullyConnected() {
-    return (getHeadConnection() != nullptr && getTailConnection() != nullptr);
+    return (headConnection != NULL_ID && tailConnection != NULL_ID);
 }
 
 Wire* Wire::getHeadConnection() {
-    return headConnection;
+    return pool->get(headConnection);
 }
 
 void Wire::setHeadConnection(Wire* newWire) {
-    headConnection = newWire;
+    touch();
+    headConnection = newWire ? newWire->id : NULL_ID;
 }
 
 Wire* Wire::getTailConnection() {
-    return tailConnection;
+    return pool->get(tailConnection);
 }
 
 void Wire::setTailConnection(Wire* newWire) {
-    tailConnection = newWire;
+    touch();
+    tailConnection = newWire ? newWire->id : NULL_ID;
+}
+
+int Wire::getBranchCount() {
+    return branchCount;
+}
+
+Wire* Wire::getBranchConnection(int index) {
+    return pool->get(branchConnections[index]);
+}
+
+Wire::Direction Wire::getBranchDirection(int index) {
+    return sideOf(getBranchConnection(index));
+}
+
+void Wire::replaceTail(Wire* oldConnection, Wire* newConnection) {
+    Id oldId = oldConnection ? oldConnection->id : NULL_ID;
+    Id newId = newConnection ? newConnection->id : NULL_ID;
+    for (int i = 0; i < branchCount; i++) {
+        if (branchConnections[i] != oldId)
+            continue;
+        touch();
+        if (newConnection)
+            branchConnections[i] = newId;
+        else {
+            branchConnections[i] = branchConnections[branchCount - 1];
+            branchConnections[--branchCount] = NULL_ID;
+        }
+        return;
+    }
+    if (tailConnection != oldId)
+        return;
+    if (newConnection || branchCount == 0) {
+        setTailConnection(newConnection);
+        if (newConnection == nullptr)
+            pointAtHead();
+        return;
+    }
+
+    // The last branch becomes the tail, and the wire is redrawn towards it.
+    touch();
+    tailConnection = branchConnections[--branchCount];
+    branchConnections[branchCount] = NULL_ID;
+    Wire* promoted = getTailConnection();
+    wireDualDirector(promoted->sideOf(this));
 }
 
 Wire::Direction Wire::getDirection() {
@@ -56,6 +120,7 @@ Wire::Direction Wire::getDirection() {
 }
 
 void Wire::setDirection(Wire::Direction newDirection) {
+    touch();
     direction = newDirection;
 }
 
@@ -68,6 +133,7 @@ int Wire::getY() {
 }
 
 void Wire::setPosition(int x, int y) {
+    touch();
     this->x = x;
     this->y = y;
 }
@@ -83,9 +149,41 @@ void Wire::connectTail(Wire* connectWire, Wire::Direction connectionDirection) {
     wireDualDirector(connectionDirection);
 }
 
+void Wire::connectBranch(Wire* connectWire, Wire::Direction connectionDirection) {
+    if (connectWire == nullptr || branchCount >= MAX_BRANCHES)
+        return;
+    connectWire->setDirection(connectionDirection);
+    connectWire->setTag(tag);
+    connectWire->setSignal(signal);
+    touch();
+    branchConnections[branchCount++] = connectWire->id;
+    connectWire->setHeadConnection(this);
+}
+
+void Wire::pointAtHead() {
+    Wire* headConnection = getHeadConnection();
+    if (headConnection == nullptr || headConnection == this)
+        return;
+    touch();
+    if (y - headConnection->getY() == 1) {
+        direction = Wire::Direction::N;
+    }
+    else if (headConnection->getX() - x == 1) {
+        direction = Wire::Direction::E;
+    }
+    else if (headConnection->getY() - y == 1) {
+        direction = Wire::Direction::S;
+    }
+    else if (x - headConnection->getX() == 1) {
+        direction = Wire::Direction::W;
+    }
+}
+
 void Wire::wireDualDirector(Wire::Direction connectionDirection) {
+    Wire* headConnection = getHeadConnection();
     if (headConnection == nullptr)
         return;
+    touch();
     switch(connectionDirection) {
     case Wire::Direction::N :
         // Draw NS Corner
@@ -166,3 +264,22 @@ void Wire::wireDualDirector(Wire::Direction connectionDirection) {
     default : break;
     }
 }
+
+Wire::Direction Wire::sideOf(Wire* other) {
+    if (other == nullptr)
+        return Wire::Direction::NONE;
+    if (other->getY() - y == -1 && other->getX() == x)
+        return Wire::Direction::N;
+    if (other->getX() - x == 1 && other->getY() == y)
+        return Wire::Direction::E;
+    if (other->getY() - y == 1 && other->getX() == x)
+        return Wire::Direction::S;
+    if (other->getX() - x == -1 && other->getY() == y)
+        return Wire::Direction::W;
+    return Wire::Direction::NONE;
+}
+
+void Wire::touch() {
+    if (pool)
+        pool->noteChange(this);
+}
@@ -1,6 +1,9 @@
 /**
  * This class represents a single wire square.
- * A wire is a grid component.
+ * A wire is a grid component. Wires are plain records owned by a
+ * WirePool and refer to their neighbours by pool id. A wire has one head
+ * and one tail, and a board wire can also fan out to up to two branches,
+ * which makes it a junction sending its signal down several tails.
  *
  * @authors Max Donaldson, Jason Khong,
  * Ariadne Petroulakis, Evan Tucker, and Ian Weller
@@ -11,7 +14,11 @@
 #ifndef WIRE_H
 #define WIRE_H
 
-#include <QObject>
+#include <QtGlobal>
+#include "bus.h"
+#include "tag.h"
+
+class WirePool;
 
 /**
  * @brief The Direction enum should hold the direction
@@ -26,35 +33,78 @@
  * The first letter represents the vertical half and the
  * second represnts the horizontal half.
  */
-class Wire : public QObject {
+class Wire {
 
 public:
-    enum class Direction {
+    enum class Direction : quint8 {
         NONE, NS, EW, NW, NE, SW, SE, N, S, E, W
     };
 
     /**
-     * @brief Wire - Creates a wire object.
-     * @param parent - The parent object for the QObject default constructor.
+     * @brief The Owner enum - Who is responsible for a wire. BOARD wires are drawn on the grid
+     * and belong to the level; NODE wires back a Node and live as long as it does.
+     */
+    enum class Owner : quint8 {
+        BOARD, NODE
+    };
+
+    /**
+     * @brief Id - A stable handle to a wire in its pool.
+     */
+    using Id = quint32;
+
+    /**
+     * @brief NULL_ID - The id of no wire.
+     */
+    static const Id NULL_ID = 0xFFFFFFFF;
+
+    /**
+     * @brief MAX_BRANCHES - The most branches a junction can have. With its head and tail they
+     * take up all four sides of the square.
+     */
+    static const int MAX_BRANCHES = 2;
+
+    /**
+     * @brief getId - Getter for this wire's handle in its pool.
+     * @return The id of the wire.
+     */
+    Id getId();
+
+    /**
+     * @brief getPool - Getter for the pool holding this wire.
+     * @return A pointer to the owning pool.
+     */
+    WirePool* getPool();
+
+    /**
+     * @brief Wire - Creates a blank wire record that belongs to no pool. Live wires are only
+     * handed out by a WirePool.
      */
-    explicit Wire(QObject *parent = nullptr);
+    Wire();
 
     /**
-     * Destructor for the Wire class.
+     * @brief getOwner - Getter for who is responsible for this wire.
+     * @return The Wire::Owner of the wire.
      */
-    ~Wire();
+    Owner getOwner();
+
+    /**
+     * @brief setOwner - Setter method for who is responsible for this wire.
+     * @param newOwner - The new Wire::Owner.
+     */
+    void setOwner(Owner newOwner);
 
     /**
      * @brief getTag - Returns the tag being transfered within this wire.
-     * @return The QString stored in the wire for the tag.
+     * @return The Tag stored in the wire.
      */
-    QString getTag();
+    Tag getTag();
 
     /**
-     * @brief setTag - Alters the internal tag to the specified QString.
-     * @param newTag - The QString to set the backing tag to.
+     * @brief setTag - Alters the internal tag to the specified Tag.
+     * @param newTag - The Tag to set the backing tag to.
      */
-    void setTag(QString newTag);
+    void setTag(Tag newTag);
 
     /**
      * @brief isFullyConnected - Checks to see if the wire is connected to another component
@@ -91,6 +141,36 @@ public:
      */
     void setTailConnection(Wire* newConnection);
 
+    /**
+     * @brief getBranchCount - Getter for the number of branches fanning out of this wire.
+     * @return 0 for an ordinary wire, up to MAX_BRANCHES for a junction.
+     */
+    int getBranchCount();
+
+    /**
+     * @brief getBranchConnection - Returns one of the extra tails of a junction. The head
+     * connection of a branch is a pointer to this Wire, like for the tail.
+     * @param index - The branch index, below getBranchCount().
+     * @return The pointer to the branch wire.
+     */
+    Wire* getBranchConnection(int index);
+
+    /**
+     * @brief getBranchDirection - Gets which side of this wire's square a branch leaves from.
+     * @param index - The branch index, below getBranchCount().
+     * @return N, E, S or W.
+     */
+    Direction getBranchDirection(int index);
+
+    /**
+     * @brief replaceTail - Swaps the tail or branch pointing at a wire for another. Taking a tail
+     * away with nullptr promotes a branch in its place, so only wires without a tail are open
+     * ends; a wire left with no tail at all points back at its head.
+     * @param oldConnection - The tail or branch to replace.
+     * @param newConnection - The wire to put in its place, or nullptr to take it away.
+     */
+    void replaceTail(Wire* oldConnection, Wire* newConnection);
+
     /**
      * @brief getDirection - Returns the directions this wire is connected to. If there is only
      * one connection, i.e the tail connection is null, then there is only one direction pointing
@@ -126,16 +206,17 @@ public:
     void setPosition(int x, int y);
 
     /**
-     * @brief getSignal - Gets the signal transfered by the wire, either true or false.
-     * @return The bool value of signal.
+     * @brief getSignal - Gets the signal transfered by the wire, one lane for ordinary wires
+     * or several for a bus.
+     * @return The signal.
      */
-    bool getSignal();
+    Bus getSignal();
 
     /**
      * @brief setSignal - Setter method for the signal transferred in the wire.
-     * @param newSignal - A bool for the new backing signal.
+     * @param newSignal - The new backing signal.
      */
-    void setSignal(bool newSignal);
+    void setSignal(const Bus& newSignal);
 
     /**
      * @brief connectTail - Connects the current wire to another wire pointer. The specified wire
@@ -146,11 +227,34 @@ public:
      */
     void connectTail(Wire* connectWire, Wire::Direction connectionDirection = Wire::Direction::NONE);
 
+    /**
+     * @brief connectBranch - Connects another wire pointer as an extra tail of this fully
+     * connected wire, turning it into a junction. Its own direction is left alone and the
+     * branch is drawn on top.
+     * @param connectWire - The wire pointer to link to.
+     * @param connectionDirection - The Wire::Direction directing where this wire is relative to
+     * the branch, like for connectTail.
+     */
+    void connectBranch(Wire* connectWire, Wire::Direction connectionDirection);
+
+    /**
+     * @brief pointAtHead - Resets the direction to a single plug facing the head wire. Used when
+     * the tail of this wire has been taken away.
+     */
+    void pointAtHead();
+
 private:
+    friend class WirePool;
+
+    /**
+     * @brief pool - The pool that owns this wire and resolves its connections.
+     */
+    WirePool* pool;
+
     /**
      * @brief tag - Represents the wire ID that this wire is a part of.
      */
-    QString tag;
+    Tag tag;
 
     /**
      * @brief x - The x position on the grid.
@@ -163,25 +267,46 @@ private:
     int y;
 
     /**
-     * @brief headConnection - A pointer for the wire of the head.
+     * @brief id - This wire's handle in its pool.
+     */
+    Id id;
+
+    /**
+     * @brief headConnection - The id of the wire of the head.
+     */
+    Id headConnection;
+
+    /**
+     * @brief headConnection - The id of the wire of the tail.
      */
-    Wire* headConnection;
+    Id tailConnection;
 
     /**
-     * @brief headConnection - A pointer for the wire of the tail.
+     * @brief branchConnections - The ids of the extra tails of a junction, in the order they
+     * were connected.
      */
-    Wire* tailConnection;
+    Id branchConnections[MAX_BRANCHES];
+
+    /**
+     * @brief branchCount - The number of branchConnections in use.
+     */
+    quint8 branchCount;
 
     /**
      * @brief direction - The Wire::Direction of the connections this wire points to.
      */
     Direction direction;
 
+    /**
+     * @brief owner - Who is responsible for releasing this wire.
+     */
+    Owner owner;
+
     /**
      * @brief signal - The signal value of a wire (i.e. if the wire has
-     * been hit with a NOT block).
+     * been hit with a NOT block). Bus wires carry one value per lane.
      */
-    bool signal;
+    Bus signal;
 
     /**
      * @brief wireDualDirector - Helper method for setting the direction whenever this wire
@@ -190,6 +315,18 @@ private:
      * connectionDirection from the connectTails method.
      */
     void wireDualDirector(Wire::Direction connectionDirection);
+
+    /**
+     * @brief sideOf - Gets which side of this wire's square a neighbouring wire is on.
+     * @param other - A wire on one of the four squares next to this one.
+     * @return N, E, S or W, or NONE if the wire isn't next to this one.
+     */
+    Direction sideOf(Wire* other);
+
+    /**
+     * @brief touch - Lets the pool log this wire's state before it is changed.
+     */
+    void touch();
 };
 
 #endif // WIRE_H
@@ -0,0 +1,48 @@
+#include "wirepool.h"
+#include "journal.h"
+
+WirePool::WirePool()
+    : nextId(0), journal(nullptr) {
+}
+
+WirePool::~WirePool() {
+    for (Wire* slab : slabs)
+        delete[] slab;
+}
+
+Wire::Id WirePool::allocate() {
+    Wire::Id id;
+    if (!freeIds.isEmpty()) {
+        id = freeIds.last();
+        freeIds.removeLast();
+    }
+    else {
+        id = nextId++;
+        if (id / SLAB_SIZE >= static_cast<Wire::Id>(slabs.size()))
+            slabs.append(new Wire[SLAB_SIZE]);
+    }
+    Wire* wire = get(id);
+    *wire = Wire();
+    wire->pool = this;
+    wire->id = id;
+    return id;
+}
+
+void WirePool::release(Wire::Id id) {
+    if (id == Wire::NULL_ID)
+        return;
+    get(id)->pool = nullptr;
+    freeIds.append(id);
+}
+
+int WirePool::getLiveCount() const {
+    return static_cast<int>(nextId) - freeIds.size();
+}
+
+void WirePool::setJournal(Journal* newJournal) {
+    journal = newJournal;
+}
+
+void WirePool::recordChange(Wire* wire) {
+    journal->recordWire(wire);
+}
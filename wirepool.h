@@ -0,0 +1,116 @@
+/**
+ * This class stores the wire records of a level. Wires are kept in
+ * fixed-size slabs so their addresses never move, and removed wires
+ * go onto a free list so drawing and erasing reuse the same records
+ * instead of going through the heap.
+ *
+ * @authors Max Donaldson, Jason Khong,
+ * Ariadne Petroulakis, Evan Tucker, and Ian Weller
+ *
+ * @version 22 April 2025
+ */
+
+#ifndef WIREPOOL_H
+#define WIREPOOL_H
+
+#include <QVector>
+#include "wire.h"
+
+class Journal;
+
+class WirePool {
+
+public:
+    /**
+     * @brief SLAB_SIZE - The number of wire records allocated at a time.
+     */
+    static const int SLAB_SIZE = 256;
+
+    /**
+     * @brief WirePool - Creates an empty pool. No slabs are allocated.
+     */
+    WirePool();
+
+    /**
+     * Destructor for the WirePool class.
+     */
+    ~WirePool();
+
+    WirePool(const WirePool&) = delete;
+    WirePool& operator=(const WirePool&) = delete;
+
+    /**
+     * @brief allocate - Hands out a blank wire record, reusing a released one if possible.
+     * @return The id of the new wire.
+     */
+    Wire::Id allocate();
+
+    /**
+     * @brief release - Returns a wire record to the pool. The id may be handed out again.
+     * @param id - The id of the wire to release. Wire::NULL_ID is ignored.
+     */
+    void release(Wire::Id id);
+
+    /**
+     * @brief get - Looks up a wire record.
+     * @param id - The id of the wire.
+     * @return A pointer to the wire, or nullptr for Wire::NULL_ID. The pointer stays valid
+     * until the wire is released.
+     */
+    Wire* get(Wire::Id id) {
+        if (id == Wire::NULL_ID)
+            return nullptr;
+        return &slabs[id / SLAB_SIZE][id % SLAB_SIZE];
+    }
+
+    /**
+     * @brief getLiveCount - Getter for the number of wires currently handed out.
+     * @return The live wire count.
+     */
+    int getLiveCount() const;
+
+    /**
+     * @brief setJournal - Sets the journal told about every wire change. Set while a
+     * transaction is open and cleared afterwards.
+     * @param newJournal - The journal to notify, or nullptr to stop.
+     */
+    void setJournal(Journal* newJournal);
+
+    /**
+     * @brief noteChange - Tells the journal, if any, that a wire is about to change.
+     * @param wire - The wire about to change.
+     */
+    void noteChange(Wire* wire) {
+        if (journal)
+            recordChange(wire);
+    }
+
+private:
+    /**
+     * @brief slabs - The SLAB_SIZE blocks of wire records, in id order.
+     */
+    QVector<Wire*> slabs;
+
+    /**
+     * @brief freeIds - Released ids waiting to be handed out again.
+     */
+    QVector<Wire::Id> freeIds;
+
+    /**
+     * @brief nextId - The first id that has never been handed out.
+     */
+    Wire::Id nextId;
+
+    /**
+     * @brief journal - The journal recording wire changes, or nullptr.
+     */
+    Journal* journal;
+
+    /**
+     * @brief recordChange - Passes a wire change on to the journal.
+     * @param wire - The wire about to change.
+     */
+    void recordChange(Wire* wire);
+};
+
+#endif // WIREPOOL_H